@@ -0,0 +1,129 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <optional>
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "image.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	struct AliasingPlacement {
+		u32 memory_index = 0;
+		usize offset = 0;
+		usize size = 0;
+	};
+
+	/*
+	* Result of gx::AliasingPlanner::build(). Owns the shared memory, the resources stay owned by the caller
+	* and must be destroyed before the plan.
+	*/
+	class AliasingPlan {
+		friend class AliasingPlanner;
+
+	private:
+		struct PassBarriers {
+			u32 pass = 0;
+			// Set if a resource starting in the pass takes over memory, the writes of every earlier occupant are covered
+			bool has_memory_barrier = false;
+			std::vector<VkImageMemoryBarrier> images;
+			std::vector<VkBufferMemoryBarrier> buffers;
+		};
+
+		std::vector<OwnedAllocation> memory_;
+		std::vector<AliasingPlacement> placements_;
+		std::vector<PassBarriers> barriers_;
+		usize unaliased_bytes_ = 0;
+		usize aliased_bytes_ = 0;
+
+	public:
+		AliasingPlan() noexcept = default;
+
+		AliasingPlan(AliasingPlan&&) noexcept = default;
+		AliasingPlan& operator=(AliasingPlan&&) noexcept = default;
+
+		/*
+		* Records the barriers needed before the resources first used in pass start using their memory. Every image
+		* is transitioned from ImageLayout::eUndefined to the layout it was declared with. Resources sharing memory
+		* with others also get a memory barrier against the writes of the earlier occupants, including the last ones
+		* of the previous frame. Call it for every pass of every frame.
+		*/
+		void record_barriers(VkCommandBuffer cmd, u32 pass) const noexcept;
+
+		[[nodiscard]]
+		const AliasingPlacement& get_placement(u32 resource) const noexcept {
+			return placements_[resource];
+		}
+
+		[[nodiscard]]
+		usize get_unaliased_bytes() const noexcept {
+			return unaliased_bytes_;
+		}
+
+		[[nodiscard]]
+		usize get_aliased_bytes() const noexcept {
+			return aliased_bytes_;
+		}
+	};
+
+	/*
+	* Packs transient images and buffers with disjoint [first_pass, last_pass] lifetimes into shared memory.
+	* Resources are placed largest first; each one goes to the lowest offset of an existing memory block
+	* that doesn't overlap anything alive at the same time, or opens a new block.
+	*/
+	class AliasingPlanner {
+	private:
+		struct Resource {
+			VkImage image = VK_NULL_HANDLE;
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkMemoryRequirements reqs{};
+			u32 first_pass = 0;
+			u32 last_pass = 0;
+			ImageLayout layout = ImageLayout::eUndefined;
+			ImageSubresourceRange range;
+		};
+
+		struct MemoryBucket {
+			usize size = 0;
+			usize alignment = 1;
+			u32 memory_type_bits = ~0u;
+			std::vector<u32> resources;
+		};
+
+		Allocator* allocator_ = nullptr;
+		usize granularity_ = 1;
+		std::vector<Resource> resources_;
+
+	public:
+		explicit AliasingPlanner(Allocator& allocator) noexcept;
+
+		/*
+		* image must be created without memory. Returns index of the resource in the plan.
+		*/
+		u32 add_image(ImageView image, u32 first_pass, u32 last_pass, ImageLayout initial_layout, ImageSubresourceRange range = {}) noexcept;
+		u32 add_buffer(BufferView buffer, u32 first_pass, u32 last_pass) noexcept;
+
+		/*
+		* Allocates the shared memory and binds every added resource to it.
+		*/
+		[[nodiscard]]
+		auto build() noexcept -> std::expected<AliasingPlan, ErrorCode>;
+
+	private:
+		[[nodiscard]]
+		std::optional<usize> find_offset_(const MemoryBucket& bucket, u32 resource, std::span<const AliasingPlacement> placements) const noexcept;
+		[[nodiscard]]
+		bool lifetimes_overlap_(u32 lhs, u32 rhs) const noexcept {
+			return resources_[lhs].first_pass <= resources_[rhs].last_pass && resources_[rhs].first_pass <= resources_[lhs].last_pass;
+		}
+	};
+}
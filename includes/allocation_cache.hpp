@@ -0,0 +1,172 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <expected>
+#include <algorithm>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "allocator.hpp"
+#include "thread_cache.hpp"
+
+namespace gx {
+	class ThreadCachedAllocator;
+
+	struct CachedAllocationImpl {
+		template<typename Self>
+		[[nodiscard]]
+		usize get_offset(this Self&& self) noexcept {
+			return self.value_.offset;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		usize get_size(this Self&& self) noexcept {
+			return self.value_.size;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		u32 get_memory_type(this Self&& self) noexcept {
+			return self.value_.memory_type;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		void* get_mapped_ptr(this Self&& self) noexcept {
+			return self.value_.mapped;
+		}
+	};
+
+	/*
+	* handle is the VkDeviceMemory of the slab the slot lives in.
+	*/
+	struct [[nodiscard]] CachedAllocationValue {
+		VkDeviceMemory handle = VK_NULL_HANDLE;
+		ThreadCachedAllocator* parent = nullptr;
+		usize offset = 0;
+		usize size = 0;
+		u8* mapped = nullptr;
+		u32 memory_type = 0;
+		u32 size_class = 0;
+
+		CachedAllocationValue() noexcept = default;
+
+		void destroy() noexcept;
+	};
+	static_assert(Value<CachedAllocationValue>);
+
+	using CachedAllocation = ManagableType<CachedAllocationValue, CachedAllocationImpl>;
+	using CachedAllocationView = decltype(std::declval<CachedAllocation&>().get_view());
+	using OwnedCachedAllocation = OwnedType<CachedAllocationValue, CachedAllocationImpl, MoveOnlyTag, ViewableTag>;
+
+	struct ThreadCacheStats {
+		usize slab_count = 0;
+		usize slab_bytes = 0;
+		// Batches moved between the thread caches and the shared lists, the only operations taking a lock
+		usize refill_count = 0;
+		usize drain_count = 0;
+	};
+
+	/*
+	* Per-thread free lists for small allocations in front of gx::Allocator. Each size class of each memory type
+	* is carved out of slabs of kSlabSlots slots taken from the allocator. A thread allocates and frees from its own
+	* lists without locking and only moves kBatchSize slots at a time from or to the shared lists.
+	* Slabs are given back only with the cache. A thread keeps separate lists for every cache it uses,
+	* the slots it cached go back to each cache's shared lists when it exits.
+	*/
+	class ThreadCachedAllocator {
+		friend CachedAllocationValue;
+
+	public:
+		static constexpr usize kMinCachedSize = 256;
+		static constexpr usize kMaxCachedSize = kb_to_bytes(32);
+		static constexpr u32 kClassCount = 8;
+		static constexpr u32 kSlabSlots = 64;
+		static constexpr u32 kBatchSize = 16;
+
+		struct Slot {
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			usize offset = 0;
+			u8* mapped = nullptr;
+		};
+
+	private:
+		struct SharedClass {
+			std::mutex mutex;
+			std::vector<Slot> slots;
+		};
+
+		// Free lists each thread keeps per cache, handed back to the cache when the thread exits
+		struct ThreadCache;
+		static thread_local details::ThreadCacheMap<ThreadCachedAllocator, ThreadCache> t_caches_;
+
+		Allocator* allocator_ = nullptr;
+		u64 id_ = 0;
+		usize granularity_ = 1;
+
+		std::mutex slabs_mutex_;
+		std::vector<OwnedAllocation> slabs_;
+		std::array<SharedClass, VK_MAX_MEMORY_TYPES * kClassCount> shared_;
+
+		std::atomic<usize> slab_count_ = 0;
+		std::atomic<usize> slab_bytes_ = 0;
+		std::atomic<usize> refill_count_ = 0;
+		std::atomic<usize> drain_count_ = 0;
+
+	public:
+		explicit ThreadCachedAllocator(Allocator& allocator) noexcept;
+		~ThreadCachedAllocator() noexcept;
+
+		ThreadCachedAllocator(const ThreadCachedAllocator&) = delete;
+		ThreadCachedAllocator& operator=(const ThreadCachedAllocator&) = delete;
+		ThreadCachedAllocator(ThreadCachedAllocator&&) = delete;
+		ThreadCachedAllocator& operator=(ThreadCachedAllocator&&) = delete;
+
+		/*
+		* Dedicated, exported and larger than kMaxCachedSize allocations aren't cached, use the Allocator for them.
+		* allocate() and allocate_for_buffer() must only be called for cacheable requests.
+		*/
+		[[nodiscard]]
+		static bool is_cacheable(const AllocationDesc& desc) noexcept {
+			return std::max(desc.size, desc.alignment) <= kMaxCachedSize && !desc.requires_dedicated && desc.export_handle_types == 0;
+		}
+
+		/*
+		* Uses the first memory type of desc.usage, there is no fallback to other types.
+		*/
+		[[nodiscard]]
+		auto allocate(const AllocationDesc& desc) noexcept -> std::expected<CachedAllocation, ErrorCode>;
+
+		[[nodiscard]]
+		auto allocate_for_buffer(VkBuffer buffer, MemoryUsage usage = MemoryUsage::eGpuOnly) noexcept -> std::expected<CachedAllocation, ErrorCode>;
+
+		[[nodiscard]]
+		ThreadCacheStats get_stats() const noexcept;
+
+	private:
+		[[nodiscard]]
+		auto refill_(MemoryUsage usage, u32 memory_type, u32 size_class, std::vector<Slot>& local) noexcept -> std::expected<void, ErrorCode>;
+		void free_(const CachedAllocationValue& allocation) noexcept;
+		void push_shared_(u32 index, std::span<const Slot> slots) noexcept;
+
+		[[nodiscard]]
+		usize get_slot_stride_(u32 size_class) const noexcept {
+			// Slots at least a page of bufferImageGranularity apart can't put a buffer and an image onto the same page
+			return std::max(kMinCachedSize << size_class, granularity_);
+		}
+	};
+
+	inline void CachedAllocationValue::destroy() noexcept {
+		parent->free_(*this);
+	}
+}
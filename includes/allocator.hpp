@@ -0,0 +1,446 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+#include <misc/assert.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "device.hpp"
+
+namespace gx {
+	namespace details {
+		/*
+		* Two-level segregated fit allocator over a set of VkDeviceMemory blocks of one memory type.
+		* Doesn't own device memory and isn't thread safe, gx::Allocator takes care of both.
+		*/
+		class TlsfPool {
+		public:
+			static constexpr u32 kNil = ~0u;
+			static constexpr u32 kSlLog2 = 5;
+			static constexpr u32 kSlCount = 1u << kSlLog2;
+			static constexpr u32 kFlCount = 36;
+			static constexpr usize kMinAlignment = 16;
+
+			struct Block {
+				VkDeviceMemory memory = VK_NULL_HANDLE;
+				usize size = 0;
+				u8* mapped = nullptr;
+				usize used = 0;
+			};
+
+			struct Region {
+				u32 block = kNil;
+				u32 node = kNil;
+				usize offset = 0;
+			};
+
+		private:
+			struct Node {
+				usize offset = 0;
+				usize size = 0;
+				u32 block = kNil;
+				u32 prev_phys = kNil;
+				u32 next_phys = kNil;
+				u32 prev_free = kNil;
+				u32 next_free = kNil;
+				bool is_free = false;
+			};
+
+			u64 fl_bitmap_ = 0;
+			std::array<u32, kFlCount> sl_bitmaps_{};
+			std::array<std::array<u32, kSlCount>, kFlCount> heads_;
+
+			std::vector<Node> nodes_;
+			std::vector<u32> free_nodes_;
+			std::vector<Block> blocks_;
+			std::vector<u32> free_blocks_;
+			usize block_count_ = 0;
+
+		public:
+			TlsfPool() noexcept;
+
+			[[nodiscard]]
+			std::optional<Region> allocate(usize size, usize alignment) noexcept;
+
+			/*
+			* Returns index of the node spanning the whole block if the block became empty.
+			*/
+			[[nodiscard]]
+			std::optional<u32> free(u32 node) noexcept;
+
+			u32 add_block(VkDeviceMemory memory, usize size, u8* mapped) noexcept;
+
+			/*
+			* Takes node returned by TlsfPool::free() and detaches its block from the pool.
+			*/
+			[[nodiscard]]
+			Block remove_block(u32 node) noexcept;
+
+			[[nodiscard]]
+			const Block& get_block(u32 index) const noexcept {
+				return blocks_[index];
+			}
+
+			[[nodiscard]]
+			u32 get_node_block(u32 node) const noexcept {
+				return nodes_[node].block;
+			}
+
+			[[nodiscard]]
+			std::span<const Block> get_blocks() const noexcept {
+				return blocks_;
+			}
+
+			[[nodiscard]]
+			usize get_block_count() const noexcept {
+				return block_count_;
+			}
+
+		private:
+			[[nodiscard]]
+			static std::pair<u32, u32> mapping_(usize size) noexcept;
+			[[nodiscard]]
+			static usize round_up_for_search_(usize size) noexcept;
+
+			[[nodiscard]]
+			u32 find_free_(usize size) const noexcept;
+			void insert_free_(u32 node) noexcept;
+			void remove_free_(u32 node) noexcept;
+
+			[[nodiscard]]
+			u32 split_(u32 node, usize size) noexcept;
+			[[nodiscard]]
+			u32 acquire_node_() noexcept;
+			void release_node_(u32 node) noexcept;
+		};
+	}
+
+	class Allocator;
+
+	struct AllocationImpl {
+		template<typename Self>
+		[[nodiscard]]
+		usize get_offset(this Self&& self) noexcept {
+			return self.value_.offset;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		usize get_size(this Self&& self) noexcept {
+			return self.value_.size;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		u32 get_memory_type(this Self&& self) noexcept {
+			return self.value_.memory_type;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		void* get_mapped_ptr(this Self&& self) noexcept {
+			return self.value_.mapped;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		bool is_dedicated(this Self&& self) noexcept {
+			return self.value_.node == details::TlsfPool::kNil;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		const auto& get_value(this Self&& self) noexcept {
+			return self.value_;
+		}
+	};
+
+	struct [[nodiscard]] AllocationValue {
+		VkDeviceMemory handle = VK_NULL_HANDLE;
+		Allocator* parent = nullptr;
+		usize offset = 0;
+		usize size = 0;
+		u32 memory_type = 0;
+		u32 node = details::TlsfPool::kNil;
+		void* mapped = nullptr;
+
+		AllocationValue() noexcept = default;
+
+		void destroy() noexcept;
+	};
+	static_assert(Value<AllocationValue>);
+
+	using Allocation = ManagableType<AllocationValue, AllocationImpl>;
+	using AllocationView = decltype(std::declval<Allocation&>().get_view());
+	using OwnedAllocation = OwnedType<AllocationValue, AllocationImpl, MoveOnlyTag, ViewableTag>;
+
+	struct AllocatorConfig {
+		usize block_size = mb_to_bytes(64);
+		// TLSF blocks only, dedicated allocations don't count against it
+		usize max_blocks_per_heap = 64;
+		// Fail new device allocations with eOutOfDeviceMemory instead of going over the heap budget
+		bool respect_budget = false;
+		// Allocations larger than this get their own VkDeviceMemory. Capped by a half of the block size of the memory type
+		usize dedicated_threshold = mb_to_bytes(32);
+		// Also give dedicated memory to resources the driver only prefers it for, required ones always get it
+		bool use_dedicated_preference = true;
+		// Allocate all memory with VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, the device must enable DeviceFeature::eBufferDeviceAddress
+		bool use_buffer_device_address = false;
+	};
+
+	struct AllocationDesc {
+		usize size = 0;
+		usize alignment = 1;
+		u32 memory_type_bits = ~0u;
+		MemoryUsage usage = MemoryUsage::eGpuOnly;
+
+		// Filled from VkMemoryDedicatedRequirements by Allocator::allocate_for_image/buffer()
+		bool prefers_dedicated = false;
+		bool requires_dedicated = false;
+		// Resource the memory is dedicated to, at most one of them is set
+		VkImage dedicated_image = VK_NULL_HANDLE;
+		VkBuffer dedicated_buffer = VK_NULL_HANDLE;
+		// Handle types the memory can be exported as with FdInterop, non-zero values force a dedicated allocation
+		ExternalMemoryHandleTypeFlags export_handle_types = 0;
+
+		[[nodiscard]]
+		static AllocationDesc from_vk(const VkMemoryRequirements& reqs, MemoryUsage usage) noexcept {
+			return AllocationDesc {
+				.size = reqs.size,
+				.alignment = reqs.alignment,
+				.memory_type_bits = reqs.memoryTypeBits,
+				.usage = usage,
+			};
+		}
+
+		[[nodiscard]]
+		static AllocationDesc from_vk(const VkMemoryRequirements2& reqs, const VkMemoryDedicatedRequirements& dedicated_reqs, MemoryUsage usage) noexcept {
+			auto ret = from_vk(reqs.memoryRequirements, usage);
+			ret.prefers_dedicated = dedicated_reqs.prefersDedicatedAllocation == VK_TRUE;
+			ret.requires_dedicated = dedicated_reqs.requiresDedicatedAllocation == VK_TRUE;
+			return ret;
+		}
+	};
+
+	/*
+	* Blocks include dedicated allocations, allocations include dedicated ones too.
+	*/
+	struct HeapStats {
+		usize block_count = 0;
+		usize block_bytes = 0;
+		usize allocation_count = 0;
+		usize allocation_bytes = 0;
+		usize dedicated_count = 0;
+		usize dedicated_bytes = 0;
+
+		[[nodiscard]]
+		usize get_suballocated_count() const noexcept {
+			return allocation_count - dedicated_count;
+		}
+
+		[[nodiscard]]
+		usize get_suballocated_bytes() const noexcept {
+			return allocation_bytes - dedicated_bytes;
+		}
+	};
+
+	struct HeapBudget {
+		usize budget = 0;
+		usize usage = 0;
+		HeapStats stats;
+
+		[[nodiscard]]
+		bool can_fit(usize size) const noexcept {
+			return usage + size <= budget;
+		}
+	};
+
+	class Defragmenter;
+
+	/*
+	* Sub-allocates device memory from large blocks. One TLSF pool per memory type, so allocate and free are O(1)
+	* and the number of blocks per heap is bounded by AllocatorConfig::max_blocks_per_heap.
+	* Allocations above AllocatorConfig::dedicated_threshold and resources the driver asks dedicated memory for
+	* through VkMemoryDedicatedRequirements get their own VkDeviceMemory.
+	*/
+	class Allocator {
+		friend AllocationValue;
+		friend Defragmenter;
+
+	private:
+		struct MemoryPool {
+			std::mutex mutex;
+			details::TlsfPool tlsf;
+			usize block_size = 0;
+			u32 heap_index = 0;
+			bool is_host_visible = false;
+			bool is_host_coherent = false;
+		};
+
+		struct HeapCounters {
+			std::atomic<usize> block_count = 0;
+			// TLSF blocks only, the ones AllocatorConfig::max_blocks_per_heap limits
+			std::atomic<usize> pool_block_count = 0;
+			std::atomic<usize> block_bytes = 0;
+			std::atomic<usize> allocation_count = 0;
+			std::atomic<usize> allocation_bytes = 0;
+			std::atomic<usize> dedicated_count = 0;
+			std::atomic<usize> dedicated_bytes = 0;
+
+			std::atomic<usize> fetched_usage = 0;
+			std::atomic<usize> fetched_budget = 0;
+			std::atomic<usize> fetched_block_bytes = 0;
+		};
+
+		VkDevice device_ = VK_NULL_HANDLE;
+		VkPhysicalDevice phys_device_ = VK_NULL_HANDLE;
+		AllocatorConfig config_;
+		usize granularity_ = 1;
+		usize non_coherent_atom_size_ = 1;
+		// VK_EXT_memory_budget is enabled on the device, heap sizes are used otherwise
+		bool has_memory_budget_ = false;
+		std::vector<std::unique_ptr<MemoryPool>> pools_;
+		std::array<MemoryTypeList, kMemoryUsageCount> memory_type_lists_;
+		std::array<HeapCounters, VK_MAX_MEMORY_HEAPS> heap_counters_;
+		std::atomic<u32> device_allocation_count_ = 0;
+		std::mutex budget_mutex_;
+
+	public:
+		Allocator(PhysDevice phys_device, VkDevice device, AllocatorConfig config = {}) noexcept;
+
+		Allocator(const Allocator&) = delete;
+		Allocator& operator=(const Allocator&) = delete;
+		Allocator(Allocator&&) = delete;
+		Allocator& operator=(Allocator&&) = delete;
+
+		~Allocator() noexcept;
+
+		[[nodiscard]]
+		auto allocate(const AllocationDesc& desc) noexcept -> std::expected<Allocation, ErrorCode>;
+
+		[[nodiscard]]
+		auto allocate_for_image(VkImage image, MemoryUsage usage = MemoryUsage::eGpuOnly, ExternalMemoryHandleTypeFlags export_handle_types = 0) noexcept -> std::expected<Allocation, ErrorCode>;
+
+		[[nodiscard]]
+		auto allocate_for_buffer(VkBuffer buffer, MemoryUsage usage = MemoryUsage::eGpuOnly, ExternalMemoryHandleTypeFlags export_handle_types = 0) noexcept -> std::expected<Allocation, ErrorCode>;
+
+		/*
+		* Table lookup into the list resolved by PhysDeviceInfo, allocate() also tries the next types of the list
+		* when a heap runs out of memory.
+		*/
+		[[nodiscard]]
+		std::optional<u32> find_memory_type(u32 type_bits, MemoryUsage usage) const noexcept {
+			return memory_type_lists_[std::to_underlying(usage)].find(type_bits);
+		}
+
+		/*
+		* Wraps existing host memory as a dedicated allocation, mapped pointer of it is ptr.
+		* ptr and size must be aligned to DeviceLimits::min_imported_host_pointer_alignment and memory_type_bits must come
+		* from vkGetMemoryHostPointerPropertiesEXT. The device must be created with ext::ExternalMemoryHostExt.
+		*/
+		[[nodiscard]]
+		auto import_host_memory(void* ptr, usize size, u32 memory_type_bits) noexcept -> std::expected<Allocation, ErrorCode>;
+
+		/*
+		* Imports memory exported by another process or device as an opaque fd and binds nothing.
+		* size and memory_type must match the exporting side, which usually sends them along with the fd.
+		* Pass the resource the memory is going to be bound to if the exporter allocated it as dedicated memory.
+		* On success the fd is owned by the implementation, on failure the caller still has to close it.
+		* The device must be created with ext::ExternalMemoryFdExt.
+		*/
+		[[nodiscard]]
+		auto import_memory_fd(int fd, usize size, u32 memory_type, VkImage image = VK_NULL_HANDLE, VkBuffer buffer = VK_NULL_HANDLE) noexcept -> std::expected<Allocation, ErrorCode>;
+
+		/*
+		* Make host writes visible to the device and device writes visible to the host for memory types without
+		* eHostCoherent, no-ops otherwise. offset is relative to the allocation, the range is widened to nonCoherentAtomSize.
+		*/
+		[[nodiscard]]
+		auto flush(AllocationView allocation, usize offset = 0, usize size = VK_WHOLE_SIZE) const noexcept -> std::expected<void, ErrorCode>;
+		[[nodiscard]]
+		auto invalidate(AllocationView allocation, usize offset = 0, usize size = VK_WHOLE_SIZE) const noexcept -> std::expected<void, ErrorCode>;
+
+		[[nodiscard]]
+		bool is_host_coherent(u32 memory_type) const noexcept {
+			return pools_[memory_type]->is_host_coherent;
+		}
+
+		[[nodiscard]]
+		HeapStats get_heap_stats(u32 heap_index) const noexcept;
+
+		/*
+		* Sum of get_heap_stats() over all heaps.
+		*/
+		[[nodiscard]]
+		HeapStats get_total_stats() const noexcept;
+
+		/*
+		* Cheap, doesn't call into the driver. Usage is the last value reported by VK_EXT_memory_budget plus
+		* the blocks allocated by this allocator since then. Without the extension on the device it's this allocator's
+		* own blocks against 80% of the heap size.
+		*/
+		[[nodiscard]]
+		HeapBudget get_heap_budget(u32 heap_index) const noexcept;
+
+		/*
+		* Refetches VK_EXT_memory_budget values, does nothing without the extension. Meant to be called once per frame.
+		*/
+		void update_budget() noexcept;
+
+		[[nodiscard]]
+		VkDevice get_device() const noexcept {
+			return device_;
+		}
+
+		[[nodiscard]]
+		VkPhysicalDevice get_phys_device() const noexcept {
+			return phys_device_;
+		}
+
+	private:
+		[[nodiscard]]
+		auto allocate_value_(const AllocationDesc& desc) noexcept -> std::expected<AllocationValue, ErrorCode>;
+		[[nodiscard]]
+		auto allocate_from_type_(const AllocationDesc& desc, u32 memory_type) noexcept -> std::expected<AllocationValue, ErrorCode>;
+		[[nodiscard]]
+		auto allocate_dedicated_(const AllocationDesc& desc, u32 memory_type) noexcept -> std::expected<AllocationValue, ErrorCode>;
+		[[nodiscard]]
+		auto allocate_device_memory_(usize size, u32 memory_type, const void* next = nullptr, bool map = true) noexcept -> std::expected<std::pair<VkDeviceMemory, u8*>, ErrorCode>;
+		[[nodiscard]]
+		auto import_dedicated_(usize size, u32 memory_type, const void* import_info, void* mapped) noexcept -> std::expected<Allocation, ErrorCode>;
+		void free_device_memory_(VkDeviceMemory memory, usize size, u32 memory_type) noexcept;
+		void free_(const AllocationValue& allocation) noexcept;
+		[[nodiscard]]
+		VkMappedMemoryRange get_mapped_range_(AllocationView allocation, usize offset, usize size) const noexcept;
+
+		/*
+		* Finds a place for src in the existing blocks that is better for compaction: a fuller block or
+		* a lower offset in the same one. Never allocates device memory.
+		*/
+		[[nodiscard]]
+		std::optional<AllocationValue> allocate_for_move_(const AllocationValue& src, usize alignment) noexcept;
+		[[nodiscard]]
+		usize get_block_usage_(const AllocationValue& allocation) noexcept;
+
+		[[nodiscard]]
+		u32 get_heap_index_(u32 memory_type) const noexcept {
+			return pools_[memory_type]->heap_index;
+		}
+	};
+
+	inline void AllocationValue::destroy() noexcept {
+		parent->free_(*this);
+	}
+}
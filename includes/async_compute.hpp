@@ -0,0 +1,163 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "error.hpp"
+#include "image.hpp"
+#include "cmd_exec.hpp"
+#include "scheduler.hpp"
+
+namespace gx {
+	/*
+	* A buffer range changing queues. src_* describe its last use on the queue it leaves, dst_* its first use on
+	* the queue it enters. Only needed for resources created with SharingMode::eExclusive.
+	*/
+	struct BufferHandoff {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		usize offset = 0;
+		usize size = VK_WHOLE_SIZE;
+		VkPipelineStageFlags2 src_stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkAccessFlags2 src_access = VK_ACCESS_2_MEMORY_WRITE_BIT;
+		VkPipelineStageFlags2 dst_stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkAccessFlags2 dst_access = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+	};
+
+	/*
+	* Same as BufferHandoff, the image goes from old_layout to new_layout on the way.
+	*/
+	struct ImageHandoff {
+		VkImage image = VK_NULL_HANDLE;
+		ImageSubresourceRange range;
+		ImageLayout old_layout = ImageLayout::eGeneral;
+		ImageLayout new_layout = ImageLayout::eGeneral;
+		VkPipelineStageFlags2 src_stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkAccessFlags2 src_access = VK_ACCESS_2_MEMORY_WRITE_BIT;
+		VkPipelineStageFlags2 dst_stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkAccessFlags2 dst_access = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+	};
+
+	struct AsyncComputeConfig {
+		// Scheduler queues, equal if the device has no compute family apart from the graphics one
+		u32 graphics_queue = 0;
+		u32 compute_queue = 1;
+		u32 graphics_family = 0;
+		u32 compute_family = 0;
+	};
+
+	struct AsyncComputeSubmitInfo {
+		std::span<const VkCommandBuffer> command_buffers;
+		// Produced by work enqueued on the graphics queue so far, compute takes them over
+		std::span<const BufferHandoff> acquire_buffers;
+		std::span<const ImageHandoff> acquire_images;
+		// Produced by this submission, the next graphics submission takes them back
+		std::span<const BufferHandoff> release_buffers;
+		std::span<const ImageHandoff> release_images;
+		std::span<const TimelinePoint> waits;
+	};
+
+	struct AsyncComputeStats {
+		usize compute_submission_count = 0;
+		usize ownership_transfer_count = 0;
+	};
+
+	/*
+	* Runs compute work on its own queue next to graphics. Resources handed between the queues get their queue family
+	* ownership transfers recorded into small command buffers from the CommandAllocator, a release on the queue they
+	* leave and an acquire on the queue they enter, and the entering queue waits for the timeline point of the leaving
+	* one. With one queue for both the handoffs become plain barriers and the work runs in submission order.
+	* Submissions go through TimelineScheduler::enqueue(), the caller flushes at its sync points as usual.
+	* Not thread safe, meant to be used by the thread that submits the frame.
+	*/
+	class AsyncCompute {
+	private:
+		struct PendingAcquire {
+			std::vector<BufferHandoff> buffers;
+			std::vector<ImageHandoff> images;
+			TimelinePoint point;
+		};
+
+		TimelineScheduler* scheduler_ = nullptr;
+		CommandAllocator* allocator_ = nullptr;
+		AsyncComputeConfig config_;
+
+		// Resources compute has released that the graphics queue hasn't acquired yet
+		PendingAcquire graphics_acquire_;
+		AsyncComputeStats stats_;
+
+		std::vector<VkBufferMemoryBarrier2> buffer_barriers_;
+		std::vector<VkImageMemoryBarrier2> image_barriers_;
+		std::vector<VkCommandBuffer> command_buffers_;
+		std::vector<TimelinePoint> waits_;
+
+	public:
+		/*
+		* allocator must have both families in CommandAllocatorConfig::queue_families.
+		*/
+		AsyncCompute(TimelineScheduler& scheduler, CommandAllocator& allocator, AsyncComputeConfig config) noexcept;
+
+		AsyncCompute(const AsyncCompute&) = delete;
+		AsyncCompute& operator=(const AsyncCompute&) = delete;
+		AsyncCompute(AsyncCompute&&) = delete;
+		AsyncCompute& operator=(AsyncCompute&&) = delete;
+
+		/*
+		* Enqueues the command buffers on the compute queue. If resources are acquired, their release is enqueued
+		* on the graphics queue first and compute waits for it, otherwise compute only waits for info.waits.
+		* All handoffs are recorded before anything is enqueued, so on failure nothing is.
+		*/
+		[[nodiscard]]
+		auto enqueue_compute(const AsyncComputeSubmitInfo& info) noexcept -> std::expected<TimelinePoint, ErrorCode>;
+
+		/*
+		* Enqueues graphics work. Resources released by earlier compute submissions are acquired in front of it and
+		* the submission waits for them. Work that doesn't touch them passes acquire_released = false, so it isn't
+		* held up by compute.
+		*/
+		[[nodiscard]]
+		auto enqueue_graphics(const TimelineSubmitInfo& info, bool acquire_released = true) noexcept -> std::expected<TimelinePoint, ErrorCode>;
+
+		/*
+		* True if compute runs on another scheduler queue than graphics and can overlap with it. The two queues may
+		* still belong to the same family.
+		*/
+		[[nodiscard]]
+		bool is_overlapping() const noexcept {
+			return config_.graphics_queue != config_.compute_queue;
+		}
+
+		[[nodiscard]]
+		AsyncComputeStats get_stats() const noexcept {
+			return stats_;
+		}
+
+		void reset_stats() noexcept {
+			stats_ = {};
+		}
+
+	private:
+		[[nodiscard]]
+		bool transfers_ownership_() const noexcept {
+			return config_.graphics_family != config_.compute_family;
+		}
+
+		/*
+		* Records one command buffer with the release or acquire half of the handoffs from src_family to dst_family,
+		* or plain barriers if the families are equal.
+		*/
+		[[nodiscard]]
+		auto record_handoffs_(
+			u32 family,
+			u32 src_family,
+			u32 dst_family,
+			bool is_release,
+			std::span<const BufferHandoff> buffers,
+			std::span<const ImageHandoff> images
+		) noexcept -> std::expected<VkCommandBuffer, ErrorCode>;
+	};
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <expected>
+#include <cassert>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "types.hpp"
+#include "error.hpp"
+#include "host_allocator.hpp"
+
+namespace gx {
+	enum class BufferUsage : u32 {
+		eTransferSrc = bit<u32, 0>(),
+		eTransferDst = bit<u32, 1>(),
+		eUniform = bit<u32, 2>(),
+		eStorage = bit<u32, 3>(),
+		eIndex = bit<u32, 4>(),
+		eVertex = bit<u32, 5>(),
+		eIndirect = bit<u32, 6>(),
+		eShaderDeviceAddress = bit<u32, 7>(),
+	};
+
+	OVERLOAD_BIT_OPS(BufferUsage, u32);
+
+	[[nodiscard]]
+	constexpr VkBufferUsageFlags buffer_usage_to_vk(BufferUsageFlags flags) noexcept {
+		VkBufferUsageFlags ret = 0;
+		if (test_bit(flags, BufferUsage::eTransferSrc)) {
+			ret |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		}
+		if (test_bit(flags, BufferUsage::eTransferDst)) {
+			ret |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		}
+		if (test_bit(flags, BufferUsage::eUniform)) {
+			ret |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		}
+		if (test_bit(flags, BufferUsage::eStorage)) {
+			ret |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		}
+		if (test_bit(flags, BufferUsage::eIndex)) {
+			ret |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		}
+		if (test_bit(flags, BufferUsage::eVertex)) {
+			ret |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		}
+		if (test_bit(flags, BufferUsage::eIndirect)) {
+			ret |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+		}
+		if (test_bit(flags, BufferUsage::eShaderDeviceAddress)) {
+			ret |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+		}
+		return ret;
+	}
+	static_assert(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT == buffer_usage_to_vk(std::to_underlying(BufferUsage::eUniform)));
+	static_assert((VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT) == buffer_usage_to_vk(BufferUsage::eVertex | BufferUsage::eIndex));
+
+	struct BufferImpl {
+		/*
+		* The buffer must be created with BufferUsage::eShaderDeviceAddress and bound to memory.
+		*/
+		template<typename Self>
+		[[nodiscard]]
+		VkDeviceAddress get_device_address(this Self&& self) noexcept {
+			VkBufferDeviceAddressInfo info = {
+				.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+				.buffer = self.value_.handle,
+			};
+			return vkGetBufferDeviceAddress(self.value_.parent, &info);
+		}
+	};
+
+	struct [[nodiscard]] BufferValue {
+		VkBuffer handle = VK_NULL_HANDLE;
+		VkDevice parent = VK_NULL_HANDLE;
+
+		BufferValue() noexcept = default;
+
+		BufferValue(VkBuffer buffer, VkDevice device) noexcept
+			: handle{ buffer }
+			, parent{ device }
+		{}
+
+		void destroy() noexcept {
+			vkDestroyBuffer(parent, handle, get_allocation_callbacks(parent));
+		}
+	};
+	static_assert(Value<BufferValue>);
+
+	using Buffer = ManagableType<BufferValue, BufferImpl>;
+	using BufferView = decltype(std::declval<Buffer&>().get_view());
+	using OwnedBuffer = OwnedType<BufferValue, BufferImpl, MoveOnlyTag, ViewableTag>;
+
+	struct [[nodiscard]] BufferBuilder {
+	private:
+		VkDevice device_ = VK_NULL_HANDLE;
+		usize size_ = 0;
+		BufferUsageFlags usage_ = 0;
+		SharingMode sharing_mode_ = SharingMode::eExclusive;
+		std::vector<u32> queue_family_indices_;
+		ExternalMemoryHandleTypeFlags external_handle_types_ = 0;
+		bool is_sparse_resident_ = false;
+
+	public:
+		BufferBuilder(VkDevice device) noexcept
+			: device_{ device }
+		{}
+
+		[[nodiscard]]
+		BufferBuilder& with_size(usize size) noexcept {
+			size_ = size;
+			return *this;
+		}
+
+		[[nodiscard]]
+		BufferBuilder& with_usage(BufferUsageFlags usage) noexcept {
+			usage_ = usage;
+			return *this;
+		}
+
+		[[nodiscard]]
+		BufferBuilder& with_queue_indices(std::vector<u32>&& indices) noexcept {
+			if (indices.size() > 1) {
+				sharing_mode_ = SharingMode::eConcurrent;
+			}
+			queue_family_indices_ = std::move(indices);
+
+			return *this;
+		}
+
+		/*
+		* The buffer may only be bound to memory imported or exported with one of these handle types.
+		*/
+		[[nodiscard]]
+		BufferBuilder& with_external_handle_types(ExternalMemoryHandleTypeFlags types) noexcept {
+			external_handle_types_ = types;
+			return *this;
+		}
+
+		/*
+		* Partially resident buffer, memory is bound per page with gx::SparseResidencyManager.
+		*/
+		[[nodiscard]]
+		BufferBuilder& set_sparse_residency(bool sparse) noexcept {
+			is_sparse_resident_ = sparse;
+			return *this;
+		}
+
+		[[nodiscard]]
+		auto build() const noexcept -> std::expected<Buffer, ErrorCode> {
+			validate();
+
+			VkExternalMemoryBufferCreateInfo external_info = {
+				.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO,
+				.handleTypes = external_memory_handle_types_to_vk(external_handle_types_),
+			};
+
+			VkBufferCreateInfo ci = {
+				.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+				.pNext = external_handle_types_ != 0 ? &external_info : nullptr,
+				.flags = is_sparse_resident_ ? VK_BUFFER_CREATE_SPARSE_BINDING_BIT | VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT : 0u,
+				.size = size_,
+				.usage = buffer_usage_to_vk(usage_),
+				.sharingMode = sharing_mode_to_vk(sharing_mode_),
+			};
+
+			if (!queue_family_indices_.empty()) {
+				ci.queueFamilyIndexCount = static_cast<u32>(queue_family_indices_.size());
+				ci.pQueueFamilyIndices = queue_family_indices_.data();
+			}
+
+			BufferValue value{ VK_NULL_HANDLE, device_ };
+			VkResult res = vkCreateBuffer(device_, &ci, get_allocation_callbacks(device_), &value.handle);
+
+			if (res == VK_SUCCESS) {
+				return Buffer{ value };
+			}
+			return std::unexpected(convert_vk_result(res));
+		}
+
+	private:
+		void validate() const noexcept {
+			// VUID-VkBufferCreateInfo-size-00912
+			assert(size_ != 0 && "size_ must be greater than 0");
+			// VUID-VkBufferCreateInfo-usage-requiredbitmask
+			assert(usage_ != 0 && "usage_ must not be 0");
+			// VUID-vkCreateBuffer-device-parameter
+			assert(device_ != VK_NULL_HANDLE && "device_ must be a valid VkDevice handle");
+		}
+	};
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	class BufferPool;
+
+	struct BufferRangeImpl {
+		template<typename Self>
+		[[nodiscard]]
+		usize get_offset(this Self&& self) noexcept {
+			return self.value_.offset;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		usize get_size(this Self&& self) noexcept {
+			return self.value_.size;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		void* get_mapped_ptr(this Self&& self) noexcept {
+			return self.value_.mapped;
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		VkDescriptorBufferInfo get_descriptor_info(this Self&& self) noexcept {
+			return VkDescriptorBufferInfo{
+				.buffer = self.value_.handle,
+				.offset = self.value_.offset,
+				.range = self.value_.size,
+			};
+		}
+	};
+
+	/*
+	* handle is the shared VkBuffer, ranges of one pool with equal handles can be bound once and drawn with different offsets.
+	*/
+	struct [[nodiscard]] BufferRangeValue {
+		VkBuffer handle = VK_NULL_HANDLE;
+		BufferPool* parent = nullptr;
+		usize offset = 0;
+		usize size = 0;
+		u32 node = details::TlsfPool::kNil;
+		u8* mapped = nullptr;
+
+		BufferRangeValue() noexcept = default;
+
+		void destroy() noexcept;
+	};
+	static_assert(Value<BufferRangeValue>);
+
+	using BufferRange = ManagableType<BufferRangeValue, BufferRangeImpl>;
+	using BufferRangeView = decltype(std::declval<BufferRange&>().get_view());
+	using OwnedBufferRange = OwnedType<BufferRangeValue, BufferRangeImpl, MoveOnlyTag, ViewableTag>;
+
+	struct BufferPoolConfig {
+		BufferUsageFlags usage = BufferUsage::eVertex | BufferUsage::eIndex | BufferUsage::eTransferDst;
+		MemoryUsage memory_usage = MemoryUsage::eGpuOnly;
+		usize buffer_size = mb_to_bytes(16);
+	};
+
+	/*
+	* Hands out ranges of a few large VkBuffers of one usage class instead of a VkBuffer per mesh or material.
+	* Ranges are placed with the same TLSF pool gx::Allocator uses, so allocate and free are O(1).
+	* Offsets honour the minimal uniform/storage offset alignment if the usage contains those bits.
+	* Requests larger than a half of buffer_size get a buffer of their own outside the TLSF pool, empty buffers except
+	* the last one are released.
+	*/
+	class BufferPool {
+		friend BufferRangeValue;
+
+	private:
+		// Destroyed in reverse order, the buffer goes before its memory
+		struct PoolBuffer {
+			OwnedAllocation allocation;
+			OwnedBuffer buffer;
+			VkBuffer handle = VK_NULL_HANDLE;
+		};
+
+		Allocator* allocator_ = nullptr;
+		BufferPoolConfig config_;
+		usize alignment_ = details::TlsfPool::kMinAlignment;
+
+		std::mutex mutex_;
+		details::TlsfPool tlsf_;
+		// Indexed by TLSF block
+		std::vector<PoolBuffer> buffers_;
+		// Buffers of the large requests, their ranges have no TLSF node and cover the whole buffer
+		std::vector<PoolBuffer> dedicated_;
+		std::atomic<usize> used_bytes_ = 0;
+		std::atomic<usize> capacity_ = 0;
+
+	public:
+		BufferPool(Allocator& allocator, BufferPoolConfig config = {}) noexcept;
+
+		BufferPool(const BufferPool&) = delete;
+		BufferPool& operator=(const BufferPool&) = delete;
+		BufferPool(BufferPool&&) = delete;
+		BufferPool& operator=(BufferPool&&) = delete;
+
+		[[nodiscard]]
+		auto allocate(usize size, usize alignment = 0) noexcept -> std::expected<BufferRange, ErrorCode>;
+
+		[[nodiscard]]
+		BufferUsageFlags get_usage() const noexcept {
+			return config_.usage;
+		}
+
+		[[nodiscard]]
+		usize get_used_bytes() const noexcept {
+			return used_bytes_.load(std::memory_order_relaxed);
+		}
+
+		[[nodiscard]]
+		usize get_capacity() const noexcept {
+			return capacity_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		[[nodiscard]]
+		auto create_buffer_(usize size) noexcept -> std::expected<PoolBuffer, ErrorCode>;
+		[[nodiscard]]
+		auto allocate_dedicated_(usize size) noexcept -> std::expected<BufferRange, ErrorCode>;
+		void free_(const BufferRangeValue& range) noexcept;
+	};
+
+	inline void BufferRangeValue::destroy() noexcept {
+		parent->free_(*this);
+	}
+}
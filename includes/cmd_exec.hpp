@@ -1,9 +1,15 @@
-#pragma once 
+#pragma once
 
 #include <limits>
 #include <vector>
 #include <tuple>
 #include <span>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <expected>
 
 #include <vulkan/vulkan.h>
 
@@ -14,7 +20,179 @@
 
 #include "types.hpp"
 #include "error.hpp"
+#include "host_allocator.hpp"
 
 namespace gx {
-	
-}
\ No newline at end of file
+	enum class QueueType : u8 {
+		eGraphics = 0,
+		eTransfer,
+		eCompute,
+		eCount,
+	};
+
+	inline constexpr usize kQueueTypeCount = std::to_underlying(QueueType::eCount);
+
+	/*
+	* Queue retrieved from a Device. When a family has fewer queues than were requested from it,
+	* several Queue objects share one VkQueue and submissions to them must be synchronized together.
+	*/
+	template<QueueType Type>
+	struct Queue {
+	private:
+		VkQueue handle_ = VK_NULL_HANDLE;
+		u32 family_ = 0;
+		u32 index_ = 0;
+
+	public:
+		Queue() noexcept = default;
+
+		Queue(VkQueue handle, u32 family, u32 index) noexcept
+			: handle_{ handle }
+			, family_{ family }
+			, index_{ index }
+		{}
+
+		[[nodiscard]]
+		static constexpr QueueType get_type() noexcept {
+			return Type;
+		}
+
+		[[nodiscard]]
+		VkQueue get_handle() const noexcept {
+			return handle_;
+		}
+
+		[[nodiscard]]
+		u32 get_family() const noexcept {
+			return family_;
+		}
+
+		/*
+		* Index of the VkQueue within its family.
+		*/
+		[[nodiscard]]
+		u32 get_index() const noexcept {
+			return index_;
+		}
+	};
+
+	using GraphicsQueue = Queue<QueueType::eGraphics>;
+	using TransferQueue = Queue<QueueType::eTransfer>;
+	using ComputeQueue = Queue<QueueType::eCompute>;
+
+	enum class CommandBufferLevel : u8 {
+		ePrimary = 0,
+		eSecondary,
+		eCount,
+	};
+
+	inline constexpr usize kCommandBufferLevelCount = std::to_underlying(CommandBufferLevel::eCount);
+
+	[[nodiscard]]
+	constexpr VkCommandBufferLevel command_buffer_level_to_vk(CommandBufferLevel level) noexcept {
+		return static_cast<VkCommandBufferLevel>(std::to_underlying(level));
+	}
+	static_assert(VK_COMMAND_BUFFER_LEVEL_PRIMARY == command_buffer_level_to_vk(CommandBufferLevel::ePrimary));
+	static_assert(VK_COMMAND_BUFFER_LEVEL_SECONDARY == command_buffer_level_to_vk(CommandBufferLevel::eSecondary));
+
+	struct CommandAllocatorConfig {
+		u32 frames_in_flight = 2;
+		// Queue families command buffers are allocated for, e.g. from PhysDeviceInfo::get_queue_index()
+		std::vector<u32> queue_families;
+		// Command buffers allocated at once when a pool has no free ones left
+		u32 batch_size = 8;
+	};
+
+	struct CommandAllocatorStats {
+		usize thread_count = 0;
+		usize pool_count = 0;
+		usize command_buffer_count = 0;
+		usize reset_count = 0;
+	};
+
+	/*
+	* One transient VkCommandPool per (thread, frame in flight, queue family). Pools are reset as a whole with
+	* vkResetCommandPool() the first time their thread allocates from them in a new frame, after that their command
+	* buffers are handed out again, so steady state recording creates no Vulkan objects.
+	* Command buffers are only valid during the frame they were allocated in and must be recorded by the allocating
+	* thread. Pools are destroyed with the allocator, the device must be done with all command buffers by then.
+	*/
+	class CommandAllocator {
+	private:
+		struct Pool {
+			VkCommandPool handle = VK_NULL_HANDLE;
+			// Frame the pool was last reset for
+			u64 frame = 0;
+			std::array<std::vector<VkCommandBuffer>, kCommandBufferLevelCount> command_buffers;
+			std::array<usize, kCommandBufferLevelCount> used_counts{};
+		};
+
+		// Pools of one thread, frame slot major
+		struct ThreadPools {
+			std::thread::id thread;
+			std::vector<Pool> pools;
+		};
+
+		VkDevice device_ = VK_NULL_HANDLE;
+		u64 id_ = 0;
+		CommandAllocatorConfig config_;
+		std::atomic<u64> frame_ = 0;
+
+		std::mutex threads_mutex_;
+		std::vector<std::unique_ptr<ThreadPools>> threads_;
+
+		std::atomic<usize> pool_count_ = 0;
+		std::atomic<usize> command_buffer_count_ = 0;
+		std::atomic<usize> reset_count_ = 0;
+
+	public:
+		CommandAllocator(VkDevice device, CommandAllocatorConfig config) noexcept;
+		~CommandAllocator() noexcept;
+
+		CommandAllocator(const CommandAllocator&) = delete;
+		CommandAllocator& operator=(const CommandAllocator&) = delete;
+		CommandAllocator(CommandAllocator&&) = delete;
+		CommandAllocator& operator=(CommandAllocator&&) = delete;
+
+		/*
+		* frame must increase monotonically. The device must be done with the command buffers of
+		* frame - frames_in_flight and older, their pools get reset.
+		*/
+		void begin_frame(u64 frame) noexcept {
+			frame_.store(frame, std::memory_order_release);
+		}
+
+		[[nodiscard]]
+		u64 get_frame() const noexcept {
+			return frame_.load(std::memory_order_acquire);
+		}
+
+		/*
+		* Returns a command buffer in the initial state.
+		*/
+		[[nodiscard]]
+		auto allocate(u32 queue_family, CommandBufferLevel level = CommandBufferLevel::ePrimary) noexcept -> std::expected<VkCommandBuffer, ErrorCode>;
+
+		/*
+		* allocate() followed by vkBeginCommandBuffer() with VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT.
+		* Secondary command buffers need inheritance, flags are added to the begin info.
+		*/
+		[[nodiscard]]
+		auto begin(
+			u32 queue_family,
+			CommandBufferLevel level = CommandBufferLevel::ePrimary,
+			const VkCommandBufferInheritanceInfo* inheritance = nullptr,
+			VkCommandBufferUsageFlags flags = 0
+		) noexcept -> std::expected<VkCommandBuffer, ErrorCode>;
+
+		[[nodiscard]]
+		CommandAllocatorStats get_stats() noexcept;
+
+	private:
+		[[nodiscard]]
+		ThreadPools& get_thread_pools_() noexcept;
+
+		[[nodiscard]]
+		u32 get_family_slot_(u32 queue_family) const noexcept;
+	};
+}
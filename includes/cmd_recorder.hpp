@@ -0,0 +1,357 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include <type_traits>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "types.hpp"
+#include "buffer.hpp"
+
+namespace gx {
+	enum class PipelineBindPoint : u8 {
+		eGraphics = 0,
+		eCompute,
+		eCount,
+	};
+
+	inline constexpr usize kPipelineBindPointCount = std::to_underlying(PipelineBindPoint::eCount);
+
+	[[nodiscard]]
+	constexpr VkPipelineBindPoint pipeline_bind_point_to_vk(PipelineBindPoint bind_point) noexcept {
+		return static_cast<VkPipelineBindPoint>(std::to_underlying(bind_point));
+	}
+	static_assert(VK_PIPELINE_BIND_POINT_GRAPHICS == pipeline_bind_point_to_vk(PipelineBindPoint::eGraphics));
+	static_assert(VK_PIPELINE_BIND_POINT_COMPUTE == pipeline_bind_point_to_vk(PipelineBindPoint::eCompute));
+
+	enum class IndexType : u8 {
+		eUint16 = 0,
+		eUint32,
+	};
+
+	[[nodiscard]]
+	constexpr VkIndexType index_type_to_vk(IndexType type) noexcept {
+		return static_cast<VkIndexType>(std::to_underlying(type));
+	}
+	static_assert(VK_INDEX_TYPE_UINT16 == index_type_to_vk(IndexType::eUint16));
+	static_assert(VK_INDEX_TYPE_UINT32 == index_type_to_vk(IndexType::eUint32));
+
+	/*
+	* Dynamic states CommandRecorder shadows. Binding a graphics pipeline disturbs the states it doesn't declare dynamic.
+	*/
+	enum class DynamicState : u8 {
+		eViewport = bit<u8, 0>(),
+		eScissor = bit<u8, 1>(),
+		eLineWidth = bit<u8, 2>(),
+		eDepthBias = bit<u8, 3>(),
+		eBlendConstants = bit<u8, 4>(),
+		eStencilReference = bit<u8, 5>(),
+	};
+
+	OVERLOAD_BIT_OPS(DynamicState, u8);
+
+	struct CommandRecorderStats {
+		usize issued_count = 0;
+		usize elided_count = 0;
+	};
+
+	/*
+	* Records into a command buffer and shadows the bound pipelines, descriptor sets, vertex and index buffers and
+	* dynamic state, binds that wouldn't change anything aren't issued. Only viewport and scissor 0 are shadowed.
+	* State set around the recorder (raw vkCmd* calls, vkCmdExecuteCommands()) must be followed by invalidate().
+	* Descriptor sets bound with dynamic offsets are always issued.
+	* Doesn't own the command buffer, so unlike the handle types it's a plain class that lives for one recording.
+	*/
+	class CommandRecorder {
+	public:
+		static constexpr u32 kMaxDescriptorSets = 8;
+		static constexpr u32 kMaxVertexBindings = 16;
+
+	private:
+		struct BindPointState {
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			VkPipelineLayout layout = VK_NULL_HANDLE;
+			std::array<VkDescriptorSet, kMaxDescriptorSets> sets{};
+		};
+
+		VkCommandBuffer cmd_ = VK_NULL_HANDLE;
+		std::array<BindPointState, kPipelineBindPointCount> bind_points_{};
+		std::array<VkBuffer, kMaxVertexBindings> vertex_buffers_{};
+		std::array<VkDeviceSize, kMaxVertexBindings> vertex_offsets_{};
+		VkBuffer index_buffer_ = VK_NULL_HANDLE;
+		VkDeviceSize index_offset_ = 0;
+		IndexType index_type_ = IndexType::eUint16;
+
+		// Shadowed values of the dynamic states not in this mask are unknown
+		DynamicStateFlags known_states_ = 0;
+		VkViewport viewport_{};
+		VkRect2D scissor_{};
+		f32 line_width_ = 1.f;
+		std::array<f32, 3> depth_bias_{};
+		std::array<f32, 4> blend_constants_{};
+		u32 stencil_reference_ = 0;
+
+		CommandRecorderStats stats_;
+
+	public:
+		CommandRecorder() noexcept = default;
+
+		/*
+		* cmd must be in the recording state and nothing may be bound yet.
+		*/
+		explicit CommandRecorder(VkCommandBuffer cmd) noexcept
+			: cmd_{ cmd }
+		{}
+
+		/*
+		* Continues with another command buffer, counters are kept.
+		*/
+		void reset(VkCommandBuffer cmd) noexcept {
+			cmd_ = cmd;
+			invalidate();
+		}
+
+		void invalidate() noexcept {
+			bind_points_ = {};
+			vertex_buffers_ = {};
+			vertex_offsets_ = {};
+			index_buffer_ = VK_NULL_HANDLE;
+			known_states_ = 0;
+		}
+
+		[[nodiscard]]
+		VkCommandBuffer get_handle() const noexcept {
+			return cmd_;
+		}
+
+		[[nodiscard]]
+		CommandRecorderStats get_stats() const noexcept {
+			return stats_;
+		}
+
+		void reset_stats() noexcept {
+			stats_ = {};
+		}
+
+		/*
+		* dynamic_states must be exactly the states the pipeline declares dynamic, ignored for compute pipelines.
+		*/
+		void bind_pipeline(PipelineBindPoint bind_point, VkPipeline pipeline, DynamicStateFlags dynamic_states) noexcept {
+			auto& state = bind_points_[std::to_underlying(bind_point)];
+			if (state.pipeline == pipeline) {
+				++stats_.elided_count;
+				return;
+			}
+
+			vkCmdBindPipeline(cmd_, pipeline_bind_point_to_vk(bind_point), pipeline);
+			state.pipeline = pipeline;
+			if (bind_point == PipelineBindPoint::eGraphics) {
+				known_states_ &= dynamic_states;
+			}
+			++stats_.issued_count;
+		}
+
+		void bind_descriptor_sets(
+			PipelineBindPoint bind_point,
+			VkPipelineLayout layout,
+			u32 first_set,
+			std::span<const VkDescriptorSet> sets,
+			std::span<const u32> dynamic_offsets = {}
+		) noexcept {
+			assert(first_set + sets.size() <= kMaxDescriptorSets && "CommandRecorder::bind_descriptor_sets(): too many descriptor sets");
+
+			auto& state = bind_points_[std::to_underlying(bind_point)];
+			if (state.layout == layout && dynamic_offsets.empty() && std::ranges::equal(sets, std::span{ state.sets }.subspan(first_set, sets.size()))) {
+				++stats_.elided_count;
+				return;
+			}
+
+			vkCmdBindDescriptorSets(
+				cmd_,
+				pipeline_bind_point_to_vk(bind_point),
+				layout,
+				first_set,
+				static_cast<u32>(sets.size()),
+				sets.data(),
+				static_cast<u32>(dynamic_offsets.size()),
+				dynamic_offsets.data()
+			);
+
+			// Sets bound with another layout may have been disturbed
+			if (state.layout != layout) {
+				state.sets = {};
+				state.layout = layout;
+			}
+			std::ranges::copy(sets, state.sets.begin() + first_set);
+			if (!dynamic_offsets.empty()) {
+				std::ranges::fill(std::span{ state.sets }.subspan(first_set, sets.size()), VK_NULL_HANDLE);
+			}
+			++stats_.issued_count;
+		}
+
+		void bind_descriptor_set(PipelineBindPoint bind_point, VkPipelineLayout layout, u32 set_index, VkDescriptorSet set) noexcept {
+			bind_descriptor_sets(bind_point, layout, set_index, std::span{ &set, 1 });
+		}
+
+		/*
+		* Unchanged bindings at both ends of the range are trimmed off.
+		*/
+		void bind_vertex_buffers(u32 first_binding, std::span<const VkBuffer> buffers, std::span<const VkDeviceSize> offsets) noexcept {
+			assert(buffers.size() == offsets.size() && "CommandRecorder::bind_vertex_buffers(): every buffer needs an offset");
+			assert(first_binding + buffers.size() <= kMaxVertexBindings && "CommandRecorder::bind_vertex_buffers(): too many vertex bindings");
+
+			auto is_bound = [&](usize i) noexcept {
+				return vertex_buffers_[first_binding + i] == buffers[i] && vertex_offsets_[first_binding + i] == offsets[i];
+			};
+
+			usize first = 0;
+			usize last = buffers.size();
+			while (first < last && is_bound(first)) {
+				++first;
+			}
+			while (last > first && is_bound(last - 1)) {
+				--last;
+			}
+
+			if (first == last) {
+				++stats_.elided_count;
+				return;
+			}
+
+			vkCmdBindVertexBuffers(cmd_, first_binding + static_cast<u32>(first), static_cast<u32>(last - first), buffers.data() + first, offsets.data() + first);
+			std::ranges::copy(buffers, vertex_buffers_.begin() + first_binding);
+			std::ranges::copy(offsets, vertex_offsets_.begin() + first_binding);
+			++stats_.issued_count;
+		}
+
+		void bind_vertex_buffer(u32 binding, BufferView buffer, usize offset = 0) noexcept {
+			VkBuffer handle = buffer.get_handle();
+			VkDeviceSize vk_offset = offset;
+			bind_vertex_buffers(binding, std::span{ &handle, 1 }, std::span{ &vk_offset, 1 });
+		}
+
+		void bind_index_buffer(BufferView buffer, usize offset, IndexType type) noexcept {
+			if (index_buffer_ == buffer.get_handle() && index_offset_ == offset && index_type_ == type) {
+				++stats_.elided_count;
+				return;
+			}
+
+			vkCmdBindIndexBuffer(cmd_, buffer.get_handle(), offset, index_type_to_vk(type));
+			index_buffer_ = buffer.get_handle();
+			index_offset_ = offset;
+			index_type_ = type;
+			++stats_.issued_count;
+		}
+
+		void set_viewport(const VkViewport& viewport) noexcept {
+			if (is_known_(DynamicState::eViewport, viewport_, viewport)) {
+				return;
+			}
+			vkCmdSetViewport(cmd_, 0, 1, &viewport);
+		}
+
+		void set_scissor(const VkRect2D& scissor) noexcept {
+			if (is_known_(DynamicState::eScissor, scissor_, scissor)) {
+				return;
+			}
+			vkCmdSetScissor(cmd_, 0, 1, &scissor);
+		}
+
+		void set_line_width(f32 width) noexcept {
+			if (is_known_(DynamicState::eLineWidth, line_width_, width)) {
+				return;
+			}
+			vkCmdSetLineWidth(cmd_, width);
+		}
+
+		void set_depth_bias(f32 constant_factor, f32 clamp, f32 slope_factor) noexcept {
+			if (is_known_(DynamicState::eDepthBias, depth_bias_, std::array{ constant_factor, clamp, slope_factor })) {
+				return;
+			}
+			vkCmdSetDepthBias(cmd_, constant_factor, clamp, slope_factor);
+		}
+
+		void set_blend_constants(const std::array<f32, 4>& constants) noexcept {
+			if (is_known_(DynamicState::eBlendConstants, blend_constants_, constants)) {
+				return;
+			}
+			vkCmdSetBlendConstants(cmd_, constants.data());
+		}
+
+		/*
+		* Sets the reference of both faces.
+		*/
+		void set_stencil_reference(u32 reference) noexcept {
+			if (is_known_(DynamicState::eStencilReference, stencil_reference_, reference)) {
+				return;
+			}
+			vkCmdSetStencilReference(cmd_, VK_STENCIL_FACE_FRONT_AND_BACK, reference);
+		}
+
+		/*
+		* Push constants aren't shadowed.
+		*/
+		template<typename T>
+			requires std::is_trivially_copyable_v<T>
+		void push_constants(VkPipelineLayout layout, VkShaderStageFlags stages, const T& value, u32 offset = 0) noexcept {
+			vkCmdPushConstants(cmd_, layout, stages, offset, sizeof(T), &value);
+			++stats_.issued_count;
+		}
+
+		void draw(u32 vertex_count, u32 instance_count = 1, u32 first_vertex = 0, u32 first_instance = 0) noexcept {
+			vkCmdDraw(cmd_, vertex_count, instance_count, first_vertex, first_instance);
+			++stats_.issued_count;
+		}
+
+		void draw_indexed(u32 index_count, u32 instance_count = 1, u32 first_index = 0, i32 vertex_offset = 0, u32 first_instance = 0) noexcept {
+			vkCmdDrawIndexed(cmd_, index_count, instance_count, first_index, vertex_offset, first_instance);
+			++stats_.issued_count;
+		}
+
+		void draw_indexed_indirect(BufferView buffer, usize offset, u32 draw_count, u32 stride) noexcept {
+			vkCmdDrawIndexedIndirect(cmd_, buffer.get_handle(), offset, draw_count, stride);
+			++stats_.issued_count;
+		}
+
+		void dispatch(u32 x, u32 y = 1, u32 z = 1) noexcept {
+			vkCmdDispatch(cmd_, x, y, z);
+			++stats_.issued_count;
+		}
+
+		/*
+		* Secondary command buffers leave the state undefined.
+		*/
+		void execute_commands(std::span<const VkCommandBuffer> command_buffers) noexcept {
+			vkCmdExecuteCommands(cmd_, static_cast<u32>(command_buffers.size()), command_buffers.data());
+			invalidate();
+			++stats_.issued_count;
+		}
+
+	private:
+		/*
+		* Returns true if the state is known to hold value already, otherwise takes value as the new state
+		* and counts the command the caller is going to issue.
+		*/
+		template<typename T>
+		[[nodiscard]]
+		bool is_known_(DynamicState state, T& shadow, const T& value) noexcept {
+			// Compared bitwise, -0.f and 0.f only cost a redundant command
+			if (test_bit(known_states_, state) && std::memcmp(&shadow, &value, sizeof(T)) == 0) {
+				++stats_.elided_count;
+				return true;
+			}
+
+			shadow = value;
+			known_states_ |= state;
+			++stats_.issued_count;
+			return false;
+		}
+	};
+}
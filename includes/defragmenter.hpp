@@ -0,0 +1,112 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <chrono>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "types.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	struct DefragmenterConfig {
+		std::chrono::microseconds max_pass_time{ 300 };
+		usize max_bytes_per_pass = mb_to_bytes(32);
+		u32 max_moves_per_pass = 64;
+	};
+
+	/*
+	* A buffer the defragmenter is allowed to move. The buffer must be created with BufferUsage::eTransferSrc,
+	* usage is used to recreate it at the new place.
+	*/
+	struct DefragCandidate {
+		AllocationView allocation;
+		BufferView buffer;
+		usize size = 0;
+		BufferUsageFlags usage = 0;
+		u64 user_data = 0;
+	};
+
+	struct [[nodiscard]] DefragMove {
+		u64 user_data = 0;
+		AllocationValue src;
+		AllocationValue dst;
+		BufferValue dst_buffer;
+
+		/*
+		* Destroys the old buffer and frees the old memory, then hands the new ones over to the caller.
+		*/
+		void apply(Allocation& allocation, Buffer& buffer) noexcept {
+			std::move(buffer).destroy();
+			std::move(allocation).destroy();
+
+			buffer = Buffer{ dst_buffer };
+			allocation = Allocation{ dst };
+		}
+	};
+
+	struct DefragStats {
+		usize passes = 0;
+		usize moves = 0;
+		usize bytes_moved = 0;
+	};
+
+	/*
+	* Incremental defragmentation of gx::Allocator pools. Each pass moves buffers out of the emptiest blocks into
+	* fuller ones, records the copies into a caller's command buffer and stops once the time or size budget runs out.
+	* No device idle is needed: the caller finishes the pass with end_pass() once that command buffer has completed.
+	*/
+	class Defragmenter {
+	private:
+		Allocator* allocator_ = nullptr;
+		DefragmenterConfig config_;
+		std::vector<DefragMove> pending_;
+		DefragStats stats_;
+
+	public:
+		Defragmenter(Allocator& allocator, DefragmenterConfig config = {}) noexcept
+			: allocator_{ &allocator }
+			, config_{ config }
+		{}
+
+		Defragmenter(const Defragmenter&) = delete;
+		Defragmenter& operator=(const Defragmenter&) = delete;
+
+		~Defragmenter() noexcept {
+			cancel_pass();
+		}
+
+		/*
+		* Returns the number of moves recorded into cmd. The source buffers must not be written to
+		* until end_pass() and the moved buffers must not be used before cmd has completed.
+		*/
+		u32 record_pass(VkCommandBuffer cmd, std::span<const DefragCandidate> candidates) noexcept;
+
+		/*
+		* Must be called after the command buffer passed to record_pass() has completed on the GPU.
+		* Every returned move must be applied by the caller.
+		*/
+		[[nodiscard]]
+		std::vector<DefragMove> end_pass() noexcept;
+
+		/*
+		* Drops recorded but not yet applied moves. Only valid if the recorded command buffer was never submitted or has completed.
+		*/
+		void cancel_pass() noexcept;
+
+		[[nodiscard]]
+		bool has_pending_moves() const noexcept {
+			return !pending_.empty();
+		}
+
+		[[nodiscard]]
+		DefragStats get_stats() const noexcept {
+			return stats_;
+		}
+	};
+}
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <span>
+#include <array>
+#include <ranges>
 #include <vector>
 #include <optional>
 #include <map>
 #include <expected>
+#include <string_view>
+#include <algorithm>
 #include <cassert>
 
 #include <vulkan/vulkan.h>
@@ -18,6 +23,8 @@
 #include "error.hpp"
 #include "types.hpp"
 #include "extensions.hpp"
+#include "buffer.hpp"
+#include "host_allocator.hpp"
 
 namespace gx {
 	enum class VendorType : u8 {
@@ -31,25 +38,152 @@ namespace gx {
 		eDeviceLocal = bit<u8, 0>(),
 		eHostVisible = bit<u8, 1>(),
 		eHostCoherent = bit<u8, 2>(),
+		eHostCached = bit<u8, 3>(),
+		eLazilyAllocated = bit<u8, 4>(),
 	};
 
 	OVERLOAD_BIT_OPS(MemoryProperties, u8);
 
+	/*
+	* Presets are resolved once per physical device into an ordered list of memory types (see PhysDeviceInfo::get_memory_types()).
+	* A preset may name a fallback one, whose types are appended to the end of the list.
+	* Fallbacks must be declared before the presets using them.
+	*/
+	enum class MemoryUsage : u8 {
+		// Render targets, static geometry and textures
+		eGpuOnly = 0,
+		// Staging memory, never device local
+		eCpuOnly,
+		// Written by the CPU every frame and read by the GPU, prefers device local (BAR/ReBAR) memory
+		eCpuToGpu,
+		// Written by the GPU and read by the CPU
+		eGpuToCpu,
+		// Same as eGpuToCpu but requires host cached memory, falls back to eGpuToCpu
+		eReadbackCached,
+		// Transient attachments that may never be backed by memory, falls back to eGpuOnly
+		eLazilyAllocated,
+		eCount,
+	};
+
+	inline constexpr usize kMemoryUsageCount = std::to_underlying(MemoryUsage::eCount);
+
+	struct MemoryUsageTraits {
+		MemoryPropertiesFlags required = 0;
+		MemoryPropertiesFlags preferred = 0;
+		MemoryPropertiesFlags avoided = 0;
+		MemoryUsage fallback = MemoryUsage::eCount;
+	};
+
+	namespace details {
+		inline constexpr std::array<MemoryUsageTraits, kMemoryUsageCount> kMemoryUsageTraits = {
+			MemoryUsageTraits{
+				.required = std::to_underlying(MemoryProperties::eDeviceLocal),
+				.avoided = std::to_underlying(MemoryProperties::eHostVisible),
+			},
+			MemoryUsageTraits{
+				.required = MemoryProperties::eHostVisible | MemoryProperties::eHostCoherent,
+				.avoided = MemoryProperties::eDeviceLocal | MemoryProperties::eHostCached,
+			},
+			MemoryUsageTraits{
+				.required = MemoryProperties::eHostVisible | MemoryProperties::eHostCoherent,
+				.preferred = std::to_underlying(MemoryProperties::eDeviceLocal),
+				.avoided = std::to_underlying(MemoryProperties::eHostCached),
+			},
+			MemoryUsageTraits{
+				.required = std::to_underlying(MemoryProperties::eHostVisible),
+				.preferred = MemoryProperties::eHostCached | MemoryProperties::eHostCoherent,
+			},
+			MemoryUsageTraits{
+				.required = MemoryProperties::eHostVisible | MemoryProperties::eHostCached,
+				.preferred = std::to_underlying(MemoryProperties::eHostCoherent),
+				.fallback = MemoryUsage::eGpuToCpu,
+			},
+			MemoryUsageTraits{
+				.required = MemoryProperties::eDeviceLocal | MemoryProperties::eLazilyAllocated,
+				.avoided = std::to_underlying(MemoryProperties::eHostVisible),
+				.fallback = MemoryUsage::eGpuOnly,
+			},
+		};
+
+		static_assert(
+			std::ranges::all_of(std::views::iota(usize{ 0 }, kMemoryUsageCount),
+				[](usize i) {
+					auto fallback = kMemoryUsageTraits[i].fallback;
+					return fallback == MemoryUsage::eCount || std::to_underlying(fallback) < i;
+				}
+			),
+			"Fallback presets must be declared before the presets using them"
+		);
+	}
+
+	[[nodiscard]]
+	constexpr const MemoryUsageTraits& get_memory_usage_traits(MemoryUsage usage) noexcept {
+		return details::kMemoryUsageTraits[std::to_underlying(usage)];
+	}
+
+	struct MemoryTypeList {
+		std::array<u8, VK_MAX_MEMORY_TYPES> types{};
+		u32 count = 0;
+
+		[[nodiscard]]
+		std::span<const u8> get() const noexcept {
+			return std::span{ types.data(), count };
+		}
+
+		/*
+		* First type in preference order that is allowed by type_bits (VkMemoryRequirements::memoryTypeBits).
+		*/
+		[[nodiscard]]
+		std::optional<u32> find(u32 type_bits) const noexcept {
+			for (u8 type : get()) {
+				if ((type_bits & (1u << type)) != 0) {
+					return type;
+				}
+			}
+			return std::nullopt;
+		}
+	};
+
 	struct MemoryInfo {
+		// Size of the heap this type belongs to. Live budget is available through Allocator::get_heap_budget()
 		usize budget = 0;
 		u8 memory_properties = 0;
+		u32 heap_index = 0;
 	};
 
-	enum class QueueType : u8 {
-		eGraphics = 0,
-		eTransfer,
-		eCompute,
+	/*
+	* Optional features DeviceBuilder::with_features() can enable, PhysDeviceInfo::supported_features lists the available ones.
+	*/
+	enum class DeviceFeature : u32 {
+		eBufferDeviceAddress = bit<u32, 0>(),
+		eSparseBinding = bit<u32, 1>(),
+		eSparseResidencyBuffer = bit<u32, 2>(),
+		eSparseResidencyImage2D = bit<u32, 3>(),
+		eSparseResidencyImage3D = bit<u32, 4>(),
+		eTimelineSemaphore = bit<u32, 5>(),
+		eSynchronization2 = bit<u32, 6>(),
+	};
+
+	OVERLOAD_BIT_OPS(DeviceFeature, u32);
+
+	struct DeviceLimits {
+		usize buffer_image_granularity = 1;
+		usize non_coherent_atom_size = 1;
+		usize min_uniform_buffer_offset_alignment = 256;
+		usize min_storage_buffer_offset_alignment = 256;
+		u32 max_memory_allocation_count = 4096;
+		// 0 if VK_EXT_external_memory_host is not supported
+		usize min_imported_host_pointer_alignment = 0;
 	};
 
 	struct QueueInfo {
 		QueueType type = QueueType::eGraphics;
 		usize index = 0;
 		usize count = 0;
+		// The family can execute vkQueueBindSparse()
+		bool supports_sparse_binding = false;
+		// No other queue type uses the family, so work on it can overlap with the others
+		bool is_dedicated = false;
 	};
 
 	enum class PhysicalDeviceType : u8 {
@@ -66,12 +200,52 @@ namespace gx {
 	public:
 		std::vector<MemoryInfo> memory_infos;
 		std::vector<QueueInfo> queue_infos;
+		std::vector<usize> memory_heap_sizes;
+		DeviceLimits limits;
+		std::vector<VkExtensionProperties> supported_extensions;
+		std::array<MemoryTypeList, kMemoryUsageCount> memory_type_lists;
+		// Processes sharing memory or semaphores through external handles must run on matching devices and drivers
+		std::array<u8, VK_UUID_SIZE> device_uuid{};
+		std::array<u8, VK_UUID_SIZE> driver_uuid{};
+		// VkPhysicalDeviceProperties::apiVersion, decides which feature structures the device knows
+		u32 api_version = 0;
+		DeviceFeatureFlags supported_features = 0;
 		std::string device_name;
 		VendorType vendor = VendorType::eNone;
 		PhysicalDeviceType device_type = PhysicalDeviceType::eNone;
 
 		[[nodiscard]]
 		std::optional<u32> get_queue_index(QueueType type) const noexcept;
+
+		/*
+		* Prefers a family without graphics, so binds don't queue up behind rendering.
+		*/
+		[[nodiscard]]
+		std::optional<QueueType> get_sparse_binding_queue_type() const noexcept;
+
+		[[nodiscard]]
+		const MemoryTypeList& get_memory_types(MemoryUsage usage) const noexcept {
+			return memory_type_lists[std::to_underlying(usage)];
+		}
+
+		[[nodiscard]]
+		bool supports_extension(std::string_view name) const noexcept;
+
+		[[nodiscard]]
+		bool supports_features(DeviceFeatureFlags features) const noexcept {
+			return (supported_features & features) == features;
+		}
+
+		[[nodiscard]]
+		bool supports_host_memory_import() const noexcept {
+			return limits.min_imported_host_pointer_alignment != 0;
+		}
+
+		template<ext::DeviceExt E>
+		[[nodiscard]]
+		bool supports_extension() const noexcept {
+			return std::ranges::all_of(E::get(), [this](const char* name) { return supports_extension(name); });
+		}
 	
 		static const PhysDeviceInfo& get(PhysDevice phys_device) noexcept;
 		static const PhysDeviceInfo& get(VkPhysicalDevice phys_device) noexcept;
@@ -79,21 +253,55 @@ namespace gx {
 	private:
 		static std::vector<std::pair<VkPhysicalDevice, PhysDeviceInfo>> phys_device_infos_;
 		static PhysDeviceInfo fill_info_(VkPhysicalDevice phys_device) noexcept;
+		static MemoryTypeList resolve_memory_usage_(const PhysDeviceInfo& info, MemoryUsage usage) noexcept;
 		static void push_(VkPhysicalDevice phys_device) noexcept;
 
 	};
 
+	namespace details {
+		/*
+		* Where the queues requested for one type live. Queue i of the type is queue
+		* (first_index + i) % family_queue_count of the family, requests beyond the family's queue count share queues.
+		*/
+		struct DeviceQueueSlot {
+			u32 family = 0;
+			u32 first_index = 0;
+			u32 count = 0;
+			u32 family_queue_count = 0;
+		};
+	}
+
+	/*
+	* True if the device was created with VK_EXT_memory_budget. DeviceBuilder::build() enables it whenever the physical
+	* device supports it, it only adds a query.
+	*/
+	[[nodiscard]]
+	bool is_memory_budget_enabled(VkDevice device) noexcept;
+
+	namespace details {
+		void register_memory_budget(VkDevice device) noexcept;
+		void unregister_memory_budget(VkDevice device) noexcept;
+	}
+
 	struct DeviceValue {
 		VkDevice handle;
+		std::array<details::DeviceQueueSlot, kQueueTypeCount> queue_slots{};
 
 		DeviceValue() noexcept = default;
 
-		DeviceValue(VkDevice device)
+		DeviceValue(VkDevice device) noexcept
 			: handle{ device }
 		{}
 
+		DeviceValue(VkDevice device, const std::array<details::DeviceQueueSlot, kQueueTypeCount>& slots) noexcept
+			: handle{ device }
+			, queue_slots{ slots }
+		{}
+
 		void destroy() noexcept {
-			vkDestroyDevice(handle, nullptr);
+			vkDestroyDevice(handle, get_allocation_callbacks(handle));
+			details::unregister_allocation_callbacks(handle);
+			details::unregister_memory_budget(handle);
 		}
 	};
 	static_assert(Value<DeviceValue>);
@@ -109,6 +317,57 @@ namespace gx {
 		ext::SwapchainBuilder get_ext_swapchain_builder(this Self&& self, ext::SurfaceView surface) noexcept {
 			return ext::SwapchainBuilder{ self.get_handle() }.with_surface(surface);
 		}
+
+		template<typename Self>
+		[[nodiscard]]
+		BufferBuilder get_buffer_builder(this Self&& self) noexcept {
+			return BufferBuilder{ self.get_handle() };
+		}
+
+		/*
+		* index is in [0, count) of what was requested from DeviceBuilder for the type,
+		* nullopt if the type wasn't requested or the device has no family for it.
+		*/
+		template<QueueType Type, typename Self>
+		[[nodiscard]]
+		std::optional<Queue<Type>> get_queue(this Self&& self, u32 index = 0) noexcept {
+			const auto& slot = self.value_.queue_slots[std::to_underlying(Type)];
+			if (index >= slot.count) {
+				return std::nullopt;
+			}
+
+			u32 family_index = (slot.first_index + index) % slot.family_queue_count;
+			VkQueue queue = VK_NULL_HANDLE;
+			vkGetDeviceQueue(self.get_handle(), slot.family, family_index, &queue);
+			return Queue<Type>{ queue, slot.family, family_index };
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		std::optional<GraphicsQueue> get_graphics_queue(this Self&& self, u32 index = 0) noexcept {
+			return self.template get_queue<QueueType::eGraphics>(index);
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		std::optional<ComputeQueue> get_compute_queue(this Self&& self, u32 index = 0) noexcept {
+			return self.template get_queue<QueueType::eCompute>(index);
+		}
+
+		template<typename Self>
+		[[nodiscard]]
+		std::optional<TransferQueue> get_transfer_queue(this Self&& self, u32 index = 0) noexcept {
+			return self.template get_queue<QueueType::eTransfer>(index);
+		}
+
+		/*
+		* Number of queues requested for the type.
+		*/
+		template<typename Self>
+		[[nodiscard]]
+		u32 get_queue_count(this Self&& self, QueueType type) noexcept {
+			return self.value_.queue_slots[std::to_underlying(type)].count;
+		}
 	};
 
 	template<typename E>
@@ -123,13 +382,18 @@ namespace gx {
 	template<typename... Es>
 	struct DeviceBuilder<meta::List<Es...>> {
 		VkPhysicalDevice phys_device = VK_NULL_HANDLE;
-		std::array<QueueInfo, 3> requested_queues;
+		// One priority per requested queue, indexed by QueueType
+		std::array<std::vector<f32>, kQueueTypeCount> queue_priorities;
+		const VkAllocationCallbacks* allocation_callbacks = nullptr;
+		DeviceFeatureFlags features = 0;
 
 		DeviceBuilder() noexcept = default;
 
-		DeviceBuilder(VkPhysicalDevice device, std::array<QueueInfo, 3> req_qs) noexcept 
+		DeviceBuilder(VkPhysicalDevice device, std::array<std::vector<f32>, kQueueTypeCount> priorities, const VkAllocationCallbacks* callbacks, DeviceFeatureFlags feats) noexcept 
 			: phys_device{ device }
-			, requested_queues{ req_qs }
+			, queue_priorities{ std::move(priorities) }
+			, allocation_callbacks{ callbacks }
+			, features{ feats }
 		{}
 
 		[[nodiscard]]
@@ -138,9 +402,27 @@ namespace gx {
 			return *this;
 		}
 
+		/*
+		* Used for the device, its children and device memory. callbacks must outlive the device.
+		*/
+		[[nodiscard]]
+		DeviceBuilder& with_allocation_callbacks(const VkAllocationCallbacks* callbacks) noexcept {
+			allocation_callbacks = callbacks;
+			return *this;
+		}
+
+		/*
+		* Every feature must be in PhysDeviceInfo::supported_features.
+		*/
+		[[nodiscard]]
+		DeviceBuilder& with_features(DeviceFeatureFlags feats) noexcept {
+			features |= feats;
+			return *this;
+		}
+
 		template<ext::DeviceExt... Es1>
 		auto with_extensions() noexcept {
-			return DeviceBuilder<meta::List<Es1..., Es...>>{ phys_device, requested_queues };
+			return DeviceBuilder<meta::List<Es1..., Es...>>{ phys_device, queue_priorities, allocation_callbacks, features };
 		}
 
 		template<ext::DeviceExt... Es1>
@@ -148,73 +430,181 @@ namespace gx {
 			return with_extensions<Es1...>();
 		}
 
+		/*
+		* Priorities are in [0, 1], a queue with a higher priority may be given more time than the other queues of its family.
+		*/
+		[[nodiscard]]
+		DeviceBuilder& request_queues(QueueType type, std::span<const f32> priorities) noexcept {
+			auto& dst = queue_priorities[std::to_underlying(type)];
+			dst.insert(dst.end(), priorities.begin(), priorities.end());
+			return *this;
+		}
+
 		[[nodiscard]]
-		DeviceBuilder& request_queues(QueueInfo info) noexcept {
-			requested_queues[std::to_underlying(info.type)].count += info.count;
+		DeviceBuilder& request_queues(QueueInfo info, f32 priority = 1.f) noexcept {
+			auto& dst = queue_priorities[std::to_underlying(info.type)];
+			dst.resize(dst.size() + info.count, priority);
 			return *this;
 		}
 
 		[[nodiscard]]
-		DeviceBuilder& request_graphics_queues(usize count = 1) noexcept {
-			return request_queues(QueueInfo{ .type = QueueType::eGraphics, .count = count });
+		DeviceBuilder& request_graphics_queues(usize count = 1, f32 priority = 1.f) noexcept {
+			return request_queues(QueueInfo{ .type = QueueType::eGraphics, .count = count }, priority);
 		}
 
 		[[nodiscard]]
-		DeviceBuilder& request_transfer_queues(usize count = 1) noexcept {
-			return request_queues(QueueInfo{ .type = QueueType::eTransfer, .count = count });
+		DeviceBuilder& request_transfer_queues(usize count = 1, f32 priority = 1.f) noexcept {
+			return request_queues(QueueInfo{ .type = QueueType::eTransfer, .count = count }, priority);
 		}
 
 		[[nodiscard]]
-		DeviceBuilder& request_compute_queues(usize count = 1) noexcept {
-			return request_queues(QueueInfo{ .type = QueueType::eCompute, .count = count });
+		DeviceBuilder& request_compute_queues(usize count = 1, f32 priority = 1.f) noexcept {
+			return request_queues(QueueInfo{ .type = QueueType::eCompute, .count = count }, priority);
 		}
 
+		/*
+		* Types share a family when PhysDeviceInfo has no dedicated one for them. A family gets one VkDeviceQueueCreateInfo
+		* with the requests of all its types, requests beyond its queue count reuse its queues. Types the device
+		* has no family for are skipped, Device::get_queue() returns nullopt for them.
+		*/
 		[[nodiscard]]
 		auto build() const noexcept -> std::expected<Device<meta::List<Es...>>, ErrorCode> {
 			// validate();
 
-			const auto& qi = PhysDeviceInfo::get(phys_device).queue_infos;
-			auto by_count = [](QueueInfo info) noexcept {
-				return info.count != 0;
-			};
-			auto supported_by_device = [&qi](QueueInfo info) noexcept {
-				return std::ranges::find(qi, info.type, &QueueInfo::type) != qi.end();
+			struct FamilyRequest {
+				u32 family = 0;
+				u32 queue_count = 0;
+				std::vector<f32> priorities;
 			};
-			auto rq = requested_queues | std::views::filter(by_count) | std::views::filter(supported_by_device);
 
-			std::array<f32, 16> priors{ 1.f };
-			std::vector<VkDeviceQueueCreateInfo> q_infos;
-			for (auto&& el : rq) {
-				auto queue_index = PhysDeviceInfo::get(phys_device).get_queue_index(el.type);
-				assert(queue_index.has_value() && "TODO: DeviceBuilder::build()");
+			const auto& qi = PhysDeviceInfo::get(phys_device).queue_infos;
+			std::vector<FamilyRequest> families;
+			std::array<details::DeviceQueueSlot, kQueueTypeCount> slots{};
+
+			for (usize type_index = 0; type_index < kQueueTypeCount; ++type_index) {
+				const auto& priorities = queue_priorities[type_index];
+				auto it = std::ranges::find(qi, static_cast<QueueType>(type_index), &QueueInfo::type);
+				if (priorities.empty() || it == qi.end()) {
+					continue;
+				}
+
+				// VUID-VkDeviceQueueCreateInfo-pQueuePriorities-00383
+				assert(std::ranges::all_of(priorities, [](f32 el) { return el >= 0.f && el <= 1.f; }) && "Queue priorities must be in [0, 1]");
+
+				u32 family_index = static_cast<u32>(it->index);
+				auto family = std::ranges::find(families, family_index, &FamilyRequest::family);
+				if (family == families.end()) {
+					families.push_back(FamilyRequest{ .family = family_index, .queue_count = static_cast<u32>(it->count) });
+					family = families.end() - 1;
+				}
+
+				slots[type_index] = details::DeviceQueueSlot{
+					.family = family_index,
+					.first_index = static_cast<u32>(family->priorities.size()),
+					.count = static_cast<u32>(priorities.size()),
+				};
+				family->priorities.insert(family->priorities.end(), priorities.begin(), priorities.end());
+			}
 
+			// VUID-VkDeviceQueueCreateInfo-queueCount-00382, surplus requests share the created queues
+			for (auto& el : families) {
+				el.priorities.resize(std::min<usize>(el.priorities.size(), el.queue_count));
+			}
+			for (auto& el : slots) {
+				if (el.count != 0) {
+					el.family_queue_count = static_cast<u32>(std::ranges::find(families, el.family, &FamilyRequest::family)->priorities.size());
+				}
+			}
+
+			// VUID-VkDeviceCreateInfo-queueFamilyIndex-02802, one create info per family
+			std::vector<VkDeviceQueueCreateInfo> q_infos;
+			q_infos.reserve(families.size());
+			for (const auto& el : families) {
 				q_infos.push_back(VkDeviceQueueCreateInfo {
 					.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-					.queueFamilyIndex = queue_index.value(),
-					.queueCount = static_cast<u32>(el.count),
-					.pQueuePriorities = priors.data()
+					.queueFamilyIndex = el.family,
+					.queueCount = static_cast<u32>(el.priorities.size()),
+					.pQueuePriorities = el.priorities.data()
 				});
 			}
 
-			VkPhysicalDeviceFeatures features{};
+			// vkCreateDevice() would fail with VK_ERROR_FEATURE_NOT_PRESENT
+			assert(PhysDeviceInfo::get(phys_device).supports_features(features) && "Requested device features are not supported");
+
+			VkPhysicalDeviceVulkan12Features features12 = {
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+				.timelineSemaphore = test_bit(features, DeviceFeature::eTimelineSemaphore),
+				.bufferDeviceAddress = test_bit(features, DeviceFeature::eBufferDeviceAddress),
+			};
+			VkPhysicalDeviceVulkan13Features features13 = {
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+				.pNext = &features12,
+				.synchronization2 = test_bit(features, DeviceFeature::eSynchronization2),
+			};
+			VkPhysicalDeviceSynchronization2Features sync2_features = {
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
+				.pNext = &features12,
+				.synchronization2 = VK_TRUE,
+			};
+
+			// VUID-VkDeviceCreateInfo-pNext-pNext, the 1.3 structure is only known to 1.3 devices, older ones get
+			// synchronization2 from VK_KHR_synchronization2
+			bool is_vulkan13 = PhysDeviceInfo::get(phys_device).api_version >= VK_API_VERSION_1_3;
+			bool uses_sync2_ext = !is_vulkan13 && test_bit(features, DeviceFeature::eSynchronization2);
+			void* features_chain = &features12;
+			if (is_vulkan13) {
+				features_chain = &features13;
+			}
+			else if (uses_sync2_ext) {
+				features_chain = &sync2_features;
+			}
+
+			VkPhysicalDeviceFeatures2 features2 = {
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+				.pNext = features_chain,
+				.features = VkPhysicalDeviceFeatures{
+					.sparseBinding = test_bit(features, DeviceFeature::eSparseBinding),
+					.sparseResidencyBuffer = test_bit(features, DeviceFeature::eSparseResidencyBuffer),
+					.sparseResidencyImage2D = test_bit(features, DeviceFeature::eSparseResidencyImage2D),
+					.sparseResidencyImage3D = test_bit(features, DeviceFeature::eSparseResidencyImage3D),
+				},
+			};
 
+			// VUID-VkDeviceCreateInfo-pNext-00373, the features go through features2 and pEnabledFeatures stays null
 			VkDeviceCreateInfo device_info = {
 				.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+				.pNext = &features2,
 				.queueCreateInfoCount = static_cast<u32>(q_infos.size()),
 				.pQueueCreateInfos = q_infos.data(),
-				.pEnabledFeatures = &features,
 			};
 
+			std::vector<const char*> extensions;
 			if constexpr (sizeof...(Es) > 0) {
 				static constexpr std::array kRequiredExts = ext::to_array<Es...>();
-				device_info.enabledExtensionCount = static_cast<u32>(kRequiredExts.size());
-				device_info.ppEnabledExtensionNames = kRequiredExts.data();
+				extensions.assign(kRequiredExts.begin(), kRequiredExts.end());
+			}
+			if (uses_sync2_ext) {
+				extensions.push_back(ext::DeviceExtensionList::kKhrSynchronization2);
+			}
+
+			// Allocator picks the budget up on its own, heap sizes are used without it
+			bool has_memory_budget = meta::SameAsAny<ext::MemoryBudgetExt, Es...>;
+			if (!has_memory_budget && PhysDeviceInfo::get(phys_device).supports_extension<ext::MemoryBudgetExt>()) {
+				extensions.push_back(ext::DeviceExtensionList::kExtMemoryBudget);
+				has_memory_budget = true;
 			}
 
-			DeviceValue device{};
-			VkResult res = vkCreateDevice(phys_device, &device_info, nullptr, &device.handle);
+			device_info.enabledExtensionCount = static_cast<u32>(extensions.size());
+			device_info.ppEnabledExtensionNames = extensions.data();
+
+			DeviceValue device{ VK_NULL_HANDLE, slots };
+			VkResult res = vkCreateDevice(phys_device, &device_info, allocation_callbacks, &device.handle);
 
 			if (res == VK_SUCCESS) {
+				details::register_allocation_callbacks(device.handle, allocation_callbacks);
+				if (has_memory_budget) {
+					details::register_memory_budget(device.handle);
+				}
 				return Device<meta::List<Es...>>{ device };
 			}
 
@@ -280,14 +670,10 @@ namespace gx {
 	constexpr auto filter_by_min_vram_size(usize value) noexcept {
 		return std::views::filter(
 			[value](PhysDevice phys_device) noexcept {
-				const auto& infos = phys_device.get_info().memory_infos;
-				auto it = std::ranges::find_if(infos,
-					[](const auto& el) {
-						return  test_bit(el.memory_properties, MemoryProperties::eDeviceLocal) &&
-							!test_bit(el.memory_properties, MemoryProperties::eHostVisible);
-					});
-
-				return it != infos.end() ? (*it).budget >= value : false;
+				const auto& info = phys_device.get_info();
+				auto types = info.get_memory_types(MemoryUsage::eGpuOnly).get();
+
+				return !types.empty() ? info.memory_infos[types.front()].budget >= value : false;
 			}
 		);
 	}
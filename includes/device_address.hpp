@@ -0,0 +1,170 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <expected>
+#include <type_traits>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	/*
+	* 64-bit pointer to T as a shader sees it, e.g. a `buffer_reference` in GLSL. Meant to be embedded
+	* into structures that are written through DevicePtr, the layout on both sides must match (scalar block layout is the easiest).
+	*/
+	template<typename T>
+	struct DeviceAddress {
+		VkDeviceAddress value = 0;
+
+		[[nodiscard]]
+		constexpr bool operator==(const DeviceAddress&) const noexcept = default;
+	};
+	static_assert(sizeof(DeviceAddress<u32>) == sizeof(VkDeviceAddress));
+
+	/*
+	* count values of T visible to the device at address and to the host at mapped.
+	*/
+	template<typename T>
+	struct DevicePtr {
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be shared with shaders");
+
+		VkDeviceAddress address = 0;
+		T* mapped = nullptr;
+		usize count = 0;
+
+		[[nodiscard]]
+		DeviceAddress<T> get(usize index = 0) const noexcept {
+			assert(index < count && "DevicePtr::get(): index is out of range");
+			return DeviceAddress<T>{ address + index * sizeof(T) };
+		}
+
+		void write(const T& value, usize index = 0) const noexcept {
+			assert(index < count && "DevicePtr::write(): index is out of range");
+			std::memcpy(mapped + index, &value, sizeof(T));
+		}
+
+		void write(std::span<const T> values, usize first = 0) const noexcept {
+			assert(first + values.size() <= count && "DevicePtr::write(): range is out of range");
+			std::memcpy(mapped + first, values.data(), values.size_bytes());
+		}
+	};
+
+	struct DeviceAddressRange {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		usize offset = 0;
+		usize size = 0;
+		VkDeviceAddress address = 0;
+		u8* mapped = nullptr;
+	};
+
+	struct DeviceAddressArenaConfig {
+		usize chunk_size = mb_to_bytes(8);
+		// Host visible presets give mapped pointers, eGpuOnly ranges must be filled with transfers
+		MemoryUsage memory_usage = MemoryUsage::eCpuToGpu;
+		BufferUsageFlags usage = BufferUsage::eShaderDeviceAddress | BufferUsage::eStorage;
+	};
+
+	/*
+	* Linear allocator over buffers with device addresses for pointer-based bindless data. Chunks are created on
+	* demand and kept across reset(), requests larger than chunk_size get a chunk of their own.
+	* Isn't thread safe. The Allocator must be created with AllocatorConfig::use_buffer_device_address.
+	*/
+	class DeviceAddressArena {
+	private:
+		// Destroyed in reverse order, the buffer goes before its memory
+		struct Chunk {
+			OwnedAllocation allocation;
+			OwnedBuffer buffer;
+			VkBuffer handle = VK_NULL_HANDLE;
+			VkDeviceAddress address = 0;
+			u8* mapped = nullptr;
+			usize size = 0;
+		};
+
+		Allocator* allocator_ = nullptr;
+		DeviceAddressArenaConfig config_;
+		std::vector<Chunk> chunks_;
+		usize current_ = 0;
+		usize head_ = 0;
+
+	public:
+		explicit DeviceAddressArena(Allocator& allocator, DeviceAddressArenaConfig config = {}) noexcept
+			: allocator_{ &allocator }
+			, config_{ config }
+		{
+			config_.usage |= BufferUsage::eShaderDeviceAddress;
+		}
+
+		DeviceAddressArena(DeviceAddressArena&&) noexcept = default;
+		DeviceAddressArena& operator=(DeviceAddressArena&&) noexcept = default;
+
+		DeviceAddressArena(const DeviceAddressArena&) = delete;
+		DeviceAddressArena& operator=(const DeviceAddressArena&) = delete;
+
+		/*
+		* alignment must be a power of two.
+		*/
+		[[nodiscard]]
+		auto allocate(usize size, usize alignment = 16) noexcept -> std::expected<DeviceAddressRange, ErrorCode>;
+
+		template<typename T>
+		[[nodiscard]]
+		auto allocate_array(usize count) noexcept -> std::expected<DevicePtr<T>, ErrorCode> {
+			return allocate(sizeof(T) * count, std::max<usize>(alignof(T), 8))
+				.transform(
+					[count](DeviceAddressRange range) noexcept {
+						return DevicePtr<T>{ range.address, reinterpret_cast<T*>(range.mapped), count };
+					}
+				);
+		}
+
+		template<typename T>
+		[[nodiscard]]
+		auto push(const T& value) noexcept -> std::expected<DevicePtr<T>, ErrorCode> {
+			return push(std::span<const T>{ &value, 1 });
+		}
+
+		template<typename T>
+		[[nodiscard]]
+		auto push(std::span<const T> values) noexcept -> std::expected<DevicePtr<T>, ErrorCode> {
+			auto ptr = allocate_array<T>(values.size());
+			if (ptr.has_value()) {
+				assert(ptr->mapped != nullptr && "DeviceAddressArena::push(): memory is not host visible");
+				ptr->write(values);
+			}
+			return ptr;
+		}
+
+		/*
+		* Makes host writes since the last reset() visible to the device, only needed for non-coherent memory.
+		*/
+		[[nodiscard]]
+		auto flush() noexcept -> std::expected<void, ErrorCode>;
+
+		/*
+		* Invalidates every range. The device must be done with all of them.
+		*/
+		void reset() noexcept {
+			current_ = 0;
+			head_ = 0;
+		}
+
+		[[nodiscard]]
+		usize get_capacity() const noexcept;
+
+	private:
+		[[nodiscard]]
+		auto add_chunk_(usize size) noexcept -> std::expected<void, ErrorCode>;
+	};
+}
@@ -20,6 +20,9 @@ namespace gx {
 		eTooManyObjects,
 		eDeviceLost,
 		eQueueNotPresent,
+		eMemoryTypeNotPresent,
+		eOutOfPoolMemory,
+		eInvalidExternalHandle,
 
 		eUnknown,
 	};
@@ -46,6 +49,10 @@ namespace gx {
 			return ErrorCode::eTooManyObjects;
 		case VK_ERROR_DEVICE_LOST:
 			return ErrorCode::eDeviceLost;
+		case VK_ERROR_OUT_OF_POOL_MEMORY:
+			return ErrorCode::eOutOfPoolMemory;
+		case VK_ERROR_INVALID_EXTERNAL_HANDLE:
+			return ErrorCode::eInvalidExternalHandle;
 		}
 
 		return ErrorCode::eUnknown;
@@ -69,6 +76,9 @@ struct eh::ErrorTypeTrait<gx::ErrorCode> {
 		"Too many objects of the type have already been created.",
 		"The logical or physical device has been lost.",
 		"A requested queue is not supported by device.",
+		"No memory type satisfies the requested memory properties.",
+		"A pool or ring has no free space left until older work retires.",
+		"An external handle or host pointer is not valid for the requested import.",
 
 		"Unknown error"
 	};
@@ -85,6 +95,9 @@ struct eh::ErrorTypeTrait<gx::ErrorCode> {
 		"gx::ErrorCode::eTooManyObjects",
 		"gx::ErrorCode::eDeviceLost",
 		"gx::ErrorCode::eQueueNotPresent",
+		"gx::ErrorCode::eMemoryTypeNotPresent",
+		"gx::ErrorCode::eOutOfPoolMemory",
+		"gx::ErrorCode::eInvalidExternalHandle",
 
 		"gx::ErrorCode::eUnknown",
 	};
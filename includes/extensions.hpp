@@ -19,6 +19,7 @@
 #include "types.hpp"
 #include "utils.hpp"
 #include "error.hpp"
+#include "host_allocator.hpp"
 
 namespace gx::ext {
 	struct InstanceExtensionList {
@@ -29,6 +30,11 @@ namespace gx::ext {
 
 	struct DeviceExtensionList {
 		static constexpr const char* kKhrSwapchain = "VK_KHR_swapchain";
+		static constexpr const char* kExtMemoryBudget = "VK_EXT_memory_budget";
+		static constexpr const char* kExtExternalMemoryHost = "VK_EXT_external_memory_host";
+		static constexpr const char* kKhrExternalMemoryFd = "VK_KHR_external_memory_fd";
+		static constexpr const char* kKhrExternalSemaphoreFd = "VK_KHR_external_semaphore_fd";
+		static constexpr const char* kKhrSynchronization2 = "VK_KHR_synchronization2";
 	};
 
 	struct LayerList {
@@ -71,6 +77,16 @@ namespace gx::ext {
 			}
 			return std::nullopt;
 		}
+
+		template<typename FnPtr> requires std::is_pointer_v<FnPtr>
+		static std::optional<FnPtr> load(VkDevice device, std::string_view name) noexcept {
+			auto ret = std::bit_cast<FnPtr>(vkGetDeviceProcAddr(device, name.data()));
+
+			if (ret != nullptr) {
+				return ret;
+			}
+			return std::nullopt;
+		}
 	};
 
 	struct DebugUtilsExt : InstanceExtTag {
@@ -104,7 +120,7 @@ namespace gx::ext {
 		{}
 
 		void destroy() noexcept {
-			DebugUtilsExt::destroy_fn(parent, handle, nullptr);
+			DebugUtilsExt::destroy_fn(parent, handle, get_allocation_callbacks(parent));
 		}
 	};
 	static_assert(Value<DebugUtilsValue>);
@@ -186,7 +202,7 @@ namespace gx::ext {
 			};
 
 			VkDebugUtilsMessengerEXT messenger = VK_NULL_HANDLE;
-			VkResult res = DebugUtilsExt::create_fn(self.instance_, &create_info, nullptr, &messenger);
+			VkResult res = DebugUtilsExt::create_fn(self.instance_, &create_info, get_allocation_callbacks(self.instance_), &messenger);
 
 			if (res == VK_SUCCESS) {
 				return DebugUtilsValue{ self.instance_, messenger };
@@ -226,7 +242,7 @@ namespace gx::ext {
 		{}
 
 		void destroy(this SurfaceValue self) noexcept {
-			vkDestroySurfaceKHR(self.parent, self.handle, nullptr);
+			vkDestroySurfaceKHR(self.parent, self.handle, get_allocation_callbacks(self.parent));
 		}
 	};
 	static_assert(Value<SurfaceValue>);
@@ -244,6 +260,42 @@ namespace gx::ext {
 	};
 	static_assert(DeviceExt<SwapchainExt>);
 
+	struct MemoryBudgetExt : DeviceExtTag {
+		static constexpr auto get() noexcept {
+			return std::array{ DeviceExtensionList::kExtMemoryBudget };
+		}
+
+		static void load(VkInstance instance) noexcept {}
+	};
+	static_assert(DeviceExt<MemoryBudgetExt>);
+
+	struct ExternalMemoryHostExt : DeviceExtTag {
+		static constexpr auto get() noexcept {
+			return std::array{ DeviceExtensionList::kExtExternalMemoryHost };
+		}
+
+		static void load(VkInstance instance) noexcept {}
+	};
+	static_assert(DeviceExt<ExternalMemoryHostExt>);
+
+	struct ExternalMemoryFdExt : DeviceExtTag {
+		static constexpr auto get() noexcept {
+			return std::array{ DeviceExtensionList::kKhrExternalMemoryFd };
+		}
+
+		static void load(VkInstance instance) noexcept {}
+	};
+	static_assert(DeviceExt<ExternalMemoryFdExt>);
+
+	struct ExternalSemaphoreFdExt : DeviceExtTag {
+		static constexpr auto get() noexcept {
+			return std::array{ DeviceExtensionList::kKhrExternalSemaphoreFd };
+		}
+
+		static void load(VkInstance instance) noexcept {}
+	};
+	static_assert(DeviceExt<ExternalSemaphoreFdExt>);
+
 	enum class ColorSpace {
 		eSRGB_Nonlinear,
 	};
@@ -309,7 +361,7 @@ namespace gx::ext {
 		{}
 
 		void destroy(this SwapchainValue self) noexcept {
-			vkDestroySwapchainKHR(self.parent, self.handle, nullptr);
+			vkDestroySwapchainKHR(self.parent, self.handle, get_allocation_callbacks(self.parent));
 		}
 	};
 	static_assert(Value<SwapchainValue>);
@@ -428,7 +480,7 @@ namespace gx::ext {
 			}
 
 			SwapchainValue value{ VK_NULL_HANDLE, device_ };
-			VkResult res = vkCreateSwapchainKHR(device_, &ci, nullptr, &value.handle);
+			VkResult res = vkCreateSwapchainKHR(device_, &ci, get_allocation_callbacks(device_), &value.handle);
 
 			if (res == VK_SUCCESS) {
 				return Swapchain{ value };
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "sync.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	/*
+	* Everything the importing side needs besides the fd to recreate an exported allocation.
+	* Both sides must run on devices with equal PhysDeviceInfo::device_uuid and driver_uuid.
+	*/
+	struct ExternalMemoryDesc {
+		int fd = -1;
+		usize size = 0;
+		u32 memory_type = 0;
+	};
+
+	/*
+	* Exports and imports memory and semaphore payloads as POSIX file descriptors.
+	* The device must be created with ext::ExternalMemoryFdExt and ext::ExternalSemaphoreFdExt.
+	* Exported fds belong to the caller, imported ones to the implementation once the import succeeds.
+	*/
+	class FdInterop {
+	private:
+		VkDevice device_ = VK_NULL_HANDLE;
+		PFN_vkGetMemoryFdKHR get_memory_fd_ = nullptr;
+		PFN_vkGetSemaphoreFdKHR get_semaphore_fd_ = nullptr;
+		PFN_vkImportSemaphoreFdKHR import_semaphore_fd_ = nullptr;
+
+	public:
+		explicit FdInterop(VkDevice device) noexcept;
+
+		[[nodiscard]]
+		bool is_supported() const noexcept {
+			return get_memory_fd_ != nullptr && get_semaphore_fd_ != nullptr && import_semaphore_fd_ != nullptr;
+		}
+
+		/*
+		* allocation must be created with ExternalMemoryHandleType::eOpaqueFd in its export handle types.
+		*/
+		[[nodiscard]]
+		auto export_memory(AllocationView allocation) const noexcept -> std::expected<ExternalMemoryDesc, ErrorCode>;
+
+		/*
+		* A sync fd export of a binary semaphore also unsignals it, so it must be signaled or have a pending signal.
+		*/
+		[[nodiscard]]
+		auto export_semaphore(SemaphoreView semaphore, ExternalSemaphoreHandleType type = ExternalSemaphoreHandleType::eOpaqueFd) const noexcept -> std::expected<int, ErrorCode>;
+
+		/*
+		* A temporary import replaces the payload until the next wait on the semaphore, sync fds can only be imported temporarily.
+		*/
+		[[nodiscard]]
+		auto import_semaphore(SemaphoreView semaphore, int fd, ExternalSemaphoreHandleType type = ExternalSemaphoreHandleType::eOpaqueFd, bool temporary = false) const noexcept -> std::expected<void, ErrorCode>;
+	};
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <span>
+#include <cstring>
+#include <optional>
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	struct TransientAllocation {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		usize offset = 0;
+		usize size = 0;
+		u8* mapped = nullptr;
+
+		[[nodiscard]]
+		u32 get_dynamic_offset() const noexcept {
+			return static_cast<u32>(offset);
+		}
+	};
+
+	struct FrameAllocatorConfig {
+		usize frame_size = mb_to_bytes(4);
+		u32 frames_in_flight = 2;
+		BufferUsageFlags usage = BufferUsage::eUniform | BufferUsage::eStorage | BufferUsage::eVertex | BufferUsage::eIndex;
+	};
+
+	/*
+	* Bump allocator over one persistently mapped host-visible buffer, split into a slice per frame in flight.
+	* Isn't thread safe, use one per recording thread. begin_frame() resets the slice in bulk, so it must only be
+	* called once the GPU has finished the frame that used the slice before.
+	*/
+	class FrameAllocator {
+	private:
+		OwnedAllocation allocation_;
+		OwnedBuffer buffer_;
+		VkBuffer buffer_handle_ = VK_NULL_HANDLE;
+		u8* base_ = nullptr;
+		usize frame_size_ = 0;
+		u32 frames_in_flight_ = 0;
+		usize min_alignment_ = 1;
+		usize frame_begin_ = 0;
+		usize head_ = 0;
+		usize end_ = 0;
+
+	public:
+		FrameAllocator() noexcept = default;
+
+		FrameAllocator(FrameAllocator&&) noexcept = default;
+		FrameAllocator& operator=(FrameAllocator&&) noexcept = default;
+
+		FrameAllocator(const FrameAllocator&) = delete;
+		FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+		[[nodiscard]]
+		static auto create(Allocator& allocator, FrameAllocatorConfig config = {}) noexcept -> std::expected<FrameAllocator, ErrorCode>;
+
+		void begin_frame(u32 frame_index) noexcept {
+			frame_begin_ = (frame_index % frames_in_flight_) * frame_size_;
+			head_ = frame_begin_;
+			end_ = frame_begin_ + frame_size_;
+		}
+
+		/*
+		* alignment must be a power of two. Offsets are always aligned at least to the device's
+		* minUniformBufferOffsetAlignment/minStorageBufferOffsetAlignment, so they can be used as dynamic offsets.
+		*/
+		[[nodiscard]]
+		std::optional<TransientAllocation> allocate(usize size, usize alignment = 1) noexcept {
+			usize offset = align_up(head_, alignment > min_alignment_ ? alignment : min_alignment_);
+			if (offset + size > end_) {
+				return std::nullopt;
+			}
+			head_ = offset + size;
+
+			return TransientAllocation{
+				.buffer = buffer_handle_,
+				.offset = offset,
+				.size = size,
+				.mapped = base_ + offset,
+			};
+		}
+
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		[[nodiscard]]
+		std::optional<TransientAllocation> push(std::span<const T> data, usize alignment = alignof(T)) noexcept {
+			auto allocation = allocate(data.size_bytes(), alignment);
+			if (allocation.has_value()) {
+				std::memcpy(allocation->mapped, data.data(), data.size_bytes());
+			}
+			return allocation;
+		}
+
+		template<typename T> requires std::is_trivially_copyable_v<T>
+		[[nodiscard]]
+		std::optional<TransientAllocation> push(const T& data, usize alignment = alignof(T)) noexcept {
+			return push(std::span<const T>{ &data, 1 }, alignment);
+		}
+
+		[[nodiscard]]
+		usize get_used_bytes() const noexcept {
+			return head_ - frame_begin_;
+		}
+
+		[[nodiscard]]
+		usize get_frame_size() const noexcept {
+			return frame_size_;
+		}
+
+		[[nodiscard]]
+		VkBuffer get_buffer() const noexcept {
+			return buffer_handle_;
+		}
+	};
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <algorithm>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "thread_cache.hpp"
+
+namespace gx {
+	/*
+	* Callbacks installed with InstanceBuilder/DeviceBuilder::with_allocation_callbacks() are remembered per instance
+	* and per device, every vkCreate*, vkDestroy* and vkAllocateMemory call made for them or their children uses them.
+	* The pointed to VkAllocationCallbacks must outlive the instance/device.
+	*/
+	[[nodiscard]]
+	const VkAllocationCallbacks* get_allocation_callbacks(VkInstance instance) noexcept;
+	[[nodiscard]]
+	const VkAllocationCallbacks* get_allocation_callbacks(VkDevice device) noexcept;
+
+	namespace details {
+		void register_allocation_callbacks(VkInstance instance, const VkAllocationCallbacks* callbacks) noexcept;
+		void register_allocation_callbacks(VkDevice device, const VkAllocationCallbacks* callbacks) noexcept;
+		void unregister_allocation_callbacks(VkInstance instance) noexcept;
+		void unregister_allocation_callbacks(VkDevice device) noexcept;
+
+		/*
+		* Every block handed out by the built-in allocators is prefixed with this header, so they can free and
+		* reallocate without knowing the size and can over-align on top of any upstream allocator.
+		*/
+		struct alignas(16) HostBlockHeader {
+			void* raw = nullptr;
+			usize size = 0;
+			u32 tag = 0;
+		};
+
+		[[nodiscard]]
+		void* host_allocate(const VkAllocationCallbacks* upstream, usize size, usize alignment, VkSystemAllocationScope scope, u32 tag) noexcept;
+		void host_free(const VkAllocationCallbacks* upstream, void* ptr) noexcept;
+
+		[[nodiscard]]
+		inline HostBlockHeader& get_host_block_header(void* ptr) noexcept {
+			return *(static_cast<HostBlockHeader*>(ptr) - 1);
+		}
+	}
+
+	enum class HostAllocationScope : u8 {
+		eCommand = 0,
+		eObject,
+		eCache,
+		eDevice,
+		eInstance,
+		eCount,
+	};
+
+	[[nodiscard]]
+	constexpr HostAllocationScope host_allocation_scope_from_vk(VkSystemAllocationScope scope) noexcept {
+		return static_cast<HostAllocationScope>(scope);
+	}
+	static_assert(host_allocation_scope_from_vk(VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) == HostAllocationScope::eCommand);
+	static_assert(host_allocation_scope_from_vk(VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE) == HostAllocationScope::eInstance);
+
+	struct HostAllocationStats {
+		usize allocation_count = 0;
+		usize reallocation_count = 0;
+		usize free_count = 0;
+		// Bytes currently alive and the maximum since the last reset
+		usize live_bytes = 0;
+		usize peak_bytes = 0;
+		// Allocations the driver made by itself and only reported through internal notifications
+		usize internal_bytes = 0;
+	};
+
+	/*
+	* Forwards to upstream (or malloc) and counts the traffic per VkSystemAllocationScope.
+	*/
+	class TrackingHostAllocator {
+	private:
+		struct Counters {
+			std::atomic<usize> allocation_count = 0;
+			std::atomic<usize> reallocation_count = 0;
+			std::atomic<usize> free_count = 0;
+			std::atomic<usize> live_bytes = 0;
+			std::atomic<usize> peak_bytes = 0;
+			std::atomic<usize> internal_bytes = 0;
+		};
+
+		VkAllocationCallbacks callbacks_{};
+		const VkAllocationCallbacks* upstream_ = nullptr;
+		std::array<Counters, std::to_underlying(HostAllocationScope::eCount)> counters_;
+
+	public:
+		explicit TrackingHostAllocator(const VkAllocationCallbacks* upstream = nullptr) noexcept;
+
+		TrackingHostAllocator(const TrackingHostAllocator&) = delete;
+		TrackingHostAllocator& operator=(const TrackingHostAllocator&) = delete;
+		TrackingHostAllocator(TrackingHostAllocator&&) = delete;
+		TrackingHostAllocator& operator=(TrackingHostAllocator&&) = delete;
+
+		[[nodiscard]]
+		const VkAllocationCallbacks* get_callbacks() const noexcept {
+			return &callbacks_;
+		}
+
+		[[nodiscard]]
+		HostAllocationStats get_stats(HostAllocationScope scope) const noexcept;
+		[[nodiscard]]
+		HostAllocationStats get_total_stats() const noexcept;
+
+		/*
+		* Resets everything but live bytes, peaks restart from the current live bytes.
+		*/
+		void reset_stats() noexcept;
+
+	private:
+		static void* VKAPI_PTR allocate_(void* user_data, usize size, usize alignment, VkSystemAllocationScope scope);
+		static void* VKAPI_PTR reallocate_(void* user_data, void* original, usize size, usize alignment, VkSystemAllocationScope scope);
+		static void VKAPI_PTR free_(void* user_data, void* ptr);
+		static void VKAPI_PTR internal_allocation_(void* user_data, usize size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+		static void VKAPI_PTR internal_free_(void* user_data, usize size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+
+		void on_allocate_(HostAllocationScope scope, usize size) noexcept;
+	};
+
+	/*
+	* Bump allocator over one fixed buffer for creation bursts (e.g. a batch of vkCreateGraphicsPipelines).
+	* Only VK_SYSTEM_ALLOCATION_SCOPE_COMMAND allocations, which die before the call returns, are taken from the arena,
+	* everything else and everything that doesn't fit goes to upstream. Freeing arena memory is a no-op,
+	* reset() reclaims it all and must only be called while no Vulkan command using the callbacks is running.
+	*/
+	class ArenaHostAllocator {
+	private:
+		VkAllocationCallbacks callbacks_{};
+		const VkAllocationCallbacks* upstream_ = nullptr;
+		u8* memory_ = nullptr;
+		usize capacity_ = 0;
+		std::atomic<usize> head_ = 0;
+		std::atomic<usize> fallback_count_ = 0;
+
+	public:
+		explicit ArenaHostAllocator(usize capacity = mb_to_bytes(4), const VkAllocationCallbacks* upstream = nullptr) noexcept;
+		~ArenaHostAllocator() noexcept;
+
+		ArenaHostAllocator(const ArenaHostAllocator&) = delete;
+		ArenaHostAllocator& operator=(const ArenaHostAllocator&) = delete;
+		ArenaHostAllocator(ArenaHostAllocator&&) = delete;
+		ArenaHostAllocator& operator=(ArenaHostAllocator&&) = delete;
+
+		[[nodiscard]]
+		const VkAllocationCallbacks* get_callbacks() const noexcept {
+			return &callbacks_;
+		}
+
+		void reset() noexcept {
+			head_.store(0, std::memory_order_release);
+		}
+
+		[[nodiscard]]
+		usize get_used_bytes() const noexcept {
+			return std::min(head_.load(std::memory_order_relaxed), capacity_);
+		}
+
+		/*
+		* Number of command scope allocations that didn't fit into the arena.
+		*/
+		[[nodiscard]]
+		usize get_fallback_count() const noexcept {
+			return fallback_count_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		static void* VKAPI_PTR allocate_(void* user_data, usize size, usize alignment, VkSystemAllocationScope scope);
+		static void* VKAPI_PTR reallocate_(void* user_data, void* original, usize size, usize alignment, VkSystemAllocationScope scope);
+		static void VKAPI_PTR free_(void* user_data, void* ptr);
+
+		[[nodiscard]]
+		bool owns_(const void* ptr) const noexcept {
+			return ptr >= memory_ && ptr < memory_ + capacity_;
+		}
+	};
+
+	/*
+	* Size-class free lists for the small, frequent allocations drivers make while creating objects.
+	* Each thread keeps its own lists, so the common path takes no lock. Memory is carved out of chunks
+	* that are released only with the pool; blocks larger than kMaxPooledSize go to upstream.
+	*/
+	class PoolHostAllocator {
+	public:
+		static constexpr usize kMinPooledSize = 16;
+		static constexpr usize kMaxPooledSize = 4096;
+		static constexpr usize kClassCount = 9;
+		static constexpr usize kChunkSize = kb_to_bytes(64);
+		static constexpr usize kMaxPooledAlignment = 16;
+
+	private:
+		struct FreeBlock {
+			FreeBlock* next = nullptr;
+		};
+
+		struct SharedClass {
+			std::mutex mutex;
+			FreeBlock* head = nullptr;
+		};
+
+		// Free lists each thread keeps per pool, handed back to the pool when the thread exits
+		struct ThreadCache;
+		static thread_local details::ThreadCacheMap<PoolHostAllocator, ThreadCache> t_caches_;
+
+		VkAllocationCallbacks callbacks_{};
+		const VkAllocationCallbacks* upstream_ = nullptr;
+		u64 id_ = 0;
+
+		std::mutex chunks_mutex_;
+		std::vector<void*> chunks_;
+		// Blocks freed by threads that never allocated from the pool and blocks of exited threads
+		std::array<SharedClass, kClassCount> shared_;
+
+	public:
+		explicit PoolHostAllocator(const VkAllocationCallbacks* upstream = nullptr) noexcept;
+		~PoolHostAllocator() noexcept;
+
+		PoolHostAllocator(const PoolHostAllocator&) = delete;
+		PoolHostAllocator& operator=(const PoolHostAllocator&) = delete;
+		PoolHostAllocator(PoolHostAllocator&&) = delete;
+		PoolHostAllocator& operator=(PoolHostAllocator&&) = delete;
+
+		[[nodiscard]]
+		const VkAllocationCallbacks* get_callbacks() const noexcept {
+			return &callbacks_;
+		}
+
+	private:
+		static void* VKAPI_PTR allocate_(void* user_data, usize size, usize alignment, VkSystemAllocationScope scope);
+		static void* VKAPI_PTR reallocate_(void* user_data, void* original, usize size, usize alignment, VkSystemAllocationScope scope);
+		static void VKAPI_PTR free_(void* user_data, void* ptr);
+
+		[[nodiscard]]
+		void* allocate_pooled_(u32 size_class) noexcept;
+		void free_pooled_(void* ptr, u32 size_class) noexcept;
+		[[nodiscard]]
+		FreeBlock* refill_(u32 size_class) noexcept;
+		void push_shared_(u32 size_class, FreeBlock* head, FreeBlock* tail) noexcept;
+	};
+}
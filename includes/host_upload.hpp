@@ -0,0 +1,87 @@
+#pragma once
+
+#include <span>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+#include "staging.hpp"
+
+namespace gx {
+	struct HostUploaderConfig {
+		// Needs a device created with ext::ExternalMemoryHostExt, uploads fall back to staging without it
+		bool import_host_memory = false;
+		// Smaller uploads are cheaper to copy into the staging ring than to import
+		usize min_import_size = kb_to_bytes(256);
+	};
+
+	enum class UploadPath : u8 {
+		eImported = 0,
+		eStaged,
+	};
+
+	/*
+	* Uploads user memory to buffers. With VK_EXT_external_memory_host the pages holding the data are imported
+	* as VkDeviceMemory and copied from directly, otherwise (or if the import fails) the data goes through the staging ring.
+	* Imported data must stay alive and unmodified until retire() passes the value given to submit().
+	*/
+	class HostUploader {
+	private:
+		// Destroyed in reverse order, the buffer goes before its memory
+		struct Import {
+			u64 retire_value = 0;
+			OwnedAllocation allocation;
+			OwnedBuffer buffer;
+		};
+
+		Allocator* allocator_ = nullptr;
+		StagingRing* staging_ = nullptr;
+		HostUploaderConfig config_;
+		usize import_alignment_ = 0;
+		PFN_vkGetMemoryHostPointerPropertiesEXT get_host_pointer_properties_ = nullptr;
+
+		std::mutex mutex_;
+		std::vector<Import> recorded_;
+		std::vector<StagingTicket> staged_;
+		std::deque<Import> in_flight_;
+
+	public:
+		HostUploader(Allocator& allocator, StagingRing& staging, HostUploaderConfig config = {}) noexcept;
+
+		HostUploader(const HostUploader&) = delete;
+		HostUploader& operator=(const HostUploader&) = delete;
+		HostUploader(HostUploader&&) = delete;
+		HostUploader& operator=(HostUploader&&) = delete;
+
+		[[nodiscard]]
+		bool can_import(std::span<const std::byte> data) const noexcept {
+			return import_alignment_ != 0 && data.size() >= config_.min_import_size;
+		}
+
+		/*
+		* Returns eOutOfPoolMemory if the data has to be staged and the staging ring is full.
+		*/
+		[[nodiscard]]
+		auto record_upload(VkCommandBuffer cmd, std::span<const std::byte> data, BufferView dst, usize dst_offset = 0) noexcept -> std::expected<UploadPath, ErrorCode>;
+
+		/*
+		* Closes everything recorded so far, for both paths. Forwards the staged regions to StagingRing::submit().
+		*/
+		void submit(u64 retire_value) noexcept;
+		void retire(u64 completed_value) noexcept;
+
+	private:
+		[[nodiscard]]
+		auto import_(std::span<const std::byte> data) noexcept -> std::expected<std::pair<Import, usize>, ErrorCode>;
+	};
+}
@@ -3,6 +3,7 @@
 #include <vector>
 #include <array>
 #include <expected>
+#include <cassert>
 
 #include <misc/types.hpp>
 #include <misc/meta.hpp>
@@ -11,6 +12,7 @@
 #include "device.hpp"
 #include "extensions.hpp"
 #include "error.hpp"
+#include "host_allocator.hpp"
 
 namespace gx {
 	struct ImageImpl {};
@@ -27,7 +29,7 @@ namespace gx {
 		{}
 
 		void destroy() noexcept {
-			vkDestroyImage(parent, handle, nullptr);
+			vkDestroyImage(parent, handle, get_allocation_callbacks(parent));
 		}
 	};
 	static_assert(Value<ImageValue>);
@@ -35,7 +37,7 @@ namespace gx {
 	using Image = ManagableType<ImageValue, ImageImpl>;
 	using ImageView = decltype(std::declval<Image&>().get_view());
 
-	std::vector<ImageView> get_images_from_swapchain(ext::SwapchainView swapchain) noexcept {
+	inline std::vector<ImageView> get_images_from_swapchain(ext::SwapchainView swapchain) noexcept {
 		u32 count = 0;
 		vkGetSwapchainImagesKHR(swapchain.get_parent(), swapchain.get_handle(), &count, nullptr);
 		std::vector<VkImage> images(count);
@@ -50,6 +52,224 @@ namespace gx {
 			std::ranges::to<std::vector>();
 	}
 
+	using OwnedImage = OwnedType<ImageValue, ImageImpl, MoveOnlyTag, ViewableTag>;
+
+	enum class ImageType {
+		e1D,
+		e2D,
+		e3D,
+	};
+
+	[[nodiscard]]
+	constexpr VkImageType image_type_to_vk(ImageType type) noexcept {
+		return static_cast<VkImageType>(std::to_underlying(type));
+	}
+	static_assert(VK_IMAGE_TYPE_1D == image_type_to_vk(ImageType::e1D));
+	static_assert(VK_IMAGE_TYPE_2D == image_type_to_vk(ImageType::e2D));
+	static_assert(VK_IMAGE_TYPE_3D == image_type_to_vk(ImageType::e3D));
+
+	enum class ImageLayout {
+		eUndefined,
+		eGeneral,
+		eColorAttachment,
+		eDepthStencilAttachment,
+		eShaderReadOnly,
+		eTransferSrc,
+		eTransferDst,
+		ePresentSrc,
+		eCount,
+	};
+
+	[[nodiscard]]
+	constexpr VkImageLayout image_layout_to_vk(ImageLayout layout) noexcept {
+		constexpr std::array kLayouts = {
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+		};
+		static_assert(kLayouts.size() == std::to_underlying(ImageLayout::eCount));
+		return kLayouts[std::to_underlying(layout)];
+	}
+	static_assert(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL == image_layout_to_vk(ImageLayout::eShaderReadOnly));
+	static_assert(VK_IMAGE_LAYOUT_PRESENT_SRC_KHR == image_layout_to_vk(ImageLayout::ePresentSrc));
+
+	struct [[nodiscard]] ImageBuilder {
+	private:
+		VkDevice device_ = VK_NULL_HANDLE;
+		ImageType type_ = ImageType::e2D;
+		Format format_ = Format::eUndefined;
+		Extent2D extent_{ 0, 0 };
+		u32 depth_ = 1;
+		u32 mip_levels_ = 1;
+		u32 array_layers_ = 1;
+		ImageUsageFlags usage_ = 0;
+		bool is_linear_ = false;
+		SharingMode sharing_mode_ = SharingMode::eExclusive;
+		std::vector<u32> queue_family_indices_;
+		ExternalMemoryHandleTypeFlags external_handle_types_ = 0;
+		bool is_sparse_resident_ = false;
+
+	public:
+		ImageBuilder(VkDevice device) noexcept
+			: device_{ device }
+		{}
+
+		[[nodiscard]]
+		ImageBuilder& with_type(ImageType type) noexcept {
+			type_ = type;
+			return *this;
+		}
+
+		[[nodiscard]]
+		ImageBuilder& with_format(Format format) noexcept {
+			format_ = format;
+			return *this;
+		}
+
+		[[nodiscard]]
+		ImageBuilder& with_extent(Extent2D extent, u32 depth = 1) noexcept {
+			extent_ = extent;
+			depth_ = depth;
+			return *this;
+		}
+
+		[[nodiscard]]
+		ImageBuilder& with_mip_levels(u32 count) noexcept {
+			mip_levels_ = count;
+			return *this;
+		}
+
+		[[nodiscard]]
+		ImageBuilder& with_array_layers(u32 count) noexcept {
+			array_layers_ = count;
+			return *this;
+		}
+
+		[[nodiscard]]
+		ImageBuilder& with_usage(ImageUsageFlags usage) noexcept {
+			usage_ = usage;
+			return *this;
+		}
+
+		[[nodiscard]]
+		ImageBuilder& set_linear_tiling(bool linear) noexcept {
+			is_linear_ = linear;
+			return *this;
+		}
+
+		[[nodiscard]]
+		ImageBuilder& with_queue_indices(std::vector<u32>&& indices) noexcept {
+			if (indices.size() > 1) {
+				sharing_mode_ = SharingMode::eConcurrent;
+			}
+			queue_family_indices_ = std::move(indices);
+
+			return *this;
+		}
+
+		/*
+		* The image may only be bound to memory imported or exported with one of these handle types.
+		*/
+		[[nodiscard]]
+		ImageBuilder& with_external_handle_types(ExternalMemoryHandleTypeFlags types) noexcept {
+			external_handle_types_ = types;
+			return *this;
+		}
+
+		/*
+		* Partially resident image, memory is bound per tile with gx::SparseResidencyManager.
+		*/
+		[[nodiscard]]
+		ImageBuilder& set_sparse_residency(bool sparse) noexcept {
+			is_sparse_resident_ = sparse;
+			return *this;
+		}
+
+		[[nodiscard]]
+		Extent2D get_extent() const noexcept {
+			return extent_;
+		}
+
+		[[nodiscard]]
+		u32 get_depth() const noexcept {
+			return depth_;
+		}
+
+		[[nodiscard]]
+		u32 get_mip_levels() const noexcept {
+			return mip_levels_;
+		}
+
+		[[nodiscard]]
+		u32 get_array_layers() const noexcept {
+			return array_layers_;
+		}
+
+		[[nodiscard]]
+		VkImageCreateInfo to_vk() const noexcept {
+			VkImageCreateInfo ci = {
+				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+				.flags = is_sparse_resident_ ? VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT : 0u,
+				.imageType = image_type_to_vk(type_),
+				.format = format_to_vk(format_),
+				.extent = VkExtent3D{ extent_.width, extent_.height, depth_ },
+				.mipLevels = mip_levels_,
+				.arrayLayers = array_layers_,
+				.samples = VK_SAMPLE_COUNT_1_BIT,
+				.tiling = is_linear_ ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL,
+				.usage = image_usage_to_vk(usage_),
+				.sharingMode = sharing_mode_to_vk(sharing_mode_),
+				.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			};
+
+			if (!queue_family_indices_.empty()) {
+				ci.queueFamilyIndexCount = static_cast<u32>(queue_family_indices_.size());
+				ci.pQueueFamilyIndices = queue_family_indices_.data();
+			}
+			return ci;
+		}
+
+		/*
+		* Creates an image without memory. Bind it with gx::Allocator or gx::AliasingPlanner.
+		*/
+		[[nodiscard]]
+		auto build() const noexcept -> std::expected<Image, ErrorCode> {
+			validate();
+
+			VkExternalMemoryImageCreateInfo external_info = {
+				.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+				.handleTypes = external_memory_handle_types_to_vk(external_handle_types_),
+			};
+
+			VkImageCreateInfo ci = to_vk();
+			ci.pNext = external_handle_types_ != 0 ? &external_info : nullptr;
+			ImageValue value{ VK_NULL_HANDLE, device_ };
+			VkResult res = vkCreateImage(device_, &ci, get_allocation_callbacks(device_), &value.handle);
+
+			if (res == VK_SUCCESS) {
+				return Image{ value };
+			}
+			return std::unexpected(convert_vk_result(res));
+		}
+
+	private:
+		void validate() const noexcept {
+			// VUID-VkImageCreateInfo-format-00943
+			assert(format_ != Format::eUndefined && "format_ must not be Format::eUndefined");
+			// VUID-VkImageCreateInfo-extent-00944
+			assert(extent_.width != 0 && extent_.height != 0 && depth_ != 0 && "extent_ must not be 0");
+			// VUID-VkImageCreateInfo-usage-requiredbitmask
+			assert(usage_ != 0 && "usage_ must not be 0");
+			// Sparse image blocks are only defined for optimal tiling
+			assert(!(is_sparse_resident_ && is_linear_) && "Sparse resident images must use optimal tiling");
+		}
+	};
+
 	struct ImageRefImpl {};
 
 	struct [[nodiscard]] ImageRefValue {
@@ -64,7 +284,7 @@ namespace gx {
 		{}
 
 		void destroy() noexcept {
-			vkDestroyImageView(parent, handle, nullptr);
+			vkDestroyImageView(parent, handle, get_allocation_callbacks(parent));
 		}
 	};
 	static_assert(Value<ImageRefValue>);
@@ -241,6 +461,47 @@ namespace gx {
 	static_assert((ImageAspect::eDepth | ImageAspect::eStencil) == image_aspect_flags_from_vk(VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT));
 	static_assert((ImageAspect::eDepth | ImageAspect::eStencil | ImageAspect::eColor) == image_aspect_flags_from_vk(VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT | VK_IMAGE_ASPECT_COLOR_BIT));
 
+	[[nodiscard]]
+	constexpr ImageAspectFlags get_format_aspects(Format format) noexcept {
+		switch (format) {
+		case Format::eD32_SFLOAT:
+			return std::to_underlying(ImageAspect::eDepth);
+		case Format::eD24_UNORM_S8_UINT:
+			return ImageAspect::eDepth | ImageAspect::eStencil;
+		default:
+			return std::to_underlying(ImageAspect::eColor);
+		}
+	}
+
+	/*
+	* Bytes per texel of one aspect in a buffer copied to or from an image of the format.
+	* Depth/stencil images are copied an aspect at a time, D24 depth texels are padded to 32 bits.
+	*/
+	[[nodiscard]]
+	constexpr u32 get_format_copy_size(Format format, ImageAspect aspect = ImageAspect::eColor) noexcept {
+		switch (format) {
+		case Format::eBGRA8_SRGB:
+		case Format::eBGRA8_UNORM:
+		case Format::eRGBA8_SRGB:
+		case Format::eRGBA8_UNORM:
+		case Format::eR32_SFLOAT:
+		case Format::eD32_SFLOAT:
+			return 4;
+		case Format::eR8_UNORM:
+			return 1;
+		case Format::eRGBA16_SFLOAT:
+			return 8;
+		case Format::eRGBA32_SFLOAT:
+			return 16;
+		case Format::eD24_UNORM_S8_UINT:
+			return aspect == ImageAspect::eStencil ? 1 : 4;
+		default:
+			return 0;
+		}
+	}
+	static_assert(get_format_copy_size(Format::eRGBA16_SFLOAT) == 8);
+	static_assert(get_format_copy_size(Format::eD24_UNORM_S8_UINT, ImageAspect::eStencil) == 1);
+
 	struct ImageSubresourceRange {
 		ImageAspectFlags aspect_mask = std::to_underlying(ImageAspect::eColor);
 		u32 base_mip_level = 0;
@@ -341,7 +602,7 @@ namespace gx {
 			};
 
 			ImageRefValue image_ref{ VK_NULL_HANDLE, device.get_handle() };
-			VkResult res = vkCreateImageView(image_ref.parent, &ci, nullptr, &image_ref.handle);
+			VkResult res = vkCreateImageView(image_ref.parent, &ci, get_allocation_callbacks(image_ref.parent), &image_ref.handle);
 
 			if (res == VK_SUCCESS) {
 				return ImageRef{ image_ref };
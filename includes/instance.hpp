@@ -4,6 +4,7 @@
 #include "types.hpp"
 #include "device.hpp"
 #include "extensions.hpp"
+#include "host_allocator.hpp"
 
 #include <string_view>
 #include <vector>
@@ -66,7 +67,8 @@ namespace gx {
 		{}
 
 		void destroy() noexcept {
-			vkDestroyInstance(handle, nullptr);
+			vkDestroyInstance(handle, get_allocation_callbacks(handle));
+			details::unregister_allocation_callbacks(handle);
 		}
 	};
 	static_assert(Value<InstanceValue>);
@@ -121,36 +123,46 @@ namespace gx {
 		std::string_view engine_name = "unknown";
 		Version engine_version = Version::get_graphx_version();
 		Version vulkan_version = Version::get_target_vulkan_version();
+		const VkAllocationCallbacks* allocation_callbacks = nullptr;
 
 		constexpr InstanceBuilder() noexcept = default;
 
-		constexpr InstanceBuilder(std::string_view app_n, Version app_v, std::string_view engine_n, Version engine_v, Version vulkan_v) noexcept 
+		constexpr InstanceBuilder(std::string_view app_n, Version app_v, std::string_view engine_n, Version engine_v, Version vulkan_v, const VkAllocationCallbacks* callbacks) noexcept 
 			: app_name{ app_n }
 			, app_version{ app_v }
 			, engine_name{ engine_n }
 			, engine_version{ engine_v }
 			, vulkan_version{ vulkan_v }
+			, allocation_callbacks{ callbacks }
 		{}
 
 		[[nodiscard]]
 		constexpr InstanceBuilder with_app_info(std::string_view name, Version version) const noexcept {
-			return InstanceBuilder{ name, version, engine_name, engine_version, vulkan_version };
+			return InstanceBuilder{ name, version, engine_name, engine_version, vulkan_version, allocation_callbacks };
 		}
 
 		[[nodiscard]]
 		constexpr InstanceBuilder with_engine_info(std::string_view name, Version version) const noexcept {
-			return InstanceBuilder{ app_name, app_version, name, version, vulkan_version };
+			return InstanceBuilder{ app_name, app_version, name, version, vulkan_version, allocation_callbacks };
 		}
 
 		[[nodiscard]]
 		constexpr InstanceBuilder with_vulkan_version(Version version) const noexcept {
-			return InstanceBuilder{ app_name, app_version, engine_name, engine_version, version };
+			return InstanceBuilder{ app_name, app_version, engine_name, engine_version, version, allocation_callbacks };
+		}
+
+		/*
+		* Used for the instance and its children (surfaces, debug messengers). callbacks must outlive the instance.
+		*/
+		[[nodiscard]]
+		constexpr InstanceBuilder with_allocation_callbacks(const VkAllocationCallbacks* callbacks) const noexcept {
+			return InstanceBuilder{ app_name, app_version, engine_name, engine_version, vulkan_version, callbacks };
 		}
 
 		template<ext::InstanceExt... Es1>
 		[[nodiscard]]
 		constexpr auto with_extensions() const noexcept {
-			return InstanceBuilder<meta::List<Es1..., Es...>, meta::List<Ls...>>{ app_name, app_version, engine_name, engine_version, vulkan_version };
+			return InstanceBuilder<meta::List<Es1..., Es...>, meta::List<Ls...>>{ app_name, app_version, engine_name, engine_version, vulkan_version, allocation_callbacks };
 		}
 
 		template<ext::InstanceExt... Es1>
@@ -162,7 +174,7 @@ namespace gx {
 		template<typename... Ls1>
 		[[nodiscard]]
 		constexpr auto with_layers() const noexcept {
-			return InstanceBuilder<meta::List<Es...>, meta::List<Ls1..., Ls...>>{ app_name, app_version, engine_name, engine_version, vulkan_version };
+			return InstanceBuilder<meta::List<Es...>, meta::List<Ls1..., Ls...>>{ app_name, app_version, engine_name, engine_version, vulkan_version, allocation_callbacks };
 		}
 
 		template<typename... Ls1>
@@ -206,9 +218,10 @@ namespace gx {
 			}
 
 			InstanceValue value{};
-			VkResult res = vkCreateInstance(&inst_create_info, nullptr, &value.handle);
+			VkResult res = vkCreateInstance(&inst_create_info, allocation_callbacks, &value.handle);
 
 			if (res == VK_SUCCESS) {
+				details::register_allocation_callbacks(value.handle, allocation_callbacks);
 				(Es::load(value.handle), ...);
 				return Instance<meta::List<Es...>, meta::List<Ls...>>{ value };
 			}
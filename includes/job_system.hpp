@@ -0,0 +1,179 @@
+#pragma once
+
+#include <bit>
+#include <array>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+
+namespace gx {
+	namespace details {
+		struct Job {
+			void (*fn)(void* data, u32 index, u32 thread_index) noexcept = nullptr;
+			void* data = nullptr;
+			u32 index = 0;
+			std::atomic<u32>* remaining = nullptr;
+		};
+
+		/*
+		* Chase-Lev deque of fixed capacity. The owner pushes and pops at the bottom, other threads steal from the top.
+		*/
+		class WorkStealingDeque {
+		public:
+			static constexpr i64 kCapacity = 4096;
+
+		private:
+			alignas(64) std::atomic<i64> top_ = 0;
+			alignas(64) std::atomic<i64> bottom_ = 0;
+			std::array<std::atomic<Job*>, kCapacity> jobs_{};
+
+		public:
+			/*
+			* Owner only. Returns false if the deque is full.
+			*/
+			[[nodiscard]]
+			bool push(Job* job) noexcept {
+				i64 b = bottom_.load(std::memory_order_relaxed);
+				i64 t = top_.load(std::memory_order_acquire);
+				if (b - t >= kCapacity) {
+					return false;
+				}
+				jobs_[b & (kCapacity - 1)].store(job, std::memory_order_relaxed);
+				bottom_.store(b + 1, std::memory_order_release);
+				return true;
+			}
+
+			/*
+			* Owner only.
+			*/
+			[[nodiscard]]
+			Job* pop() noexcept {
+				i64 b = bottom_.load(std::memory_order_relaxed) - 1;
+				bottom_.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				i64 t = top_.load(std::memory_order_relaxed);
+
+				if (t > b) {
+					bottom_.store(b + 1, std::memory_order_relaxed);
+					return nullptr;
+				}
+
+				Job* job = jobs_[b & (kCapacity - 1)].load(std::memory_order_relaxed);
+				if (t == b) {
+					// Last job, races with thieves
+					if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+						job = nullptr;
+					}
+					bottom_.store(b + 1, std::memory_order_relaxed);
+				}
+				return job;
+			}
+
+			[[nodiscard]]
+			Job* steal() noexcept {
+				i64 t = top_.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				i64 b = bottom_.load(std::memory_order_acquire);
+
+				if (t >= b) {
+					return nullptr;
+				}
+
+				Job* job = jobs_[t & (kCapacity - 1)].load(std::memory_order_relaxed);
+				if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+					return nullptr;
+				}
+				return job;
+			}
+		};
+		static_assert(std::has_single_bit(static_cast<u64>(WorkStealingDeque::kCapacity)));
+	}
+
+	/*
+	* Fixed set of worker threads with one work-stealing deque each. Threads waiting for their jobs execute jobs
+	* themselves, so jobs may start nested parallel work. Thread index 0 belongs to threads outside the system,
+	* which submit one at a time, workers have indices 1..worker_count. Per-thread resources can be indexed with it.
+	*/
+	class JobSystem {
+	private:
+		std::vector<std::unique_ptr<details::WorkStealingDeque>> deques_;
+		std::vector<std::jthread> workers_;
+		std::mutex external_mutex_;
+		std::atomic<u32> epoch_ = 0;
+		std::atomic<u32> sleeping_count_ = 0;
+		std::atomic<bool> is_stopping_ = false;
+
+	public:
+		/*
+		* Defaults to one worker per hardware thread besides the calling one.
+		*/
+		explicit JobSystem(u32 worker_count = get_default_worker_count()) noexcept;
+		~JobSystem() noexcept;
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		JobSystem(JobSystem&&) = delete;
+		JobSystem& operator=(JobSystem&&) = delete;
+
+		[[nodiscard]]
+		static u32 get_default_worker_count() noexcept {
+			u32 count = std::thread::hardware_concurrency();
+			return count > 1 ? count - 1 : 1;
+		}
+
+		/*
+		* Workers plus the external thread slot.
+		*/
+		[[nodiscard]]
+		u32 get_thread_count() const noexcept {
+			return static_cast<u32>(deques_.size());
+		}
+
+		/*
+		* Index of the calling thread, 0 for threads outside the system.
+		*/
+		[[nodiscard]]
+		u32 get_thread_index() const noexcept;
+
+		/*
+		* Calls f(index, thread_index) for every index in [0, count) and returns once all calls have returned.
+		*/
+		template<typename F>
+		void parallel_for(u32 count, F&& f) noexcept {
+			if (count == 0) {
+				return;
+			}
+
+			using Fn = std::remove_reference_t<F>;
+			std::atomic<u32> remaining = count;
+			std::vector<details::Job> jobs(count);
+			for (u32 i = 0; i < count; ++i) {
+				jobs[i] = details::Job{
+					.fn = [](void* data, u32 index, u32 thread_index) noexcept {
+						(*static_cast<Fn*>(data))(index, thread_index);
+					},
+					.data = const_cast<void*>(static_cast<const void*>(std::addressof(f))),
+					.index = i,
+					.remaining = &remaining,
+				};
+			}
+			run_(jobs, remaining);
+		}
+
+	private:
+		void run_(std::vector<details::Job>& jobs, std::atomic<u32>& remaining) noexcept;
+		void worker_loop_(u32 thread_index) noexcept;
+		void wake_workers_() noexcept;
+
+		[[nodiscard]]
+		details::Job* find_job_(u32 thread_index) noexcept;
+		static void execute_(details::Job* job, u32 thread_index) noexcept;
+	};
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <expected>
+#include <algorithm>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "error.hpp"
+#include "cmd_exec.hpp"
+#include "cmd_recorder.hpp"
+#include "job_system.hpp"
+
+namespace gx {
+	struct ParallelRecordInfo {
+		u32 queue_family = 0;
+		u32 item_count = 0;
+		// Items recorded into one secondary command buffer, a few chunks per thread balance uneven items well
+		u32 chunk_size = 256;
+		// Describes the render pass or, with VkCommandBufferInheritanceRenderingInfo chained, the dynamic rendering
+		// the primary is in. Recording outside of rendering needs a zeroed inheritance info
+		const VkCommandBufferInheritanceInfo* inheritance = nullptr;
+		bool continues_rendering = true;
+	};
+
+	/*
+	* Splits [0, item_count) into chunks and calls record(recorder, first, count) for each of them on the job system,
+	* every chunk goes into its own secondary command buffer from the recording thread's pools. The secondaries are
+	* executed in the primary in chunk order, so the result doesn't depend on scheduling.
+	* Inside of rendering the primary must be in a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	* or in vkCmdBeginRendering() with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT.
+	* Returns the summed counters of the recorders.
+	*/
+	template<typename F>
+	[[nodiscard]]
+	auto record_parallel(
+		JobSystem& jobs,
+		CommandAllocator& allocator,
+		VkCommandBuffer primary,
+		const ParallelRecordInfo& info,
+		F&& record
+	) noexcept -> std::expected<CommandRecorderStats, ErrorCode> {
+		// VUID-vkBeginCommandBuffer-commandBuffer-00051
+		assert(info.inheritance != nullptr && "record_parallel(): secondary command buffers require inheritance info");
+		assert(info.chunk_size != 0 && "record_parallel(): chunk_size must be greater than 0");
+
+		u32 chunk_count = (info.item_count + info.chunk_size - 1) / info.chunk_size;
+		std::vector<VkCommandBuffer> secondaries(chunk_count, VK_NULL_HANDLE);
+		std::vector<ErrorCode> errors(chunk_count, ErrorCode::eSuccess);
+		std::vector<CommandRecorderStats> stats(chunk_count);
+
+		VkCommandBufferUsageFlags flags = info.continues_rendering ? VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT : 0;
+
+		jobs.parallel_for(chunk_count,
+			[&](u32 chunk, [[maybe_unused]] u32 thread_index) noexcept {
+				auto cmd = allocator.begin(info.queue_family, CommandBufferLevel::eSecondary, info.inheritance, flags);
+				if (!cmd.has_value()) {
+					errors[chunk] = cmd.error();
+					return;
+				}
+
+				CommandRecorder recorder{ *cmd };
+				u32 first = chunk * info.chunk_size;
+				record(recorder, first, std::min(info.chunk_size, info.item_count - first));
+
+				VkResult res = vkEndCommandBuffer(*cmd);
+				if (res != VK_SUCCESS) {
+					errors[chunk] = convert_vk_result(res);
+					return;
+				}
+				secondaries[chunk] = *cmd;
+				stats[chunk] = recorder.get_stats();
+			}
+		);
+
+		if (auto it = std::ranges::find_if(errors, [](ErrorCode error) { return error != ErrorCode::eSuccess; }); it != errors.end()) {
+			return std::unexpected(*it);
+		}
+
+		CommandRecorderStats ret;
+		for (const auto& el : stats) {
+			ret.issued_count += el.issued_count;
+			ret.elided_count += el.elided_count;
+		}
+
+		if (chunk_count != 0) {
+			vkCmdExecuteCommands(primary, chunk_count, secondaries.data());
+		}
+		return ret;
+	}
+}
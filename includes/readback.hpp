@@ -0,0 +1,154 @@
+#pragma once
+
+#include <span>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <future>
+#include <optional>
+#include <expected>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "image.hpp"
+#include "buffer.hpp"
+#include "sync.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	/*
+	* data is only valid during the callback. Image rows are tightly packed, row_pitch is width * texel size of the aspect
+	* and layers follow each other. Buffer readbacks have an undefined format and a zero extent.
+	*/
+	struct ReadbackResult {
+		std::span<const std::byte> data;
+		Format format = Format::eUndefined;
+		Extent2D extent{ 0, 0 };
+		u32 row_pitch = 0;
+		u32 layer_count = 1;
+	};
+
+	using ReadbackCallback = std::move_only_function<void(const ReadbackResult&)>;
+
+	struct ReadbackRingConfig {
+		usize size = mb_to_bytes(16);
+		usize alignment = 16;
+	};
+
+	/*
+	* Device to host copies into one persistently mapped ring in eReadbackCached memory. Copies are recorded into
+	* the caller's command buffers together with a barrier that makes them visible to the host, closed with submit()
+	* per command buffer and delivered by poll() once their retire value has completed, so the render thread never
+	* waits for the GPU. The commands that wrote the source must be made visible to the transfer stage by the caller,
+	* images must be in eTransferSrc or eGeneral layout. The device must enable DeviceFeature::eSynchronization2.
+	* Recording is thread safe, submit() and poll() are meant to be called from the submitting thread.
+	* Readbacks are delivered in recording order, a command buffer that is never submitted holds back the ones after it.
+	*/
+	class ReadbackRing {
+	private:
+		struct Request {
+			u64 begin = 0;
+			u64 end = 0;
+			VkCommandBuffer cmd = VK_NULL_HANDLE;
+			bool is_submitted = false;
+			u64 retire_value = 0;
+			usize offset = 0;
+			ReadbackResult result;
+			ReadbackCallback callback;
+		};
+
+		Allocator* allocator_ = nullptr;
+		OwnedAllocation allocation_;
+		OwnedBuffer buffer_;
+		VkBuffer buffer_handle_ = VK_NULL_HANDLE;
+		const u8* base_ = nullptr;
+		usize capacity_ = 0;
+		usize alignment_ = 16;
+
+		std::mutex mutex_;
+		u64 head_ = 0;
+		u64 tail_ = 0;
+		std::deque<Request> requests_;
+		u64 last_retire_value_ = 0;
+
+	public:
+		ReadbackRing() noexcept = default;
+
+		ReadbackRing(ReadbackRing&& rhs) noexcept;
+		ReadbackRing& operator=(ReadbackRing&&) = delete;
+
+		ReadbackRing(const ReadbackRing&) = delete;
+		ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+		[[nodiscard]]
+		static auto create(Allocator& allocator, ReadbackRingConfig config = {}) noexcept -> std::expected<ReadbackRing, ErrorCode>;
+
+		/*
+		* Returns eOutOfPoolMemory if the ring is full until older readbacks are polled. size must not be 0.
+		*/
+		[[nodiscard]]
+		auto record_copy(VkCommandBuffer cmd, BufferView src, usize src_offset, usize size, ReadbackCallback callback) noexcept -> std::expected<void, ErrorCode>;
+
+		/*
+		* Copies one mip level, extent is the extent of that level. range.aspect_mask must contain a single aspect.
+		*/
+		[[nodiscard]]
+		auto record_copy(VkCommandBuffer cmd, ImageView src, ImageLayout layout, Format format, Extent2D extent, ImageSubresourceRange range, ReadbackCallback callback) noexcept -> std::expected<void, ErrorCode>;
+
+		/*
+		* Same as record_copy(), the data is copied out of the ring into the future's value.
+		*/
+		[[nodiscard]]
+		auto record_copy_future(VkCommandBuffer cmd, BufferView src, usize src_offset, usize size) noexcept -> std::expected<std::future<std::vector<std::byte>>, ErrorCode>;
+		[[nodiscard]]
+		auto record_copy_future(VkCommandBuffer cmd, ImageView src, ImageLayout layout, Format format, Extent2D extent, ImageSubresourceRange range = {}) noexcept -> std::expected<std::future<std::vector<std::byte>>, ErrorCode>;
+
+		/*
+		* The readbacks recorded into cmd are delivered once poll() is called with a value >= retire_value.
+		* Call it when cmd is submitted, retire_value must increase monotonically across calls.
+		*/
+		void submit(VkCommandBuffer cmd, u64 retire_value) noexcept;
+
+		/*
+		* Invokes the callbacks of completed readbacks in recording order and reclaims their space.
+		* Returns the number of delivered readbacks.
+		*/
+		usize poll(u64 completed_value) noexcept;
+
+		/*
+		* Polls with the current value of a timeline semaphore the retire values were signaled on.
+		*/
+		usize poll(SemaphoreView timeline) noexcept;
+
+		[[nodiscard]]
+		usize get_used_bytes() noexcept {
+			std::lock_guard lock{ mutex_ };
+			return static_cast<usize>(head_ - tail_);
+		}
+
+		[[nodiscard]]
+		usize get_capacity() const noexcept {
+			return capacity_;
+		}
+
+	private:
+		/*
+		* Reserves ring space and queues the request in ring order, returns the offset of the space.
+		*/
+		[[nodiscard]]
+		std::optional<usize> push_request_(VkCommandBuffer cmd, usize size, usize alignment, ReadbackResult result, ReadbackCallback&& callback) noexcept;
+
+		/*
+		* Makes the copy into the ring space visible to the host once the submission has completed.
+		*/
+		void record_host_barrier_(VkCommandBuffer cmd, usize offset, usize size) const noexcept;
+		[[nodiscard]]
+		static ReadbackCallback make_future_callback_(std::promise<std::vector<std::byte>> promise) noexcept;
+	};
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <optional>
+#include <algorithm>
+#include <expected>
+#include <functional>
+#include <type_traits>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	enum class ResidencyPriority : u8 {
+		eLow = 0,
+		eNormal,
+		eHigh,
+	};
+
+	/*
+	* Stays valid after eviction, ResidencyManager::is_resident() tells whether the memory is still there.
+	*/
+	struct ResidentId {
+		u32 index = ~0u;
+		u32 generation = 0;
+
+		[[nodiscard]]
+		bool operator==(const ResidentId&) const noexcept = default;
+	};
+
+	/*
+	* Called before the memory of an evicted resource is freed. The owner destroys the resource bound to it
+	* and streams it in again later, e.g. with a lower mip count.
+	*/
+	using EvictionCallback = std::move_only_function<void(ResidentId)>;
+
+	struct ResidencyConfig {
+		// Resources used within this many frames may still be read by the GPU and are never evicted
+		u32 protected_frames = 2;
+		// Evicted at least per retry, so a failing allocation doesn't retry once per tiny resource
+		usize min_eviction_bytes = mb_to_bytes(16);
+	};
+
+	struct ResidencyStats {
+		usize resident_count = 0;
+		usize resident_bytes = 0;
+		usize eviction_count = 0;
+		usize evicted_bytes = 0;
+		usize retry_count = 0;
+	};
+
+	/*
+	* Owns the memory of evictable resources (streamed textures, cached buffers) and tracks the frame they were
+	* last used in. When an allocation fails with eOutOfDeviceMemory, resources are evicted lowest priority first,
+	* least recently used first within a priority, and the allocation is retried.
+	* Eviction callbacks run without the internal lock held and may call back into the manager.
+	*/
+	class ResidencyManager {
+	private:
+		struct Entry {
+			OwnedAllocation allocation;
+			EvictionCallback on_evict;
+			u64 last_used_frame = 0;
+			usize size = 0;
+			u32 heap_index = 0;
+			u32 generation = 0;
+			ResidencyPriority priority = ResidencyPriority::eNormal;
+			bool is_resident = false;
+		};
+
+		struct Victim {
+			OwnedAllocation allocation;
+			EvictionCallback on_evict;
+			ResidentId id;
+		};
+
+		Allocator* allocator_ = nullptr;
+		ResidencyConfig config_;
+
+		std::mutex mutex_;
+		std::vector<Entry> entries_;
+		std::vector<u32> free_indices_;
+		u64 frame_ = 0;
+		ResidencyStats stats_;
+
+	public:
+		explicit ResidencyManager(Allocator& allocator, ResidencyConfig config = {}) noexcept
+			: allocator_{ &allocator }
+			, config_{ config }
+		{}
+
+		ResidencyManager(const ResidencyManager&) = delete;
+		ResidencyManager& operator=(const ResidencyManager&) = delete;
+		ResidencyManager(ResidencyManager&&) = delete;
+		ResidencyManager& operator=(ResidencyManager&&) = delete;
+
+		/*
+		* Takes ownership of allocation. The resource counts as used in the current frame.
+		*/
+		[[nodiscard]]
+		ResidentId add(Allocation&& allocation, ResidencyPriority priority, EvictionCallback on_evict) noexcept;
+
+		/*
+		* Frees the memory without calling the eviction callback. No-op for evicted resources.
+		*/
+		void remove(ResidentId id) noexcept;
+
+		void begin_frame(u64 frame) noexcept {
+			std::lock_guard lock{ mutex_ };
+			frame_ = frame;
+		}
+
+		void touch(ResidentId id) noexcept;
+		void set_priority(ResidentId id, ResidencyPriority priority) noexcept;
+
+		[[nodiscard]]
+		bool is_resident(ResidentId id) noexcept;
+
+		/*
+		* Only valid while the resource is resident.
+		*/
+		[[nodiscard]]
+		AllocationView get_allocation(ResidentId id) noexcept;
+
+		/*
+		* Evicts unprotected resources until at least bytes are freed or nothing is left to evict.
+		* Only resources in heap_index are considered if it is set. Returns the number of freed bytes.
+		*/
+		usize evict(usize bytes, std::optional<u32> heap_index = std::nullopt) noexcept;
+
+		/*
+		* Calls allocate until it succeeds, fails with something else than eOutOfDeviceMemory or there is nothing
+		* left to evict in heap_index, the heap allocate draws from. allocate must return std::expected<T, ErrorCode>.
+		*/
+		template<typename F>
+		[[nodiscard]]
+		auto retry_on_oom(F&& allocate, u32 heap_index, usize size_hint = 0) noexcept -> std::invoke_result_t<F&> {
+			for (;;) {
+				auto res = allocate();
+				if (res.has_value() || res.error() != ErrorCode::eOutOfDeviceMemory) {
+					return res;
+				}
+				// Memory freed in another heap can't satisfy the allocation
+				if (evict(std::max(size_hint, config_.min_eviction_bytes), heap_index) == 0) {
+					return res;
+				}
+
+				std::lock_guard lock{ mutex_ };
+				++stats_.retry_count;
+			}
+		}
+
+		/*
+		* Allocator::allocate_for_image/buffer() with eviction on failure, the memory is added as evictable.
+		*/
+		[[nodiscard]]
+		auto allocate_for_image(VkImage image, MemoryUsage usage, ResidencyPriority priority, EvictionCallback on_evict) noexcept -> std::expected<ResidentId, ErrorCode>;
+		[[nodiscard]]
+		auto allocate_for_buffer(VkBuffer buffer, MemoryUsage usage, ResidencyPriority priority, EvictionCallback on_evict) noexcept -> std::expected<ResidentId, ErrorCode>;
+
+		[[nodiscard]]
+		ResidencyStats get_stats() noexcept {
+			std::lock_guard lock{ mutex_ };
+			return stats_;
+		}
+
+	private:
+		[[nodiscard]]
+		Entry* find_(ResidentId id) noexcept {
+			if (id.index >= entries_.size() || entries_[id.index].generation != id.generation || !entries_[id.index].is_resident) {
+				return nullptr;
+			}
+			return &entries_[id.index];
+		}
+
+		[[nodiscard]]
+		Victim release_(u32 index) noexcept;
+
+		/*
+		* Heap of the memory type the allocator tries first for these requirements.
+		*/
+		[[nodiscard]]
+		std::optional<u32> find_heap_index_(u32 memory_type_bits, MemoryUsage usage) const noexcept;
+	};
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <span>
+#include <deque>
+#include <mutex>
+#include <limits>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <expected>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "sync.hpp"
+
+namespace gx {
+	/*
+	* A position on the timeline of one scheduler queue. Work submitted with value v is done once the timeline
+	* reaches v, so a point is a complete handle to a submission.
+	*/
+	struct TimelinePoint {
+		u32 queue = 0;
+		u64 value = 0;
+	};
+
+	struct TimelineSubmitInfo {
+		std::span<const VkCommandBuffer> command_buffers;
+		// Points of this or other queues the command buffers wait for
+		std::span<const TimelinePoint> waits;
+		VkPipelineStageFlags2 wait_stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		// Binary semaphores, e.g. swapchain acquire and present semaphores
+		std::span<const VkSemaphore> binary_waits;
+		std::span<const VkPipelineStageFlags2> binary_wait_stages;
+		std::span<const VkSemaphore> binary_signals;
+	};
+
+	/*
+	* Reset at the start of a frame, the counters give the submissions per frame with and without batching.
+	*/
+	struct SubmitStats {
+		// enqueue() and submit() calls, each would have been its own vkQueueSubmit() without batching
+		usize submission_count = 0;
+		// vkQueueSubmit2() calls actually made
+		usize queue_submit_count = 0;
+	};
+
+	using RetireCallback = std::move_only_function<void()>;
+
+	/*
+	* Owns one timeline semaphore per queue. Every submission signals the next value of its queue's timeline and
+	* is identified by it as a TimelinePoint, dependencies between queues are waits on such points and CPU waits go
+	* through vkWaitSemaphores(), so no fences are created or reset. Retirement of resources keys off the points too:
+	* retire() defers a callback until its point is complete and collect() runs the completed ones.
+	*
+	* Submissions are batched. enqueue() only records a submission and hands out its point, flush() sends everything
+	* enqueued on a queue with one vkQueueSubmit2() call. Submissions of a queue are executed in enqueue order,
+	* whichever thread enqueued them. Waits on points of other queues that are still enqueued are fine, the GPU waits
+	* for the signal once that queue is flushed too. submit() flushes right away for latency-critical work, wait()
+	* flushes all queues, since the points may depend on work still enqueued anywhere.
+	* Binary semaphores must be signaled before a wait on them reaches the device, so flushing a queue first flushes
+	* the queues with enqueued signals of the binary semaphores it waits on. Such a signal must be enqueued before
+	* the wait on it, and waits in both directions between two batches must not form a cycle.
+	* present() flushes before presenting, so the scheduler's lock is the only one needed around the queue.
+	*
+	* Requires DeviceFeature::eTimelineSemaphore and DeviceFeature::eSynchronization2. The scheduler serializes its own
+	* submissions per queue, other submissions to the queues must be synchronized with it externally.
+	*/
+	class TimelineScheduler {
+	private:
+		struct Retirement {
+			u64 value = 0;
+			RetireCallback callback;
+		};
+
+		// Submissions reference ranges of the flat arrays, so recording them allocates nothing in steady state
+		struct PendingSubmit {
+			u32 first_command_buffer = 0;
+			u32 command_buffer_count = 0;
+			u32 first_wait = 0;
+			u32 wait_count = 0;
+			u32 first_signal = 0;
+			u32 signal_count = 0;
+		};
+
+		struct SubmitBatch {
+			std::vector<PendingSubmit> submits;
+			std::vector<VkCommandBufferSubmitInfo> command_buffers;
+			std::vector<VkSemaphoreSubmitInfo> waits;
+			std::vector<VkSemaphoreSubmitInfo> signals;
+			// Binary semaphores of waits and signals, other queues look them up to find what they have to flush first
+			std::vector<VkSemaphore> binary_waits;
+			std::vector<VkSemaphore> binary_signals;
+			// Only filled while flushing, once the arrays above don't move anymore
+			std::vector<VkSubmitInfo2> infos;
+			u64 last_value = 0;
+
+			void clear() noexcept {
+				submits.clear();
+				infos.clear();
+				command_buffers.clear();
+				waits.clear();
+				signals.clear();
+				binary_waits.clear();
+				binary_signals.clear();
+			}
+		};
+
+		struct QueueTimeline {
+			VkQueue queue = VK_NULL_HANDLE;
+			OwnedSemaphore semaphore;
+			VkSemaphore semaphore_handle = VK_NULL_HANDLE;
+
+			// Guards pending and recorded_value
+			std::mutex enqueue_mutex;
+			SubmitBatch pending;
+			u64 recorded_value = 0;
+			// Last value handed out, reserved values may not be recorded yet
+			std::atomic<u64> enqueued_value = 0;
+
+			// Held during a whole flush, so batches reach the queue in the order their values were handed out
+			std::mutex flush_mutex;
+			SubmitBatch flushing;
+			std::atomic<u64> submitted_value = 0;
+
+			// Last value read back from the semaphore, only grows
+			std::atomic<u64> completed_value = 0;
+
+			// Sorted by value
+			std::mutex retire_mutex;
+			std::deque<Retirement> retirements;
+
+			std::atomic<usize> submission_count = 0;
+			std::atomic<usize> queue_submit_count = 0;
+
+			QueueTimeline(VkQueue handle, Semaphore&& timeline) noexcept
+				: queue{ handle }
+				, semaphore{ std::move(timeline).to_owned<MoveOnlyTag, ViewableTag>() }
+				, semaphore_handle{ semaphore.get_view().get_handle() }
+			{}
+		};
+
+		VkDevice device_ = VK_NULL_HANDLE;
+		std::vector<std::unique_ptr<QueueTimeline>> timelines_;
+
+	public:
+		TimelineScheduler() noexcept = default;
+
+		/*
+		* Flushes and waits for all submissions and runs the retirements that are still pending.
+		*/
+		~TimelineScheduler() noexcept;
+
+		TimelineScheduler(TimelineScheduler&&) noexcept = default;
+		TimelineScheduler& operator=(TimelineScheduler&&) = delete;
+
+		TimelineScheduler(const TimelineScheduler&) = delete;
+		TimelineScheduler& operator=(const TimelineScheduler&) = delete;
+
+		/*
+		* Queue i of the scheduler is queues[i], TimelinePoint::queue refers to these indices.
+		*/
+		[[nodiscard]]
+		static auto create(VkDevice device, std::span<const VkQueue> queues) noexcept -> std::expected<TimelineScheduler, ErrorCode>;
+
+		/*
+		* Records a submission for the next flush() of the queue and returns the point it will signal. Thread safe.
+		*/
+		[[nodiscard]]
+		TimelinePoint enqueue(u32 queue, const TimelineSubmitInfo& info) noexcept;
+
+		/*
+		* Hands out the next point of the queue without recording anything, enqueue_reserved() records the submission
+		* for it later. Meant for submission threads that take the recording off the caller's thread: reserved points
+		* must be recorded in value order and a queue that reserves must not use enqueue() too.
+		*/
+		[[nodiscard]]
+		TimelinePoint reserve(u32 queue) noexcept {
+			return TimelinePoint{ queue, timelines_[queue]->enqueued_value.fetch_add(1, std::memory_order_acq_rel) + 1 };
+		}
+
+		void enqueue_reserved(TimelinePoint point, const TimelineSubmitInfo& info) noexcept;
+
+		/*
+		* Submits everything enqueued on the queue with one vkQueueSubmit2() call. If the call fails the batch is dropped
+		* and its points never complete, which only happens on device loss or when out of memory.
+		*/
+		[[nodiscard]]
+		auto flush(u32 queue) noexcept -> std::expected<void, ErrorCode>;
+
+		/*
+		* Flushes all queues in index order, meant for sync points like the end of a frame.
+		*/
+		[[nodiscard]]
+		auto flush() noexcept -> std::expected<void, ErrorCode>;
+
+		/*
+		* enqueue() followed by flush(queue), for work that can't wait for the next sync point.
+		*/
+		[[nodiscard]]
+		auto submit(u32 queue, const TimelineSubmitInfo& info) noexcept -> std::expected<TimelinePoint, ErrorCode>;
+
+		/*
+		* Flushes the queue, so the present comes after everything enqueued before, and presents on it.
+		* Fails if the flush does, otherwise returns the result of vkQueuePresentKHR() as is, VK_SUBOPTIMAL_KHR and
+		* VK_ERROR_OUT_OF_DATE_KHR ask for the swapchain to be recreated.
+		*/
+		[[nodiscard]]
+		auto present(u32 queue, const VkPresentInfoKHR& info) noexcept -> std::expected<VkResult, ErrorCode>;
+
+		/*
+		* Point of the latest submission enqueued on the queue, value 0 if there is none yet.
+		*/
+		[[nodiscard]]
+		TimelinePoint get_last_enqueued(u32 queue) const noexcept {
+			return TimelinePoint{ queue, timelines_[queue]->enqueued_value.load(std::memory_order_acquire) };
+		}
+
+		/*
+		* Point of the latest submission that reached the queue, value 0 if there is none yet.
+		*/
+		[[nodiscard]]
+		TimelinePoint get_last_submitted(u32 queue) const noexcept {
+			return TimelinePoint{ queue, timelines_[queue]->submitted_value.load(std::memory_order_acquire) };
+		}
+
+		[[nodiscard]]
+		auto get_completed_value(u32 queue) noexcept -> std::expected<u64, ErrorCode>;
+
+		/*
+		* Only asks the device if the cached completed value isn't far enough yet.
+		*/
+		[[nodiscard]]
+		bool is_complete(TimelinePoint point) noexcept;
+
+		/*
+		* Returns false if timeout_ns passed before the points completed. With wait_all = false returns as soon as
+		* one of the points has completed.
+		*/
+		[[nodiscard]]
+		auto wait(std::span<const TimelinePoint> points, u64 timeout_ns = std::numeric_limits<u64>::max(), bool wait_all = true) noexcept -> std::expected<bool, ErrorCode>;
+
+		[[nodiscard]]
+		auto wait(TimelinePoint point, u64 timeout_ns = std::numeric_limits<u64>::max()) noexcept -> std::expected<bool, ErrorCode> {
+			return wait(std::span{ &point, 1 }, timeout_ns);
+		}
+
+		/*
+		* Flushes all queues and waits for the latest submission of every queue that reached it. Reserved points that
+		* aren't recorded yet and points of a failed flush aren't waited for, they would never complete.
+		*/
+		[[nodiscard]]
+		auto wait_idle() noexcept -> std::expected<void, ErrorCode>;
+
+		/*
+		* callback runs in collect() once point has completed, e.g. to destroy a resource the GPU used until then.
+		*/
+		void retire(TimelinePoint point, RetireCallback callback) noexcept;
+
+		/*
+		* Runs the callbacks of all completed retirements and returns how many ran.
+		*/
+		usize collect() noexcept;
+
+		/*
+		* Summed over all queues.
+		*/
+		[[nodiscard]]
+		SubmitStats get_stats() const noexcept;
+
+		void reset_stats() noexcept;
+
+		[[nodiscard]]
+		VkSemaphore get_semaphore(u32 queue) const noexcept {
+			return timelines_[queue]->semaphore_handle;
+		}
+
+		[[nodiscard]]
+		VkQueue get_queue(u32 queue) const noexcept {
+			return timelines_[queue]->queue;
+		}
+
+		[[nodiscard]]
+		u32 get_queue_count() const noexcept {
+			return static_cast<u32>(timelines_.size());
+		}
+
+	private:
+		void record_(QueueTimeline& timeline, u64 value, const TimelineSubmitInfo& info) noexcept;
+
+		/*
+		* flush_mutex of the timeline must be held.
+		*/
+		[[nodiscard]]
+		auto flush_locked_(QueueTimeline& timeline) noexcept -> std::expected<void, ErrorCode>;
+
+		/*
+		* Flushes the queue after the queues that signal binary semaphores its enqueued submissions wait on.
+		* visited has a bit per queue already being flushed further up, those are skipped.
+		*/
+		[[nodiscard]]
+		auto flush_(u32 queue, u64 visited) noexcept -> std::expected<void, ErrorCode>;
+
+		/*
+		* Flushes the queues not in visited with enqueued signals of one of the binary semaphores.
+		*/
+		[[nodiscard]]
+		auto flush_signalers_(std::span<const VkSemaphore> binary_waits, u64 visited) noexcept -> std::expected<void, ErrorCode>;
+
+		[[nodiscard]]
+		auto refresh_completed_(QueueTimeline& timeline) noexcept -> std::expected<u64, ErrorCode>;
+	};
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <mutex>
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "image.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	/*
+	* Tiles (sparse image blocks) of one mip level and array layer. Mip levels inside the mip tail have no tiles,
+	* the tail is always resident.
+	*/
+	struct SparseTileRegion {
+		u32 mip_level = 0;
+		u32 array_layer = 0;
+		u32 x = 0;
+		u32 y = 0;
+		u32 z = 0;
+		u32 width = 1;
+		u32 height = 1;
+		u32 depth = 1;
+	};
+
+	struct SparseResourceId {
+		u32 index = ~0u;
+		u32 generation = 0;
+
+		[[nodiscard]]
+		bool operator==(const SparseResourceId&) const noexcept = default;
+	};
+
+	struct SparseResidencyConfig {
+		// Pages are taken from the Allocator in chunks of this many, so consecutive commits get contiguous memory
+		u32 pages_per_chunk = 64;
+	};
+
+	struct SparseResidencyStats {
+		usize committed_pages = 0;
+		usize committed_bytes = 0;
+		usize chunk_count = 0;
+		// Page and tile binding changes requested so far and the binds they were coalesced into
+		usize requested_binds = 0;
+		usize submitted_binds = 0;
+		usize bind_calls = 0;
+	};
+
+	/*
+	* Semaphores and fence of one flush. Value spans are either empty (binary semaphores)
+	* or hold one value per semaphore, binary ones in a mix get ignored values.
+	*/
+	struct SparseFlushInfo {
+		std::span<const VkSemaphore> wait_semaphores;
+		std::span<const u64> wait_values;
+		std::span<const VkSemaphore> signal_semaphores;
+		std::span<const u64> signal_values;
+		VkFence fence = VK_NULL_HANDLE;
+	};
+
+	/*
+	* Page tables for partially resident images and buffers created with set_sparse_residency(). commit() and
+	* decommit() only update the tables, flush() turns every change since the last flush into binds for the final
+	* state of each page and submits them all with a single vkQueueBindSparse(). Consecutive pages with contiguous
+	* memory become one buffer bind and runs of unbound tiles along a row become one image bind.
+	* Contents of freshly committed tiles are undefined. Decommitted pages are reused right away, the GPU must be done
+	* with the tiles being decommitted, e.g. they haven't been sampled within the frames in flight.
+	* Thread safe. The queue must support sparse binding (see PhysDeviceInfo::get_sparse_binding_queue_type())
+	* and must not be used by other threads during flush().
+	*/
+	class SparseResidencyManager {
+	private:
+		struct Page {
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			usize offset = 0;
+		};
+
+		struct PagePool {
+			u32 memory_type = 0;
+			usize page_size = 0;
+			std::vector<OwnedAllocation> chunks;
+			std::vector<Page> free_pages;
+		};
+
+		struct Resource {
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkImage image = VK_NULL_HANDLE;
+			usize size = 0;
+			u32 pool_index = 0;
+			u32 generation = 0;
+			bool is_alive = false;
+
+			// Images only, tiles of a layer are stored mip by mip, each mip level row by row
+			VkImageAspectFlags aspect = 0;
+			VkExtent3D extent{};
+			VkExtent3D tile_extent{};
+			u32 tiled_mip_count = 0;
+			u32 layer_count = 0;
+			usize layer_stride = 0;
+			std::vector<usize> mip_offsets;
+			std::vector<Page> tail_pages;
+
+			std::vector<Page> pages;
+			// Page table entries changed since the last flush, may contain duplicates
+			std::vector<usize> dirty;
+			std::vector<VkSparseMemoryBind> pending_opaque;
+		};
+
+		Allocator* allocator_ = nullptr;
+		VkQueue queue_ = VK_NULL_HANDLE;
+		SparseResidencyConfig config_;
+
+		std::mutex mutex_;
+		std::vector<PagePool> pools_;
+		std::vector<Resource> resources_;
+		std::vector<u32> free_indices_;
+		SparseResidencyStats stats_;
+
+	public:
+		SparseResidencyManager(Allocator& allocator, VkQueue queue, SparseResidencyConfig config = {}) noexcept
+			: allocator_{ &allocator }
+			, queue_{ queue }
+			, config_{ config }
+		{}
+
+		SparseResidencyManager(const SparseResidencyManager&) = delete;
+		SparseResidencyManager& operator=(const SparseResidencyManager&) = delete;
+		SparseResidencyManager(SparseResidencyManager&&) = delete;
+		SparseResidencyManager& operator=(SparseResidencyManager&&) = delete;
+
+		/*
+		* desc must be the builder the image was created with. The mip tail is committed right away and bound
+		* with the next flush(). Returns eFeatureNotPresent if the image isn't sparse resident.
+		*/
+		[[nodiscard]]
+		auto add_image(ImageView image, const ImageBuilder& desc) noexcept -> std::expected<SparseResourceId, ErrorCode>;
+		[[nodiscard]]
+		auto add_buffer(BufferView buffer) noexcept -> std::expected<SparseResourceId, ErrorCode>;
+
+		/*
+		* Frees every page without unbinding it. The resource must be destroyed before the pages are used again,
+		* so the GPU must be done with it.
+		*/
+		void remove(SparseResourceId id) noexcept;
+
+		/*
+		* No-op for removed resources. Tiles committed before a failure stay committed.
+		*/
+		[[nodiscard]]
+		auto commit(SparseResourceId id, SparseTileRegion region) noexcept -> std::expected<void, ErrorCode>;
+		void decommit(SparseResourceId id, SparseTileRegion region) noexcept;
+
+		/*
+		* Buffer ranges in bytes. commit_range() commits every page the range touches,
+		* decommit_range() only the pages lying completely inside it.
+		*/
+		[[nodiscard]]
+		auto commit_range(SparseResourceId id, usize offset, usize size) noexcept -> std::expected<void, ErrorCode>;
+		void decommit_range(SparseResourceId id, usize offset, usize size) noexcept;
+
+		[[nodiscard]]
+		bool is_committed(SparseResourceId id, SparseTileRegion region) noexcept;
+
+		/*
+		* Tile extent in texels and the number of tiles of a mip level, zero for mip levels in the mip tail.
+		*/
+		[[nodiscard]]
+		VkExtent3D get_tile_extent(SparseResourceId id) noexcept;
+		[[nodiscard]]
+		VkExtent3D get_tile_count(SparseResourceId id, u32 mip_level) noexcept;
+
+		/*
+		* Submits the binds of all changes since the last flush. Also submits if there are no binds
+		* but semaphores or a fence were passed.
+		*/
+		[[nodiscard]]
+		auto flush(const SparseFlushInfo& info = {}) noexcept -> std::expected<void, ErrorCode>;
+
+		[[nodiscard]]
+		SparseResidencyStats get_stats() noexcept {
+			std::lock_guard lock{ mutex_ };
+			return stats_;
+		}
+
+	private:
+		[[nodiscard]]
+		Resource* find_(SparseResourceId id) noexcept {
+			if (id.index >= resources_.size() || resources_[id.index].generation != id.generation || !resources_[id.index].is_alive) {
+				return nullptr;
+			}
+			return &resources_[id.index];
+		}
+
+		[[nodiscard]]
+		auto find_pool_(u32 memory_type_bits, usize page_size) noexcept -> std::expected<u32, ErrorCode>;
+		[[nodiscard]]
+		auto alloc_page_(u32 pool_index) noexcept -> std::expected<Page, ErrorCode>;
+		void free_page_(u32 pool_index, Page& page) noexcept;
+
+		[[nodiscard]]
+		auto commit_page_(Resource& resource, usize index) noexcept -> std::expected<void, ErrorCode>;
+		void decommit_page_(Resource& resource, usize index) noexcept;
+
+		[[nodiscard]]
+		SparseResourceId push_resource_(Resource&& resource) noexcept;
+
+		[[nodiscard]]
+		usize get_tile_index_(const Resource& resource, u32 layer, u32 mip, u32 x, u32 y, u32 z) const noexcept;
+		[[nodiscard]]
+		VkExtent3D get_mip_tile_count_(const Resource& resource, u32 mip) const noexcept;
+	};
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <span>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <optional>
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "error.hpp"
+#include "types.hpp"
+#include "image.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+
+namespace gx {
+	/*
+	* Range of the ring an upload holds, the padding in front of it included. The upload has completed once retire()
+	* reclaimed the ring past its end, see StagingRing::is_retired() and StagingRing::wait().
+	*/
+	struct StagingTicket {
+		u64 begin = 0;
+		u64 end = 0;
+	};
+
+	struct StagingRegion {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		usize offset = 0;
+		usize size = 0;
+		u8* mapped = nullptr;
+		StagingTicket ticket;
+	};
+
+	struct StagingRingConfig {
+		usize size = mb_to_bytes(64);
+		usize alignment = 16;
+	};
+
+	/*
+	* Upload ring over one persistently mapped buffer. Any thread may allocate and write without locking,
+	* reservations are a CAS on a monotonically growing position. Every region carries a ticket, submit() closes
+	* the tickets of the regions recorded into one submission, so producers recording into different command buffers
+	* don't close each other's regions. retire() reclaims the ring in order up to the first region that isn't
+	* submitted or completed yet.
+	*/
+	class StagingRing {
+	private:
+		struct Submission {
+			u64 end = 0;
+			u64 retire_value = 0;
+		};
+
+		OwnedAllocation allocation_;
+		OwnedBuffer buffer_;
+		VkBuffer buffer_handle_ = VK_NULL_HANDLE;
+		u8* base_ = nullptr;
+		usize capacity_ = 0;
+		usize alignment_ = 16;
+
+		alignas(64) std::atomic<u64> head_ = 0;
+		alignas(64) std::atomic<u64> tail_ = 0;
+
+		// Keyed by the begin of the tickets, together with the reserved ones that aren't submitted yet they tile the ring
+		std::mutex submissions_mutex_;
+		std::map<u64, Submission> submissions_;
+
+	public:
+		StagingRing() noexcept = default;
+
+		StagingRing(StagingRing&& rhs) noexcept;
+		StagingRing& operator=(StagingRing&&) = delete;
+
+		StagingRing(const StagingRing&) = delete;
+		StagingRing& operator=(const StagingRing&) = delete;
+
+		[[nodiscard]]
+		static auto create(Allocator& allocator, StagingRingConfig config = {}) noexcept -> std::expected<StagingRing, ErrorCode>;
+
+		/*
+		* Lock-free. Returns std::nullopt if the ring is full until older submissions retire.
+		*/
+		[[nodiscard]]
+		std::optional<StagingRegion> allocate(usize size, usize alignment = 0) noexcept;
+
+		[[nodiscard]]
+		std::optional<StagingRegion> write(std::span<const std::byte> data, usize alignment = 0) noexcept {
+			auto region = allocate(data.size(), alignment);
+			if (region.has_value()) {
+				std::memcpy(region->mapped, data.data(), data.size());
+			}
+			return region;
+		}
+
+		static void record_copy(VkCommandBuffer cmd, const StagingRegion& region, BufferView dst, usize dst_offset) noexcept;
+		static void record_copy(VkCommandBuffer cmd, const StagingRegion& region, ImageView dst, ImageLayout layout, Extent2D extent, ImageSubresourceRange range = {}) noexcept;
+
+		/*
+		* The regions of tickets are reclaimed once retire() is called with a value >= retire_value. retire_value is
+		* whatever the caller signals on completion: a frame number, a fence generation or a timeline semaphore value.
+		* Every allocated region must be submitted exactly once, an unsubmitted one holds back the ring behind it.
+		*/
+		void submit(u64 retire_value, std::span<const StagingTicket> tickets) noexcept;
+
+		void submit(u64 retire_value, StagingTicket ticket) noexcept {
+			submit(retire_value, std::span{ &ticket, 1 });
+		}
+
+		void retire(u64 completed_value) noexcept;
+
+		[[nodiscard]]
+		bool is_retired(StagingTicket ticket) const noexcept {
+			return tail_.load(std::memory_order_acquire) >= ticket.end;
+		}
+
+		/*
+		* Blocks until another thread's retire() has reclaimed the upload. The upload must have been submitted.
+		*/
+		void wait(StagingTicket ticket) const noexcept {
+			u64 tail = tail_.load(std::memory_order_acquire);
+			while (tail < ticket.end) {
+				tail_.wait(tail, std::memory_order_acquire);
+				tail = tail_.load(std::memory_order_acquire);
+			}
+		}
+
+		/*
+		* retire_value of the submission the upload went out with, e.g. to wait for its timeline semaphore value or
+		* fence instead. std::nullopt if it isn't submitted yet or already retired.
+		*/
+		[[nodiscard]]
+		std::optional<u64> get_retire_value(StagingTicket ticket) noexcept;
+
+		[[nodiscard]]
+		usize get_used_bytes() const noexcept {
+			return static_cast<usize>(head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed));
+		}
+
+		[[nodiscard]]
+		usize get_capacity() const noexcept {
+			return capacity_;
+		}
+	};
+}
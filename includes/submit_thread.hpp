@@ -0,0 +1,192 @@
+#pragma once
+
+#include <span>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <future>
+#include <expected>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "error.hpp"
+#include "scheduler.hpp"
+
+namespace gx {
+	namespace details {
+		struct MpscNode {
+			std::atomic<MpscNode*> next = nullptr;
+		};
+
+		/*
+		* Intrusive multi-producer single-consumer queue. push() is one exchange and never waits for other producers,
+		* pop() may return nullptr while a push is halfway done, the consumer sees the node on a later call.
+		*/
+		class MpscQueue {
+		private:
+			alignas(64) std::atomic<MpscNode*> head_;
+			alignas(64) MpscNode* tail_ = nullptr;
+			MpscNode stub_;
+
+		public:
+			MpscQueue() noexcept
+				: head_{ &stub_ }
+				, tail_{ &stub_ }
+			{}
+
+			MpscQueue(const MpscQueue&) = delete;
+			MpscQueue& operator=(const MpscQueue&) = delete;
+			MpscQueue(MpscQueue&&) = delete;
+			MpscQueue& operator=(MpscQueue&&) = delete;
+
+			void push(MpscNode* node) noexcept {
+				node->next.store(nullptr, std::memory_order_relaxed);
+				MpscNode* prev = head_.exchange(node, std::memory_order_acq_rel);
+				prev->next.store(node, std::memory_order_release);
+			}
+
+			/*
+			* Consumer only.
+			*/
+			[[nodiscard]]
+			MpscNode* pop() noexcept {
+				MpscNode* tail = tail_;
+				MpscNode* next = tail->next.load(std::memory_order_acquire);
+
+				if (tail == &stub_) {
+					if (next == nullptr) {
+						return nullptr;
+					}
+					tail_ = next;
+					tail = next;
+					next = next->next.load(std::memory_order_acquire);
+				}
+
+				if (next != nullptr) {
+					tail_ = next;
+					return tail;
+				}
+
+				// A producer has swapped head_ but not linked its node yet
+				if (tail != head_.load(std::memory_order_acquire)) {
+					return nullptr;
+				}
+
+				// tail is the last node, the stub goes behind it so tail can be handed out
+				push(&stub_);
+				next = tail->next.load(std::memory_order_acquire);
+				if (next != nullptr) {
+					tail_ = next;
+					return tail;
+				}
+				return nullptr;
+			}
+		};
+	}
+
+	/*
+	* Owns the submissions of one TimelineScheduler queue and runs them on its own thread, so callers never block in
+	* vkQueueSubmit2() or vkQueuePresentKHR() and never lock the queue. submit() reserves the submission's point and
+	* pushes a packet on an intrusive queue with one atomic exchange, the worker records the packets in point order and
+	* flushes all it found with one call. Presents run once every submission reserved before them is flushed.
+	* Producers never wait for each other or the worker, but each packet and its copies of the caller's arrays are
+	* heap allocated, so submit() and present() are only as lock-free as the global allocator.
+	* The queue must only be submitted to through this thread, the other scheduler calls may still be used,
+	* e.g. wait() and retire() on the returned points.
+	*/
+	class QueueSubmitThread {
+	private:
+		enum class PacketType : u8 {
+			eSubmit = 0,
+			ePresent,
+		};
+
+		// Owns copies of the arrays the caller's infos point to
+		struct Packet : details::MpscNode {
+			PacketType type = PacketType::eSubmit;
+			// Signal value of a submit, a present follows all submits up to it
+			u64 value = 0;
+
+			std::vector<VkCommandBuffer> command_buffers;
+			std::vector<TimelinePoint> waits;
+			VkPipelineStageFlags2 wait_stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			std::vector<VkSemaphore> binary_waits;
+			std::vector<VkPipelineStageFlags2> binary_wait_stages;
+			std::vector<VkSemaphore> binary_signals;
+
+			VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+			u32 image_index = 0;
+			std::promise<std::expected<VkResult, ErrorCode>> present_result;
+		};
+
+		TimelineScheduler* scheduler_ = nullptr;
+		u32 queue_ = 0;
+
+		details::MpscQueue packets_;
+		alignas(64) std::atomic<u32> epoch_ = 0;
+		std::atomic<bool> is_stopping_ = false;
+		std::atomic<ErrorCode> error_ = ErrorCode::eSuccess;
+
+		// Worker only. submits_ is sorted by value, packets of concurrent producers may arrive out of order
+		std::deque<std::unique_ptr<Packet>> submits_;
+		std::deque<std::unique_ptr<Packet>> presents_;
+		u64 next_value_ = 0;
+
+		// Last, so the worker starts once everything else is initialized
+		std::jthread worker_;
+
+	public:
+		QueueSubmitThread(TimelineScheduler& scheduler, u32 queue) noexcept;
+
+		/*
+		* Finishes all packets pushed so far.
+		*/
+		~QueueSubmitThread() noexcept;
+
+		QueueSubmitThread(const QueueSubmitThread&) = delete;
+		QueueSubmitThread& operator=(const QueueSubmitThread&) = delete;
+		QueueSubmitThread(QueueSubmitThread&&) = delete;
+		QueueSubmitThread& operator=(QueueSubmitThread&&) = delete;
+
+		/*
+		* Returns right away with the point the submission will signal, it may be waited on or used in waits of
+		* other submissions at once. Thread safe.
+		*/
+		[[nodiscard]]
+		TimelinePoint submit(const TimelineSubmitInfo& info) noexcept;
+
+		/*
+		* Presents after all submissions reserved so far. The future receives what TimelineScheduler::present() returns.
+		* Thread safe.
+		*/
+		[[nodiscard]]
+		std::future<std::expected<VkResult, ErrorCode>> present(VkSwapchainKHR swapchain, u32 image_index, std::span<const VkSemaphore> waits = {}) noexcept;
+
+		/*
+		* First error of a flush, the points of a failed flush never complete.
+		*/
+		[[nodiscard]]
+		ErrorCode get_error() const noexcept {
+			return error_.load(std::memory_order_acquire);
+		}
+
+		[[nodiscard]]
+		u32 get_queue() const noexcept {
+			return queue_;
+		}
+
+	private:
+		void push_(Packet* packet) noexcept;
+		void worker_loop_() noexcept;
+
+		/*
+		* Returns true if it did anything.
+		*/
+		[[nodiscard]]
+		bool process_() noexcept;
+	};
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <expected>
+#include <cassert>
+
+#include <vulkan/vulkan.h>
+
+#include <misc/types.hpp>
+
+#include "utils.hpp"
+#include "types.hpp"
+#include "error.hpp"
+#include "host_allocator.hpp"
+
+namespace gx {
+	enum class SemaphoreType : u8 {
+		eBinary = 0,
+		eTimeline,
+	};
+
+	[[nodiscard]]
+	constexpr VkSemaphoreType semaphore_type_to_vk(SemaphoreType type) noexcept {
+		return static_cast<VkSemaphoreType>(type);
+	}
+	static_assert(semaphore_type_to_vk(SemaphoreType::eTimeline) == VK_SEMAPHORE_TYPE_TIMELINE);
+
+	struct SemaphoreImpl {};
+
+	struct [[nodiscard]] SemaphoreValue {
+		VkSemaphore handle = VK_NULL_HANDLE;
+		VkDevice parent = VK_NULL_HANDLE;
+
+		SemaphoreValue() noexcept = default;
+
+		SemaphoreValue(VkSemaphore semaphore, VkDevice device) noexcept
+			: handle{ semaphore }
+			, parent{ device }
+		{}
+
+		void destroy() noexcept {
+			vkDestroySemaphore(parent, handle, get_allocation_callbacks(parent));
+		}
+	};
+	static_assert(Value<SemaphoreValue>);
+
+	using Semaphore = ManagableType<SemaphoreValue, SemaphoreImpl>;
+	using SemaphoreView = decltype(std::declval<Semaphore&>().get_view());
+	using OwnedSemaphore = OwnedType<SemaphoreValue, SemaphoreImpl, MoveOnlyTag, ViewableTag>;
+
+	struct [[nodiscard]] SemaphoreBuilder {
+	private:
+		VkDevice device_ = VK_NULL_HANDLE;
+
+	public:
+		SemaphoreType type_ = SemaphoreType::eBinary;
+		u64 initial_value_ = 0;
+		ExternalSemaphoreHandleTypeFlags external_handle_types_ = 0;
+
+	public:
+		SemaphoreBuilder(VkDevice device) noexcept
+			: device_{ device }
+		{}
+
+		[[nodiscard]]
+		SemaphoreBuilder& with_timeline(u64 initial_value = 0) noexcept {
+			type_ = SemaphoreType::eTimeline;
+			initial_value_ = initial_value;
+			return *this;
+		}
+
+		/*
+		* The semaphore payload can be exported with one of these handle types.
+		*/
+		[[nodiscard]]
+		SemaphoreBuilder& with_external_handle_types(ExternalSemaphoreHandleTypeFlags types) noexcept {
+			external_handle_types_ = types;
+			return *this;
+		}
+
+		[[nodiscard]]
+		auto build() const noexcept -> std::expected<Semaphore, ErrorCode> {
+			validate();
+
+			VkExportSemaphoreCreateInfo export_info = {
+				.sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO,
+				.handleTypes = external_semaphore_handle_types_to_vk(external_handle_types_),
+			};
+
+			VkSemaphoreTypeCreateInfo type_info = {
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+				.pNext = external_handle_types_ != 0 ? &export_info : nullptr,
+				.semaphoreType = semaphore_type_to_vk(type_),
+				.initialValue = initial_value_,
+			};
+
+			VkSemaphoreCreateInfo ci = {
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+				.pNext = &type_info,
+			};
+
+			SemaphoreValue value{ VK_NULL_HANDLE, device_ };
+			VkResult res = vkCreateSemaphore(device_, &ci, get_allocation_callbacks(device_), &value.handle);
+
+			if (res == VK_SUCCESS) {
+				return Semaphore{ value };
+			}
+			return std::unexpected(convert_vk_result(res));
+		}
+
+	private:
+		void validate() const noexcept {
+			// VUID-VkSemaphoreTypeCreateInfo-semaphoreType-03279
+			assert((type_ == SemaphoreType::eTimeline || initial_value_ == 0) && "initial_value_ must be 0 for binary semaphores");
+			// VUID-VkExportSemaphoreCreateInfo-handleTypes-01124
+			assert((type_ == SemaphoreType::eBinary || !test_bit(external_handle_types_, ExternalSemaphoreHandleType::eSyncFd)) &&
+				"Timeline semaphores can't be exported as sync fds");
+			// VUID-vkCreateSemaphore-device-parameter
+			assert(device_ != VK_NULL_HANDLE && "device_ must be a valid VkDevice handle");
+		}
+	};
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <algorithm>
+
+#include <misc/types.hpp>
+
+namespace gx {
+	namespace details {
+		/*
+		* Owners of thread caches that are still alive, shared by every allocator keeping per-thread caches.
+		* Ids are never reused, so a cache left behind by a destroyed owner can't be taken for a new one.
+		*/
+		struct ThreadCacheOwners {
+			std::mutex mutex;
+			std::vector<std::pair<u64, void*>> owners;
+			std::atomic<u64> next_id = 1;
+
+			// The caller holds mutex
+			[[nodiscard]]
+			void* find(u64 id) const noexcept {
+				auto it = std::ranges::find(owners, id, &std::pair<u64, void*>::first);
+				return it != owners.end() ? it->second : nullptr;
+			}
+		};
+
+		[[nodiscard]]
+		ThreadCacheOwners& get_thread_cache_owners() noexcept;
+		[[nodiscard]]
+		u64 register_thread_cache_owner(void* owner) noexcept;
+		void unregister_thread_cache_owner(u64 id) noexcept;
+
+		/*
+		* The caches one thread keeps in front of any number of owners, keyed by owner id. Finding the cache of an owner
+		* the thread has used before takes no lock, so switching between owners is as cheap as staying with one.
+		* On thread exit Cache::drain(Owner&) hands every cache back to its owner if the owner is still alive,
+		* caches of destroyed owners are dropped since their memory went away with the owner.
+		*/
+		template<typename Owner, typename Cache>
+		class ThreadCacheMap {
+			struct Entry {
+				u64 owner = 0;
+				Cache cache{};
+			};
+
+			std::vector<Entry> entries_;
+			usize last_ = 0;
+
+		public:
+			ThreadCacheMap() noexcept = default;
+
+			~ThreadCacheMap() noexcept {
+				if (entries_.empty()) {
+					return;
+				}
+
+				// The lock keeps the owners from being destroyed while their caches are handed back
+				auto& owners = get_thread_cache_owners();
+				std::lock_guard lock{ owners.mutex };
+				for (auto& entry : entries_) {
+					if (void* owner = owners.find(entry.owner); owner != nullptr) {
+						entry.cache.drain(*static_cast<Owner*>(owner));
+					}
+				}
+			}
+
+			ThreadCacheMap(const ThreadCacheMap&) = delete;
+			ThreadCacheMap& operator=(const ThreadCacheMap&) = delete;
+			ThreadCacheMap(ThreadCacheMap&&) = delete;
+			ThreadCacheMap& operator=(ThreadCacheMap&&) = delete;
+
+			[[nodiscard]]
+			Cache* find(u64 owner) noexcept {
+				if (last_ < entries_.size() && entries_[last_].owner == owner) {
+					return &entries_[last_].cache;
+				}
+
+				auto it = std::ranges::find(entries_, owner, &Entry::owner);
+				if (it == entries_.end()) {
+					return nullptr;
+				}
+				last_ = static_cast<usize>(it - entries_.begin());
+				return &it->cache;
+			}
+
+			[[nodiscard]]
+			Cache& get(u64 owner) noexcept {
+				if (Cache* cache = find(owner); cache != nullptr) {
+					return *cache;
+				}
+
+				// First use of the owner on this thread, the only point besides thread exit that takes the lock
+				{
+					auto& owners = get_thread_cache_owners();
+					std::lock_guard lock{ owners.mutex };
+					std::erase_if(entries_, [&owners](const Entry& entry) { return owners.find(entry.owner) == nullptr; });
+				}
+
+				entries_.push_back(Entry{ .owner = owner });
+				last_ = entries_.size() - 1;
+				return entries_.back().cache;
+			}
+		};
+	}
+}
@@ -45,6 +45,7 @@ namespace gx {
 
 	template<Value V, typename Impl>
 	struct [[nodiscard]] View final : Impl {
+		friend typename Impl;
 	private:
 		V value_;
 
@@ -220,17 +221,17 @@ namespace gx {
 #endif
 
 		[[nodiscard]]
-		auto get_handle(this const ManagableType self) noexcept {
+		auto get_handle(this const ManagableType& self) noexcept {
 			return self.value_.handle;
 		}
 
 		[[nodiscard]]
-		auto get_parent(this const ManagableType self) noexcept requires DependentValue<V> {
+		auto get_parent(this const ManagableType& self) noexcept requires DependentValue<V> {
 			return self.value_.parent;
 		}
 
 		[[nodiscard]]
-		View<V, Impl> get_view(this const ManagableType self) noexcept {
+		View<V, Impl> get_view(this const ManagableType& self) noexcept {
 			return View<V, Impl>{ self.value_ };
 		}
 
@@ -273,6 +274,15 @@ namespace gx {
 	enum class Format {
 		eUndefined,
 		eBGRA8_SRGB,
+		eBGRA8_UNORM,
+		eRGBA8_SRGB,
+		eRGBA8_UNORM,
+		eR8_UNORM,
+		eR32_SFLOAT,
+		eRGBA16_SFLOAT,
+		eRGBA32_SFLOAT,
+		eD32_SFLOAT,
+		eD24_UNORM_S8_UINT,
 		eCount
 	};
 
@@ -281,6 +291,24 @@ namespace gx {
 		switch (format) {
 		case VK_FORMAT_B8G8R8A8_SRGB:
 			return Format::eBGRA8_SRGB;
+		case VK_FORMAT_B8G8R8A8_UNORM:
+			return Format::eBGRA8_UNORM;
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			return Format::eRGBA8_SRGB;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+			return Format::eRGBA8_UNORM;
+		case VK_FORMAT_R8_UNORM:
+			return Format::eR8_UNORM;
+		case VK_FORMAT_R32_SFLOAT:
+			return Format::eR32_SFLOAT;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+			return Format::eRGBA16_SFLOAT;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return Format::eRGBA32_SFLOAT;
+		case VK_FORMAT_D32_SFLOAT:
+			return Format::eD32_SFLOAT;
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+			return Format::eD24_UNORM_S8_UINT;
 		}
 		return Format::eUndefined;
 	}
@@ -290,21 +318,53 @@ namespace gx {
 		static constexpr std::array kFormats = {
 			VK_FORMAT_UNDEFINED,
 			VK_FORMAT_B8G8R8A8_SRGB,
+			VK_FORMAT_B8G8R8A8_UNORM,
+			VK_FORMAT_R8G8B8A8_SRGB,
+			VK_FORMAT_R8G8B8A8_UNORM,
+			VK_FORMAT_R8_UNORM,
+			VK_FORMAT_R32_SFLOAT,
+			VK_FORMAT_R16G16B16A16_SFLOAT,
+			VK_FORMAT_R32G32B32A32_SFLOAT,
+			VK_FORMAT_D32_SFLOAT,
+			VK_FORMAT_D24_UNORM_S8_UINT,
 		};
+		static_assert(kFormats.size() == std::to_underlying(Format::eCount));
 		return kFormats[std::to_underlying(format)];
 	}
 
 	enum class ImageUsage : u32 {
 		eColorAttachment = bit<u32, 0>(),
+		eDepthStencilAttachment = bit<u32, 1>(),
+		eInputAttachment = bit<u32, 2>(),
+		eTransientAttachment = bit<u32, 3>(),
+		eSampled = bit<u32, 4>(),
+		eStorage = bit<u32, 5>(),
+		eTransferSrc = bit<u32, 6>(),
+		eTransferDst = bit<u32, 7>(),
 	};
 
 	OVERLOAD_BIT_OPS(ImageUsage, u32);
 
+	namespace details {
+		inline constexpr std::array kImageUsageBits = {
+			std::pair{ ImageUsage::eColorAttachment, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT },
+			std::pair{ ImageUsage::eDepthStencilAttachment, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT },
+			std::pair{ ImageUsage::eInputAttachment, VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT },
+			std::pair{ ImageUsage::eTransientAttachment, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT },
+			std::pair{ ImageUsage::eSampled, VK_IMAGE_USAGE_SAMPLED_BIT },
+			std::pair{ ImageUsage::eStorage, VK_IMAGE_USAGE_STORAGE_BIT },
+			std::pair{ ImageUsage::eTransferSrc, VK_IMAGE_USAGE_TRANSFER_SRC_BIT },
+			std::pair{ ImageUsage::eTransferDst, VK_IMAGE_USAGE_TRANSFER_DST_BIT },
+		};
+	}
+
 	[[nodiscard]]
 	inline u32 image_usage_from_vk(VkImageUsageFlags flags) noexcept {
 		u32 ret = 0;
-		if (test_bit(flags, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)) {
-			ret |= ImageUsage::eColorAttachment;
+		for (auto [usage, vk_usage] : details::kImageUsageBits) {
+			if (test_bit(flags, vk_usage)) {
+				ret |= usage;
+			}
 		}
 		return ret;
 	}
@@ -312,8 +372,10 @@ namespace gx {
 	[[nodiscard]]
 	inline VkImageUsageFlags image_usage_to_vk(u32 flags) noexcept {
 		VkImageUsageFlags ret = 0;
-		if (test_bit(flags, ImageUsage::eColorAttachment)) {
-			ret |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		for (auto [usage, vk_usage] : details::kImageUsageBits) {
+			if (test_bit(flags, usage)) {
+				ret |= vk_usage;
+			}
 		}
 		return ret;
 	}
@@ -339,6 +401,54 @@ namespace gx {
 		return VK_SHARING_MODE_EXCLUSIVE;
 	}
 
+	enum class ExternalMemoryHandleType : u8 {
+		eOpaqueFd = bit<u8, 0>(),
+		eOpaqueWin32 = bit<u8, 1>(),
+		eHostAllocation = bit<u8, 2>(),
+	};
+
+	OVERLOAD_BIT_OPS(ExternalMemoryHandleType, u8);
+
+	[[nodiscard]]
+	constexpr VkExternalMemoryHandleTypeFlags external_memory_handle_types_to_vk(ExternalMemoryHandleTypeFlags flags) noexcept {
+		VkExternalMemoryHandleTypeFlags ret = 0;
+		if (test_bit(flags, ExternalMemoryHandleType::eOpaqueFd)) {
+			ret |= VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+		}
+		if (test_bit(flags, ExternalMemoryHandleType::eOpaqueWin32)) {
+			ret |= VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT;
+		}
+		if (test_bit(flags, ExternalMemoryHandleType::eHostAllocation)) {
+			ret |= VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+		}
+		return ret;
+	}
+	static_assert(VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT == external_memory_handle_types_to_vk(std::to_underlying(ExternalMemoryHandleType::eOpaqueFd)));
+
+	enum class ExternalSemaphoreHandleType : u8 {
+		eOpaqueFd = bit<u8, 0>(),
+		eSyncFd = bit<u8, 1>(),
+		eOpaqueWin32 = bit<u8, 2>(),
+	};
+
+	OVERLOAD_BIT_OPS(ExternalSemaphoreHandleType, u8);
+
+	[[nodiscard]]
+	constexpr VkExternalSemaphoreHandleTypeFlags external_semaphore_handle_types_to_vk(ExternalSemaphoreHandleTypeFlags flags) noexcept {
+		VkExternalSemaphoreHandleTypeFlags ret = 0;
+		if (test_bit(flags, ExternalSemaphoreHandleType::eOpaqueFd)) {
+			ret |= VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+		}
+		if (test_bit(flags, ExternalSemaphoreHandleType::eSyncFd)) {
+			ret |= VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_SYNC_FD_BIT;
+		}
+		if (test_bit(flags, ExternalSemaphoreHandleType::eOpaqueWin32)) {
+			ret |= VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_WIN32_BIT;
+		}
+		return ret;
+	}
+	static_assert(VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_SYNC_FD_BIT == external_semaphore_handle_types_to_vk(std::to_underlying(ExternalSemaphoreHandleType::eSyncFd)));
+
 	struct Extent2D {
 		u32 width = static_cast<u32>(~0);
 		u32 height = static_cast<u32>(~0);
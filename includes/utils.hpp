@@ -44,6 +44,14 @@ namespace gx {
 		return mb_to_bytes(value) * 1024;
 	}
 
+	[[nodiscard]]
+	constexpr usize align_up(usize value, usize alignment) noexcept {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+	static_assert(align_up(0, 16) == 0);
+	static_assert(align_up(1, 16) == 16);
+	static_assert(align_up(256, 256) == 256);
+
 	template<typename E>
 		requires std::is_enum_v<E>
 	constexpr bool test_bit(decltype(std::to_underlying(E{})) flags, E bit) noexcept {
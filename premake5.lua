@@ -71,3 +71,41 @@ workspace "GraphX"
 
         links { "GrpahX" }
         kind "ConsoleApp"
+
+    project "FdShareExample"
+        targetdir "samples/build/%{cfg.buildcfg}/%{cfg.platform}"
+        filename "fd_share"
+        location "%{wks.location}/fd_share"
+        files { "samples/fd_share/**.cpp" }
+
+        links { "GrpahX" }
+        kind "ConsoleApp"
+        -- Shares memory and semaphores as POSIX fds, runs on lavapipe with VK_ICD_FILENAMES pointing to its icd json
+        removeplatforms { "Win64" }
+
+    project "AllocStressExample"
+        targetdir "samples/build/%{cfg.buildcfg}/%{cfg.platform}"
+        filename "alloc_stress"
+        location "%{wks.location}/alloc_stress"
+        files { "samples/alloc_stress/**.cpp" }
+
+        links { "GrpahX" }
+        kind "ConsoleApp"
+
+    project "ParallelRecordExample"
+        targetdir "samples/build/%{cfg.buildcfg}/%{cfg.platform}"
+        filename "parallel_record"
+        location "%{wks.location}/parallel_record"
+        files { "samples/parallel_record/**.cpp" }
+
+        links { "GrpahX" }
+        kind "ConsoleApp"
+
+    project "AsyncComputeExample"
+        targetdir "samples/build/%{cfg.buildcfg}/%{cfg.platform}"
+        filename "async_compute"
+        location "%{wks.location}/async_compute"
+        files { "samples/async_compute/**.cpp" }
+
+        links { "GrpahX" }
+        kind "ConsoleApp"
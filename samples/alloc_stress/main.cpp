@@ -0,0 +1,192 @@
+#include <instance.hpp>
+#include <device.hpp>
+#include <allocator.hpp>
+#include <allocation_cache.hpp>
+#include <buffer_pool.hpp>
+
+#include <array>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <ranges>
+#include <algorithm>
+#include <expected>
+#include <iostream>
+#include <format>
+
+#include <misc/types.hpp>
+
+/*
+* Allocates and frees small blocks from many threads at once, first straight from gx::Allocator, then through
+* gx::ThreadCachedAllocator, and prints the throughput of both per thread count. Every thread keeps a window
+* of live allocations so the caches see frees in a different order than allocations. Before that it checks
+* gx::BufferPool around its dedicated buffer threshold. Runs headless.
+*/
+
+namespace {
+	constexpr usize kOpsPerThread = 200'000;
+	constexpr usize kLiveWindow = 256;
+	constexpr std::array<usize, 6> kSizes = { 64, 256, 1024, 4096, 8192, 16384 };
+
+	struct RunResult {
+		double ops_per_second = 0.0;
+		bool failed = false;
+	};
+
+	template<typename F>
+	RunResult run_threads(u32 thread_count, F&& worker) noexcept {
+		std::vector<u8> failed(thread_count, 0);
+		auto begin = std::chrono::steady_clock::now();
+		{
+			std::vector<std::jthread> threads;
+			threads.reserve(thread_count);
+			for (u32 i : std::views::iota(0u, thread_count)) {
+				threads.emplace_back(
+					[&worker, &failed, i] {
+						failed[i] = worker(i) ? 0 : 1;
+					}
+				);
+			}
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+		return RunResult{
+			.ops_per_second = static_cast<double>(kOpsPerThread * thread_count) / elapsed.count(),
+			.failed = std::ranges::any_of(failed, [](u8 f) { return f != 0; }),
+		};
+	}
+
+	/*
+	* Alloc is the allocation type, allocate returns std::expected<Alloc, gx::ErrorCode>.
+	*/
+	template<typename Alloc, typename F>
+	bool stress(u32 seed, F&& allocate) noexcept {
+		std::minstd_rand rng{ seed };
+		std::uniform_int_distribution<usize> size_dist{ 0, kSizes.size() - 1 };
+
+		std::vector<Alloc> live;
+		live.reserve(kLiveWindow);
+		for ([[maybe_unused]] usize i : std::views::iota(usize{ 0 }, kOpsPerThread)) {
+			if (live.size() == kLiveWindow) {
+				// Free a random one so slots come back out of order
+				std::swap(live[rng() % live.size()], live.back());
+				std::move(live.back()).destroy();
+				live.pop_back();
+			}
+
+			auto allocation = allocate(gx::AllocationDesc{ .size = kSizes[size_dist(rng)], .alignment = 64, .usage = gx::MemoryUsage::eGpuOnly });
+			if (!allocation.has_value()) {
+				return false;
+			}
+			live.push_back(std::move(allocation).value());
+		}
+
+		for (auto& allocation : live) {
+			std::move(allocation).destroy();
+		}
+		return true;
+	}
+
+	/*
+	* Requests just above a half of the buffer size get a buffer of their own, odd sizes and large alignments
+	* must still fit it and the buffer must go away with the range.
+	*/
+	bool check_buffer_pool(gx::Allocator& allocator) noexcept {
+		constexpr usize kBufferSize = gx::mb_to_bytes(16);
+		gx::BufferPool pool{ allocator, gx::BufferPoolConfig{ .buffer_size = kBufferSize } };
+
+		for (usize size : { kBufferSize / 2 + 1, kBufferSize / 2 + 16, gx::mb_to_bytes(9) + 16, kBufferSize }) {
+			for (usize alignment : { usize{ 0 }, usize{ 256 } }) {
+				auto range = pool.allocate(size, alignment);
+				if (!range.has_value()) {
+					std::cerr << std::format("BufferPool failed to allocate {} bytes aligned to {}\n", size, alignment);
+					return false;
+				}
+
+				bool is_valid = range->get_size() == size && range->get_offset() % std::max<usize>(alignment, 1) == 0;
+				std::move(*range).destroy();
+				if (!is_valid || pool.get_capacity() != 0 || pool.get_used_bytes() != 0) {
+					std::cerr << std::format("BufferPool returned a bad range for {} bytes aligned to {}\n", size, alignment);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+int main() {
+	auto inst_res = gx::InstanceBuilder{}
+		.with_app_info("alloc_stress", gx::Version(0, 1, 0))
+		.build();
+
+	if (!inst_res.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(inst_res.error()) << '\n';
+		return 1;
+	}
+	gx::Instance<meta::List<>, meta::List<>> instance = std::move(inst_res).value();
+
+	auto phys_devices = instance.enum_phys_devices();
+	if (phys_devices.empty()) {
+		std::cerr << "No physical devices\n";
+		return 1;
+	}
+	auto phys_device = phys_devices.front();
+
+	auto device_res = phys_device.get_device_builder()
+		.request_graphics_queues()
+		.build();
+
+	if (!device_res.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(device_res.error()) << '\n';
+		return 1;
+	}
+	auto device = std::move(device_res).value();
+
+	gx::Allocator allocator{ phys_device, device.get_view().get_handle() };
+
+	if (!check_buffer_pool(allocator)) {
+		return 1;
+	}
+
+	std::vector<u32> thread_counts = { 1, 2, 4, 8, 16 };
+	u32 hw_threads = std::thread::hardware_concurrency();
+	if (hw_threads != 0 && std::ranges::find(thread_counts, hw_threads) == thread_counts.end()) {
+		thread_counts.push_back(hw_threads);
+		std::ranges::sort(thread_counts);
+	}
+
+	std::cout << std::format("{:>8} {:>16} {:>16} {:>8}\n", "threads", "allocator op/s", "cached op/s", "speedup");
+	for (u32 thread_count : thread_counts) {
+		auto direct = run_threads(
+			thread_count,
+			[&allocator](u32 i) noexcept {
+				return stress<gx::Allocation>(i, [&allocator](const gx::AllocationDesc& desc) noexcept { return allocator.allocate(desc); });
+			}
+		);
+
+		// A fresh cache per run so the cached numbers include refilling from empty slabs
+		gx::ThreadCachedAllocator cache{ allocator };
+		auto cached = run_threads(
+			thread_count,
+			[&cache](u32 i) noexcept {
+				return stress<gx::CachedAllocation>(i, [&cache](const gx::AllocationDesc& desc) noexcept { return cache.allocate(desc); });
+			}
+		);
+
+		if (direct.failed || cached.failed) {
+			std::cerr << "Allocation failed with " << thread_count << " threads\n";
+			return 1;
+		}
+
+		auto stats = cache.get_stats();
+		std::cout << std::format(
+			"{:>8} {:>16.0f} {:>16.0f} {:>7.2f}x  ({} slabs, {} KiB, {} refills, {} drains)\n",
+			thread_count, direct.ops_per_second, cached.ops_per_second, cached.ops_per_second / direct.ops_per_second,
+			stats.slab_count, stats.slab_bytes / 1024, stats.refill_count, stats.drain_count
+		);
+	}
+
+	return 0;
+}
@@ -0,0 +1,271 @@
+#include <instance.hpp>
+#include <device.hpp>
+#include <buffer.hpp>
+#include <allocator.hpp>
+#include <cmd_exec.hpp>
+#include <scheduler.hpp>
+#include <async_compute.hpp>
+#include <utils.hpp>
+
+#include <array>
+#include <chrono>
+#include <ranges>
+#include <iostream>
+#include <format>
+
+#include <misc/types.hpp>
+
+/*
+* Runs a frame of "shadow rendering" on the graphics queue next to a "particle simulation" on the compute queue,
+* once with gx::AsyncCompute on two queues and once with both on the graphics queue, and prints the average frame
+* time of each. The workloads are chains of vkCmdFillBuffer, so no pipeline is needed. The particle buffer is
+* written by compute and read by graphics every frame, which exercises the ownership transfers. Runs headless.
+*/
+
+namespace {
+	constexpr u32 kFrameCount = 200;
+	constexpr u32 kWarmupFrameCount = 10;
+	constexpr u32 kShadowPassCount = 64;
+	constexpr u32 kSimulationStepCount = 64;
+	constexpr usize kShadowMapSize = gx::mb_to_bytes(32);
+	constexpr usize kParticleBufferSize = gx::mb_to_bytes(16);
+
+	struct GpuBuffer {
+		// Destroyed in reverse order, the buffer goes before its memory
+		gx::OwnedAllocation allocation;
+		gx::OwnedBuffer buffer;
+	};
+
+	auto create_buffer(auto& device, gx::Allocator& allocator, usize size, gx::BufferUsageFlags usage) noexcept -> std::expected<GpuBuffer, gx::ErrorCode> {
+		auto buffer_res = device.get_buffer_builder()
+			.with_size(size)
+			.with_usage(usage)
+			.build();
+		if (!buffer_res.has_value()) {
+			return std::unexpected(buffer_res.error());
+		}
+
+		auto allocation_res = allocator.allocate_for_buffer(buffer_res->get_handle());
+		if (!allocation_res.has_value()) {
+			std::move(*buffer_res).destroy();
+			return std::unexpected(allocation_res.error());
+		}
+
+		return GpuBuffer{
+			.allocation = std::move(allocation_res).value().template to_owned<gx::MoveOnlyTag, gx::ViewableTag>(),
+			.buffer = std::move(buffer_res).value().template to_owned<gx::MoveOnlyTag, gx::ViewableTag>(),
+		};
+	}
+}
+
+int main() {
+	auto inst_res = gx::InstanceBuilder{}
+		.with_app_info("async_compute", gx::Version(0, 1, 0))
+		.build();
+
+	if (!inst_res.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(inst_res.error()) << '\n';
+		return 1;
+	}
+	gx::Instance<meta::List<>, meta::List<>> instance = std::move(inst_res).value();
+
+	auto phys_devices = instance.enum_phys_devices();
+	if (phys_devices.empty()) {
+		std::cerr << "No physical devices\n";
+		return 1;
+	}
+	auto phys_device = phys_devices.front();
+
+	gx::DeviceFeatureFlags features = gx::DeviceFeature::eTimelineSemaphore | gx::DeviceFeature::eSynchronization2;
+	if (!phys_device.get_info().supports_features(features)) {
+		std::cerr << "Timeline semaphores and synchronization2 are required\n";
+		return 1;
+	}
+
+	auto device_res = phys_device.get_device_builder()
+		.with_features(features)
+		.request_graphics_queues()
+		.request_compute_queues()
+		.build();
+
+	if (!device_res.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(device_res.error()) << '\n';
+		return 1;
+	}
+	auto device = std::move(device_res).value();
+	VkDevice vk_device = device.get_view().get_handle();
+
+	gx::GraphicsQueue graphics_queue = device.get_graphics_queue().value();
+	gx::ComputeQueue compute_queue = device.get_compute_queue().value();
+	if (compute_queue.get_family() == graphics_queue.get_family()) {
+		std::cout << "No dedicated compute family, both runs share the graphics family\n";
+	}
+
+	gx::Allocator allocator{ phys_device, vk_device };
+
+	auto shadow_map = create_buffer(device, allocator, kShadowMapSize, gx::BufferUsage::eTransferDst);
+	if (!shadow_map.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(shadow_map.error()) << '\n';
+		return 1;
+	}
+	auto particles = create_buffer(device, allocator, kParticleBufferSize, gx::BufferUsage::eTransferSrc | gx::BufferUsage::eTransferDst);
+	if (!particles.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(particles.error()) << '\n';
+		return 1;
+	}
+	VkBuffer vk_shadow_map = shadow_map->buffer.get_view().get_handle();
+	VkBuffer vk_particles = particles->buffer.get_view().get_handle();
+
+	std::array<VkQueue, 2> queues = { graphics_queue.get_handle(), compute_queue.get_handle() };
+	auto scheduler_res = gx::TimelineScheduler::create(vk_device, queues);
+	if (!scheduler_res.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(scheduler_res.error()) << '\n';
+		return 1;
+	}
+	auto scheduler = std::move(scheduler_res).value();
+
+	gx::CommandAllocator cmd_allocator{ vk_device, gx::CommandAllocatorConfig{
+		.frames_in_flight = 1,
+		.queue_families = { graphics_queue.get_family(), compute_queue.get_family() },
+	} };
+
+	// Compute overwrites the whole buffer every frame, graphics copies it into the shadow map
+	gx::BufferHandoff to_compute{
+		.buffer = vk_particles,
+		.src_stages = VK_PIPELINE_STAGE_2_COPY_BIT,
+		.src_access = VK_ACCESS_2_TRANSFER_READ_BIT,
+		.dst_stages = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+		.dst_access = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+	};
+	gx::BufferHandoff to_graphics{
+		.buffer = vk_particles,
+		.src_stages = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+		.src_access = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		.dst_stages = VK_PIPELINE_STAGE_2_COPY_BIT,
+		.dst_access = VK_ACCESS_2_TRANSFER_READ_BIT,
+	};
+
+	auto record = [&cmd_allocator](u32 family, auto&& fn) noexcept -> std::expected<VkCommandBuffer, gx::ErrorCode> {
+		auto cmd = cmd_allocator.begin(family);
+		if (cmd.has_value()) {
+			fn(*cmd);
+			vkEndCommandBuffer(*cmd);
+		}
+		return cmd;
+	};
+
+	u64 frame = 0;
+	auto run = [&](gx::AsyncComputeConfig config) noexcept -> std::expected<std::chrono::duration<double>, gx::ErrorCode> {
+		gx::AsyncCompute async_compute{ scheduler, cmd_allocator, config };
+		std::chrono::duration<double> total{ 0.0 };
+
+		for (u32 i : std::views::iota(0u, kWarmupFrameCount + kFrameCount)) {
+			// The previous frame was waited for, so its command buffers can be reused
+			cmd_allocator.begin_frame(frame++);
+			auto begin = std::chrono::steady_clock::now();
+
+			auto simulation = record(config.compute_family, [vk_particles](VkCommandBuffer cmd) noexcept {
+				for (u32 step : std::views::iota(0u, kSimulationStepCount)) {
+					vkCmdFillBuffer(cmd, vk_particles, 0, VK_WHOLE_SIZE, step);
+				}
+			});
+			auto shadows = record(config.graphics_family, [vk_shadow_map](VkCommandBuffer cmd) noexcept {
+				for (u32 pass : std::views::iota(0u, kShadowPassCount)) {
+					vkCmdFillBuffer(cmd, vk_shadow_map, 0, VK_WHOLE_SIZE, pass);
+				}
+			});
+			auto composite = record(config.graphics_family, [vk_particles, vk_shadow_map](VkCommandBuffer cmd) noexcept {
+				// The copy overwrites part of what the shadow passes wrote
+				VkMemoryBarrier2 barrier = {
+					.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+					.srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+					.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+					.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+					.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+				};
+				VkDependencyInfo di = {
+					.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+					.memoryBarrierCount = 1,
+					.pMemoryBarriers = &barrier,
+				};
+				vkCmdPipelineBarrier2(cmd, &di);
+
+				VkBufferCopy region = { .size = kParticleBufferSize };
+				vkCmdCopyBuffer(cmd, vk_particles, vk_shadow_map, 1, &region);
+			});
+			for (const auto& cmd : { simulation, shadows, composite }) {
+				if (!cmd.has_value()) {
+					return std::unexpected(cmd.error());
+				}
+			}
+
+			// The first frame has nothing to take over, the buffer's contents are discarded anyway
+			bool has_previous = i != 0;
+			auto simulated = async_compute.enqueue_compute(gx::AsyncComputeSubmitInfo{
+				.command_buffers = std::span{ &*simulation, 1 },
+				.acquire_buffers = has_previous ? std::span{ &to_compute, 1 } : std::span<const gx::BufferHandoff>{},
+				.release_buffers = std::span{ &to_graphics, 1 },
+			});
+			if (!simulated.has_value()) {
+				return std::unexpected(simulated.error());
+			}
+
+			// Shadows don't read the particles and overlap with the simulation
+			auto shadowed = async_compute.enqueue_graphics(gx::TimelineSubmitInfo{ .command_buffers = std::span{ &*shadows, 1 } }, false);
+			if (!shadowed.has_value()) {
+				return std::unexpected(shadowed.error());
+			}
+			auto composited = async_compute.enqueue_graphics(gx::TimelineSubmitInfo{ .command_buffers = std::span{ &*composite, 1 } });
+			if (!composited.has_value()) {
+				return std::unexpected(composited.error());
+			}
+
+			if (auto res = scheduler.flush(); !res.has_value()) {
+				return std::unexpected(res.error());
+			}
+			if (auto res = scheduler.wait(*composited); !res.has_value()) {
+				return std::unexpected(res.error());
+			}
+
+			if (i >= kWarmupFrameCount) {
+				total += std::chrono::steady_clock::now() - begin;
+			}
+		}
+		return total / kFrameCount;
+	};
+
+	auto serial = run(gx::AsyncComputeConfig{
+		.graphics_queue = 0,
+		.compute_queue = 0,
+		.graphics_family = graphics_queue.get_family(),
+		.compute_family = graphics_queue.get_family(),
+	});
+	if (!serial.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(serial.error()) << '\n';
+		return 1;
+	}
+
+	auto overlapped = run(gx::AsyncComputeConfig{
+		.graphics_queue = 0,
+		.compute_queue = 1,
+		.graphics_family = graphics_queue.get_family(),
+		.compute_family = compute_queue.get_family(),
+	});
+	if (!overlapped.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(overlapped.error()) << '\n';
+		return 1;
+	}
+
+	auto stats = scheduler.get_stats();
+	std::cout << std::format("{:>12} {:>12}\n", "mode", "frame ms");
+	std::cout << std::format("{:>12} {:>12.3f}\n", "serial", serial->count() * 1000.0);
+	std::cout << std::format("{:>12} {:>12.3f}\n", "overlapped", overlapped->count() * 1000.0);
+	std::cout << std::format("speedup {:.2f}x, {} submissions in {} vkQueueSubmit2 calls\n",
+		serial->count() / overlapped->count(), stats.submission_count, stats.queue_submit_count);
+
+	if (auto res = scheduler.wait_idle(); !res.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(res.error()) << '\n';
+		return 1;
+	}
+	return 0;
+}
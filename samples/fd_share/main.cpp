@@ -0,0 +1,496 @@
+#include <instance.hpp>
+#include <device.hpp>
+#include <extensions.hpp>
+#include <buffer.hpp>
+#include <allocator.hpp>
+#include <sync.hpp>
+#include <external.hpp>
+
+#include <span>
+#include <array>
+#include <ranges>
+#include <cstring>
+#include <expected>
+#include <iostream>
+
+#include <misc/types.hpp>
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+* Two processes sharing frames without a host copy. The producer fills exportable device memory on its queue
+* and signals an exportable semaphore, the consumer imports both through fds sent over a unix socket and
+* copies the frame out after waiting on the semaphore. The buffer moves between the processes with queue family
+* ownership transfers through VK_QUEUE_FAMILY_EXTERNAL. Runs headless, e.g. on lavapipe:
+* VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./fd_share
+*/
+
+namespace {
+	using DeviceExts = meta::List<gx::ext::ExternalMemoryFdExt, gx::ext::ExternalSemaphoreFdExt>;
+
+	constexpr usize kFrameSize = gx::mb_to_bytes(1);
+	constexpr u32 kFrameCount = 16;
+
+	struct SetupMessage {
+		usize size = 0;
+		u32 memory_type = 0;
+		std::array<u8, VK_UUID_SIZE> device_uuid{};
+		std::array<u8, VK_UUID_SIZE> driver_uuid{};
+	};
+
+	struct FrameMessage {
+		u32 index = 0;
+	};
+
+	bool send_message(int sock, const void* data, usize size, std::span<const int> fds = {}) noexcept {
+		iovec iov = { const_cast<void*>(data), size };
+		alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int) * 2)> control{};
+
+		msghdr msg{};
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		if (!fds.empty()) {
+			msg.msg_control = control.data();
+			msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+
+			cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+			cmsg->cmsg_level = SOL_SOCKET;
+			cmsg->cmsg_type = SCM_RIGHTS;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+			std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+		}
+		return sendmsg(sock, &msg, 0) == static_cast<ssize_t>(size);
+	}
+
+	bool receive_message(int sock, void* data, usize size, std::span<int> fds = {}) noexcept {
+		iovec iov = { data, size };
+		alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int) * 2)> control{};
+
+		msghdr msg{};
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.data();
+		msg.msg_controllen = control.size();
+
+		if (recvmsg(sock, &msg, MSG_WAITALL) != static_cast<ssize_t>(size)) {
+			return false;
+		}
+
+		cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+		if (!fds.empty()) {
+			if (cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(sizeof(int) * fds.size())) {
+				return false;
+			}
+			std::memcpy(fds.data(), CMSG_DATA(cmsg), sizeof(int) * fds.size());
+		}
+		return true;
+	}
+
+	/*
+	* The shared buffer changes hands with the other process through VK_QUEUE_FAMILY_EXTERNAL. The acquire makes
+	* the other side's writes visible to this queue's transfers, the release makes this side's writes available to it.
+	*/
+	void record_external_acquire(VkCommandBuffer cmd, VkBuffer buffer, u32 family) noexcept {
+		VkBufferMemoryBarrier barrier = {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.srcAccessMask = 0,
+			.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL,
+			.dstQueueFamilyIndex = family,
+			.buffer = buffer,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE,
+		};
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	void record_external_release(VkCommandBuffer cmd, VkBuffer buffer, u32 family) noexcept {
+		VkBufferMemoryBarrier barrier = {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = 0,
+			.srcQueueFamilyIndex = family,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL,
+			.buffer = buffer,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE,
+		};
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	/*
+	* Instance, device and a single graphics queue with a one-shot command buffer, both sides need the same.
+	*/
+	class Context {
+	private:
+		gx::Instance<meta::List<>, meta::List<>> instance_;
+		gx::Device<DeviceExts> device_;
+		VkPhysicalDevice phys_device_ = VK_NULL_HANDLE;
+		VkQueue queue_ = VK_NULL_HANDLE;
+		u32 family_ = 0;
+		VkCommandPool cmd_pool_ = VK_NULL_HANDLE;
+		VkCommandBuffer cmd_ = VK_NULL_HANDLE;
+
+	public:
+		Context() noexcept = default;
+
+		Context(const Context&) = delete;
+		Context& operator=(const Context&) = delete;
+		Context(Context&&) = delete;
+		Context& operator=(Context&&) = delete;
+
+		~Context() noexcept {
+			if (cmd_pool_ != VK_NULL_HANDLE) {
+				vkDestroyCommandPool(get_device(), cmd_pool_, nullptr);
+			}
+		}
+
+		[[nodiscard]]
+		std::expected<void, gx::ErrorCode> setup(std::string_view app_name) noexcept {
+			auto inst_res = gx::InstanceBuilder{}
+				.with_app_info(app_name, gx::Version(0, 1, 0))
+				.build();
+
+			if (!inst_res.has_value()) {
+				return std::unexpected(inst_res.error());
+			}
+			instance_ = std::move(inst_res).value();
+
+			auto phys_devices = instance_.enum_phys_devices();
+			auto supports_fd_sharing = [](gx::PhysDevice phys_device) noexcept {
+				const auto& info = gx::PhysDeviceInfo::get(phys_device);
+				return info.supports_extension<gx::ext::ExternalMemoryFdExt>() && info.supports_extension<gx::ext::ExternalSemaphoreFdExt>();
+			};
+			auto suited_devices = phys_devices | std::views::filter(supports_fd_sharing);
+			if (suited_devices.begin() == suited_devices.end()) {
+				return std::unexpected(gx::ErrorCode::eExtensionNotPresent);
+			}
+			auto phys_device = *suited_devices.begin();
+			phys_device_ = phys_device.get_handle();
+
+			auto device_res = phys_device.get_device_builder()
+				.request_graphics_queues()
+				.with_extensions(DeviceExts{})
+				.build();
+
+			if (!device_res.has_value()) {
+				return std::unexpected(device_res.error());
+			}
+			device_ = std::move(device_res).value();
+
+			family_ = gx::PhysDeviceInfo::get(phys_device_).get_queue_index(gx::QueueType::eGraphics).value();
+			vkGetDeviceQueue(get_device(), family_, 0, &queue_);
+
+			VkCommandPoolCreateInfo pool_ci = {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+				.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+				.queueFamilyIndex = family_,
+			};
+			VkResult res = vkCreateCommandPool(get_device(), &pool_ci, nullptr, &cmd_pool_);
+			if (res != VK_SUCCESS) {
+				return std::unexpected(gx::convert_vk_result(res));
+			}
+
+			VkCommandBufferAllocateInfo cmd_ai = {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				.commandPool = cmd_pool_,
+				.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+				.commandBufferCount = 1,
+			};
+			res = vkAllocateCommandBuffers(get_device(), &cmd_ai, &cmd_);
+			if (res != VK_SUCCESS) {
+				return std::unexpected(gx::convert_vk_result(res));
+			}
+			return {};
+		}
+
+		[[nodiscard]]
+		VkCommandBuffer begin() noexcept {
+			VkCommandBufferBeginInfo bi = {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+				.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			};
+			vkBeginCommandBuffer(cmd_, &bi);
+			return cmd_;
+		}
+
+		/*
+		* The command buffer is reused by the next begin(), wait_idle() must be called in between.
+		*/
+		[[nodiscard]]
+		std::expected<void, gx::ErrorCode> submit(VkSemaphore wait, VkSemaphore signal) noexcept {
+			vkEndCommandBuffer(cmd_);
+
+			VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			VkSubmitInfo si = {
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+				.waitSemaphoreCount = wait != VK_NULL_HANDLE ? 1u : 0u,
+				.pWaitSemaphores = &wait,
+				.pWaitDstStageMask = &wait_stage,
+				.commandBufferCount = 1,
+				.pCommandBuffers = &cmd_,
+				.signalSemaphoreCount = signal != VK_NULL_HANDLE ? 1u : 0u,
+				.pSignalSemaphores = &signal,
+			};
+			VkResult res = vkQueueSubmit(queue_, 1, &si, VK_NULL_HANDLE);
+			if (res != VK_SUCCESS) {
+				return std::unexpected(gx::convert_vk_result(res));
+			}
+			return {};
+		}
+
+		[[nodiscard]]
+		std::expected<void, gx::ErrorCode> wait_idle() noexcept {
+			VkResult res = vkQueueWaitIdle(queue_);
+			if (res != VK_SUCCESS) {
+				return std::unexpected(gx::convert_vk_result(res));
+			}
+			return {};
+		}
+
+		[[nodiscard]]
+		VkDevice get_device() noexcept {
+			return device_.get_view().get_handle();
+		}
+
+		[[nodiscard]]
+		VkPhysicalDevice get_phys_device() const noexcept {
+			return phys_device_;
+		}
+
+		[[nodiscard]]
+		u32 get_family() const noexcept {
+			return family_;
+		}
+	};
+
+	int run_producer(int sock) noexcept {
+		Context ctx{};
+		if (auto res = ctx.setup("fd_share producer"); !res.has_value()) {
+			std::cerr << "producer: " << eh::ErrorTypeTrait<gx::ErrorCode>::description(res.error()) << '\n';
+			return 1;
+		}
+		gx::Allocator allocator{ gx::PhysDevice{ ctx.get_phys_device() }, ctx.get_device() };
+		gx::FdInterop interop{ ctx.get_device() };
+
+		auto buffer = gx::BufferBuilder{ ctx.get_device() }
+			.with_size(kFrameSize)
+			.with_usage(gx::BufferUsage::eTransferDst | gx::BufferUsage::eTransferSrc)
+			.with_external_handle_types(std::to_underlying(gx::ExternalMemoryHandleType::eOpaqueFd))
+			.build();
+		if (!buffer.has_value()) {
+			return 1;
+		}
+		auto frame_buffer = std::move(*buffer).to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+
+		auto allocation = allocator.allocate_for_buffer(frame_buffer.get_view().get_handle(), gx::MemoryUsage::eGpuOnly, std::to_underlying(gx::ExternalMemoryHandleType::eOpaqueFd));
+		if (!allocation.has_value()) {
+			return 1;
+		}
+		auto frame_memory = std::move(*allocation).to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+
+		auto semaphore = gx::SemaphoreBuilder{ ctx.get_device() }
+			.with_external_handle_types(std::to_underlying(gx::ExternalSemaphoreHandleType::eOpaqueFd))
+			.build();
+		if (!semaphore.has_value()) {
+			return 1;
+		}
+		auto ready = std::move(*semaphore).to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+
+		auto memory_desc = interop.export_memory(frame_memory.get_view());
+		auto semaphore_fd = interop.export_semaphore(ready.get_view());
+		if (!memory_desc.has_value() || !semaphore_fd.has_value()) {
+			return 1;
+		}
+
+		const auto& info = gx::PhysDeviceInfo::get(ctx.get_phys_device());
+		SetupMessage setup{
+			.size = memory_desc->size,
+			.memory_type = memory_desc->memory_type,
+			.device_uuid = info.device_uuid,
+			.driver_uuid = info.driver_uuid,
+		};
+		std::array fds{ memory_desc->fd, *semaphore_fd };
+		bool sent = send_message(sock, &setup, sizeof(setup), fds);
+		// The receiving process holds its own duplicates now
+		close(memory_desc->fd);
+		close(*semaphore_fd);
+		if (!sent) {
+			return 1;
+		}
+
+		for (u32 i = 0; i < kFrameCount; ++i) {
+			VkBuffer vk_frame_buffer = frame_buffer.get_view().get_handle();
+			VkCommandBuffer cmd = ctx.begin();
+			// The first frame has nothing to take back, the consumer released the buffer after every later one
+			if (i != 0) {
+				record_external_acquire(cmd, vk_frame_buffer, ctx.get_family());
+			}
+			vkCmdFillBuffer(cmd, vk_frame_buffer, 0, VK_WHOLE_SIZE, i);
+			record_external_release(cmd, vk_frame_buffer, ctx.get_family());
+			if (!ctx.submit(VK_NULL_HANDLE, ready.get_view().get_handle()).has_value()) {
+				return 1;
+			}
+
+			FrameMessage frame{ i };
+			FrameMessage ack{};
+			if (!send_message(sock, &frame, sizeof(frame)) || !receive_message(sock, &ack, sizeof(ack)) || ack.index != i) {
+				return 1;
+			}
+			if (!ctx.wait_idle().has_value()) {
+				return 1;
+			}
+		}
+
+		std::cout << "producer: sent " << kFrameCount << " frames\n";
+		return 0;
+	}
+
+	int run_consumer(int sock) noexcept {
+		Context ctx{};
+		if (auto res = ctx.setup("fd_share consumer"); !res.has_value()) {
+			std::cerr << "consumer: " << eh::ErrorTypeTrait<gx::ErrorCode>::description(res.error()) << '\n';
+			return 1;
+		}
+		gx::Allocator allocator{ gx::PhysDevice{ ctx.get_phys_device() }, ctx.get_device() };
+		gx::FdInterop interop{ ctx.get_device() };
+
+		SetupMessage setup{};
+		std::array<int, 2> fds{ -1, -1 };
+		if (!receive_message(sock, &setup, sizeof(setup), fds)) {
+			return 1;
+		}
+
+		const auto& info = gx::PhysDeviceInfo::get(ctx.get_phys_device());
+		if (setup.device_uuid != info.device_uuid || setup.driver_uuid != info.driver_uuid) {
+			std::cerr << "consumer: producer runs on a different device or driver\n";
+			close(fds[0]);
+			close(fds[1]);
+			return 1;
+		}
+
+		auto buffer = gx::BufferBuilder{ ctx.get_device() }
+			.with_size(kFrameSize)
+			.with_usage(gx::BufferUsage::eTransferDst | gx::BufferUsage::eTransferSrc)
+			.with_external_handle_types(std::to_underlying(gx::ExternalMemoryHandleType::eOpaqueFd))
+			.build();
+		if (!buffer.has_value()) {
+			return 1;
+		}
+		auto frame_buffer = std::move(*buffer).to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+
+		auto imported = allocator.import_memory_fd(fds[0], setup.size, setup.memory_type, VK_NULL_HANDLE, frame_buffer.get_view().get_handle());
+		if (!imported.has_value()) {
+			close(fds[0]);
+			close(fds[1]);
+			return 1;
+		}
+		auto frame_memory = std::move(*imported).to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+		if (VkResult res = vkBindBufferMemory(ctx.get_device(), frame_buffer.get_view().get_handle(), frame_memory.get_view().get_handle(), 0); res != VK_SUCCESS) {
+			std::cerr << "consumer: " << eh::ErrorTypeTrait<gx::ErrorCode>::description(gx::convert_vk_result(res)) << '\n';
+			close(fds[1]);
+			return 1;
+		}
+
+		auto semaphore = gx::SemaphoreBuilder{ ctx.get_device() }.build();
+		if (!semaphore.has_value()) {
+			close(fds[1]);
+			return 1;
+		}
+		auto ready = std::move(*semaphore).to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+		if (!interop.import_semaphore(ready.get_view(), fds[1]).has_value()) {
+			close(fds[1]);
+			return 1;
+		}
+
+		auto readback = gx::BufferBuilder{ ctx.get_device() }
+			.with_size(kFrameSize)
+			.with_usage(std::to_underlying(gx::BufferUsage::eTransferDst))
+			.build();
+		if (!readback.has_value()) {
+			return 1;
+		}
+		auto readback_buffer = std::move(*readback).to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+
+		auto readback_allocation = allocator.allocate_for_buffer(readback_buffer.get_view().get_handle(), gx::MemoryUsage::eGpuToCpu);
+		if (!readback_allocation.has_value()) {
+			return 1;
+		}
+		auto readback_memory = std::move(*readback_allocation).to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+		const auto* words = static_cast<const u32*>(readback_memory.get_view().get_mapped_ptr());
+
+		for (u32 i = 0; i < kFrameCount; ++i) {
+			FrameMessage frame{};
+			if (!receive_message(sock, &frame, sizeof(frame))) {
+				return 1;
+			}
+
+			VkBuffer vk_frame_buffer = frame_buffer.get_view().get_handle();
+			VkCommandBuffer cmd = ctx.begin();
+			record_external_acquire(cmd, vk_frame_buffer, ctx.get_family());
+
+			VkBufferCopy copy = { 0, 0, kFrameSize };
+			vkCmdCopyBuffer(cmd, vk_frame_buffer, readback_buffer.get_view().get_handle(), 1, &copy);
+			record_external_release(cmd, vk_frame_buffer, ctx.get_family());
+
+			// eGpuToCpu only guarantees host visible memory, the copy has to be made visible and the caches invalidated
+			VkBufferMemoryBarrier host_barrier = {
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.buffer = readback_buffer.get_view().get_handle(),
+				.offset = 0,
+				.size = VK_WHOLE_SIZE,
+			};
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &host_barrier, 0, nullptr);
+
+			if (!ctx.submit(ready.get_view().get_handle(), VK_NULL_HANDLE).has_value() || !ctx.wait_idle().has_value()) {
+				return 1;
+			}
+			if (!allocator.invalidate(readback_memory.get_view()).has_value()) {
+				return 1;
+			}
+
+			if (words[0] != frame.index || words[kFrameSize / sizeof(u32) - 1] != frame.index) {
+				std::cerr << "consumer: frame " << frame.index << " has unexpected contents\n";
+				return 1;
+			}
+
+			if (!send_message(sock, &frame, sizeof(frame))) {
+				return 1;
+			}
+		}
+
+		std::cout << "consumer: received " << kFrameCount << " frames\n";
+		return 0;
+	}
+}
+
+int main() {
+	std::array<int, 2> socks{};
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, socks.data()) != 0) {
+		return 1;
+	}
+
+	// Fork before any Vulkan call, each process creates its own instance and device
+	pid_t pid = fork();
+	if (pid < 0) {
+		return 1;
+	}
+	if (pid == 0) {
+		close(socks[0]);
+		return run_consumer(socks[1]);
+	}
+
+	close(socks[1]);
+	int ret = run_producer(socks[0]);
+	close(socks[0]);
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return ret == 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 1;
+}
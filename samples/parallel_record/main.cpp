@@ -0,0 +1,166 @@
+#include <instance.hpp>
+#include <device.hpp>
+#include <buffer.hpp>
+#include <allocator.hpp>
+#include <cmd_exec.hpp>
+#include <parallel_record.hpp>
+#include <job_system.hpp>
+#include <utils.hpp>
+
+#include <limits>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <ranges>
+#include <algorithm>
+#include <iostream>
+#include <format>
+
+#include <misc/types.hpp>
+
+/*
+* Records the same command list with gx::record_parallel() on 1 to hardware_concurrency threads and prints
+* the recording throughput. Every item is a small vkCmdFillBuffer, so nothing but the recording cost is measured
+* and no render pass or pipeline is needed. Runs headless.
+*/
+
+namespace {
+	constexpr u32 kItemCount = 200'000;
+	constexpr u32 kChunkSize = 1024;
+	constexpr u32 kRunCount = 5;
+	constexpr usize kBufferSize = gx::mb_to_bytes(1);
+}
+
+int main() {
+	auto inst_res = gx::InstanceBuilder{}
+		.with_app_info("parallel_record", gx::Version(0, 1, 0))
+		.build();
+
+	if (!inst_res.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(inst_res.error()) << '\n';
+		return 1;
+	}
+	gx::Instance<meta::List<>, meta::List<>> instance = std::move(inst_res).value();
+
+	auto phys_devices = instance.enum_phys_devices();
+	if (phys_devices.empty()) {
+		std::cerr << "No physical devices\n";
+		return 1;
+	}
+	auto phys_device = phys_devices.front();
+
+	auto device_res = phys_device.get_device_builder()
+		.request_graphics_queues()
+		.build();
+
+	if (!device_res.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(device_res.error()) << '\n';
+		return 1;
+	}
+	auto device = std::move(device_res).value();
+	VkDevice vk_device = device.get_view().get_handle();
+
+	gx::GraphicsQueue graphics_queue = device.get_graphics_queue().value();
+	u32 family = graphics_queue.get_family();
+	VkQueue queue = graphics_queue.get_handle();
+
+	gx::Allocator allocator{ phys_device, vk_device };
+
+	auto buffer_res = device.get_buffer_builder()
+		.with_size(kBufferSize)
+		.with_usage(std::to_underlying(gx::BufferUsage::eTransferDst))
+		.build();
+	if (!buffer_res.has_value()) {
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(buffer_res.error()) << '\n';
+		return 1;
+	}
+	auto allocation_res = allocator.allocate_for_buffer(buffer_res->get_handle());
+	if (!allocation_res.has_value()) {
+		std::move(*buffer_res).destroy();
+		std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(allocation_res.error()) << '\n';
+		return 1;
+	}
+	// Destroyed in reverse order, the buffer goes before its memory
+	auto allocation = std::move(allocation_res).value().to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+	auto buffer = std::move(buffer_res).value().to_owned<gx::MoveOnlyTag, gx::ViewableTag>();
+	VkBuffer vk_buffer = buffer.get_view().get_handle();
+
+	VkFenceCreateInfo fence_ci = {
+		.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	};
+	VkFence fence = VK_NULL_HANDLE;
+	vkCreateFence(vk_device, &fence_ci, nullptr, &fence);
+
+	u32 max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<u32> thread_counts;
+	for (u32 count = 1; count < max_threads; count *= 2) {
+		thread_counts.push_back(count);
+	}
+	thread_counts.push_back(max_threads);
+
+	std::cout << std::format("{:>8} {:>16} {:>8}\n", "threads", "items/s", "speedup");
+	double single_thread_rate = 0.0;
+	for (u32 thread_count : thread_counts) {
+		// The calling thread takes part in the recording, so it counts as one of the threads
+		gx::JobSystem jobs{ thread_count - 1 };
+		gx::CommandAllocator cmd_allocator{ vk_device, gx::CommandAllocatorConfig{ .frames_in_flight = 1, .queue_families = { family } } };
+
+		VkCommandBufferInheritanceInfo inheritance = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+		};
+		gx::ParallelRecordInfo info{
+			.queue_family = family,
+			.item_count = kItemCount,
+			.chunk_size = kChunkSize,
+			.inheritance = &inheritance,
+			.continues_rendering = false,
+		};
+
+		std::chrono::duration<double> best{ std::numeric_limits<double>::max() };
+		for (u32 run : std::views::iota(0u, kRunCount)) {
+			// The previous run waited for the fence, so all pools of the allocator can be reset
+			cmd_allocator.begin_frame(run);
+
+			auto primary = cmd_allocator.begin(family);
+			if (!primary.has_value()) {
+				std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(primary.error()) << '\n';
+				return 1;
+			}
+
+			auto begin = std::chrono::steady_clock::now();
+			auto res = gx::record_parallel(jobs, cmd_allocator, *primary, info,
+				[vk_buffer](gx::CommandRecorder& recorder, u32 first, u32 count) noexcept {
+					for (u32 i : std::views::iota(first, first + count)) {
+						usize offset = (i * 256) % kBufferSize;
+						vkCmdFillBuffer(recorder.get_handle(), vk_buffer, offset, 256, i);
+					}
+				}
+			);
+			best = std::min<std::chrono::duration<double>>(best, std::chrono::steady_clock::now() - begin);
+
+			if (!res.has_value()) {
+				std::cerr << eh::ErrorTypeTrait<gx::ErrorCode>::description(res.error()) << '\n';
+				return 1;
+			}
+			vkEndCommandBuffer(*primary);
+
+			VkSubmitInfo si = {
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+				.commandBufferCount = 1,
+				.pCommandBuffers = &*primary,
+			};
+			vkQueueSubmit(queue, 1, &si, fence);
+			vkWaitForFences(vk_device, 1, &fence, VK_TRUE, std::numeric_limits<u64>::max());
+			vkResetFences(vk_device, 1, &fence);
+		}
+
+		double rate = kItemCount / best.count();
+		if (thread_count == 1) {
+			single_thread_rate = rate;
+		}
+		std::cout << std::format("{:>8} {:>16.0f} {:>7.2f}x\n", thread_count, rate, rate / single_thread_rate);
+	}
+
+	vkDestroyFence(vk_device, fence, nullptr);
+	return 0;
+}
@@ -0,0 +1,218 @@
+#include <aliasing.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace gx {
+	void AliasingPlan::record_barriers(VkCommandBuffer cmd, u32 pass) const noexcept {
+		auto it = std::ranges::lower_bound(barriers_, pass, {}, &PassBarriers::pass);
+		if (it == barriers_.end() || it->pass != pass) {
+			return;
+		}
+
+		// The aliased resources' own barriers don't cover writes made through the previous occupants
+		VkMemoryBarrier memory_barrier = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+		};
+
+		vkCmdPipelineBarrier(cmd,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			it->has_memory_barrier ? 1u : 0u, &memory_barrier,
+			static_cast<u32>(it->buffers.size()), it->buffers.data(),
+			static_cast<u32>(it->images.size()), it->images.data()
+		);
+	}
+
+	AliasingPlanner::AliasingPlanner(Allocator& allocator) noexcept
+		: allocator_{ &allocator }
+		, granularity_{ PhysDeviceInfo::get(allocator.get_phys_device()).limits.buffer_image_granularity }
+	{}
+
+	u32 AliasingPlanner::add_image(ImageView image, u32 first_pass, u32 last_pass, ImageLayout initial_layout, ImageSubresourceRange range) noexcept {
+		assert(first_pass <= last_pass && "AliasingPlanner::add_image(): first_pass must not be greater than last_pass");
+
+		Resource res{
+			.image = image.get_handle(),
+			.first_pass = first_pass,
+			.last_pass = last_pass,
+			.layout = initial_layout,
+			.range = range,
+		};
+		vkGetImageMemoryRequirements(allocator_->get_device(), res.image, &res.reqs);
+		resources_.push_back(res);
+
+		return static_cast<u32>(resources_.size() - 1);
+	}
+
+	u32 AliasingPlanner::add_buffer(BufferView buffer, u32 first_pass, u32 last_pass) noexcept {
+		assert(first_pass <= last_pass && "AliasingPlanner::add_buffer(): first_pass must not be greater than last_pass");
+
+		Resource res{
+			.buffer = buffer.get_handle(),
+			.first_pass = first_pass,
+			.last_pass = last_pass,
+		};
+		vkGetBufferMemoryRequirements(allocator_->get_device(), res.buffer, &res.reqs);
+		resources_.push_back(res);
+
+		return static_cast<u32>(resources_.size() - 1);
+	}
+
+	std::optional<usize> AliasingPlanner::find_offset_(const MemoryBucket& bucket, u32 resource, std::span<const AliasingPlacement> placements) const noexcept {
+		const auto& reqs = resources_[resource].reqs;
+		usize alignment = std::max<usize>(reqs.alignment, granularity_);
+
+		std::vector<std::pair<usize, usize>> busy;
+		for (u32 other : bucket.resources) {
+			if (lifetimes_overlap_(resource, other)) {
+				busy.emplace_back(placements[other].offset, placements[other].offset + placements[other].size);
+			}
+		}
+		std::ranges::sort(busy);
+
+		usize offset = 0;
+		for (auto [begin, end] : busy) {
+			if (align_up(offset, alignment) + reqs.size <= begin) {
+				break;
+			}
+			offset = std::max(offset, end);
+		}
+		offset = align_up(offset, alignment);
+
+		if (offset + reqs.size <= bucket.size) {
+			return offset;
+		}
+		return std::nullopt;
+	}
+
+	auto AliasingPlanner::build() noexcept -> std::expected<AliasingPlan, ErrorCode> {
+		std::vector<u32> order(resources_.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::ranges::stable_sort(order, std::greater{}, [this](u32 i) { return resources_[i].reqs.size; });
+
+		AliasingPlan plan{};
+		plan.placements_.resize(resources_.size());
+
+		std::vector<MemoryBucket> buckets;
+		for (u32 i : order) {
+			const auto& reqs = resources_[i].reqs;
+			plan.unaliased_bytes_ += align_up(reqs.size, std::max<usize>(reqs.alignment, granularity_));
+
+			bool is_placed = false;
+			for (auto&& [bucket_index, bucket] : std::views::zip(std::views::iota(0u), buckets)) {
+				if ((bucket.memory_type_bits & reqs.memoryTypeBits) == 0) {
+					continue;
+				}
+
+				auto offset = find_offset_(bucket, i, plan.placements_);
+				if (offset.has_value()) {
+					plan.placements_[i] = AliasingPlacement{ bucket_index, *offset, reqs.size };
+					bucket.memory_type_bits &= reqs.memoryTypeBits;
+					bucket.alignment = std::max<usize>(bucket.alignment, reqs.alignment);
+					bucket.resources.push_back(i);
+					is_placed = true;
+					break;
+				}
+			}
+
+			if (!is_placed) {
+				plan.placements_[i] = AliasingPlacement{ static_cast<u32>(buckets.size()), 0, reqs.size };
+				buckets.push_back(MemoryBucket{
+					.size = align_up(reqs.size, granularity_),
+					.alignment = std::max<usize>(reqs.alignment, granularity_),
+					.memory_type_bits = reqs.memoryTypeBits,
+					.resources = { i },
+				});
+			}
+		}
+
+		for (const auto& bucket : buckets) {
+			auto allocation = allocator_->allocate(AllocationDesc{
+				.size = bucket.size,
+				.alignment = bucket.alignment,
+				.memory_type_bits = bucket.memory_type_bits,
+				.usage = MemoryUsage::eGpuOnly,
+			});
+
+			if (!allocation.has_value()) {
+				return std::unexpected(allocation.error());
+			}
+			plan.aliased_bytes_ += bucket.size;
+			plan.memory_.push_back(std::move(*allocation).to_owned<MoveOnlyTag, ViewableTag>());
+		}
+
+		VkDevice device = allocator_->get_device();
+		for (auto&& [i, res] : std::views::zip(std::views::iota(0u), resources_)) {
+			const auto& placement = plan.placements_[i];
+			auto memory = plan.memory_[placement.memory_index].get_view();
+
+			VkResult vk_res = res.image != VK_NULL_HANDLE ?
+				vkBindImageMemory(device, res.image, memory.get_handle(), memory.get_offset() + placement.offset) :
+				vkBindBufferMemory(device, res.buffer, memory.get_handle(), memory.get_offset() + placement.offset);
+
+			if (vk_res != VK_SUCCESS) {
+				return std::unexpected(convert_vk_result(vk_res));
+			}
+		}
+
+		// Every other resource in the range is an earlier occupant, either earlier in the frame or at the end of
+		// the previous one, since frames run the same passes again. Images need their layout in any case
+		for (const auto& bucket : buckets) {
+			for (u32 i : bucket.resources) {
+				const auto& res = resources_[i];
+				const auto& placement = plan.placements_[i];
+
+				bool is_aliased = std::ranges::any_of(bucket.resources,
+					[&](u32 other) {
+						const auto& other_placement = plan.placements_[other];
+						return other != i &&
+							other_placement.offset < placement.offset + placement.size &&
+							placement.offset < other_placement.offset + other_placement.size;
+					}
+				);
+
+				if (!is_aliased && res.image == VK_NULL_HANDLE) {
+					continue;
+				}
+
+				auto it = std::ranges::lower_bound(plan.barriers_, res.first_pass, {}, &AliasingPlan::PassBarriers::pass);
+				if (it == plan.barriers_.end() || it->pass != res.first_pass) {
+					it = plan.barriers_.insert(it, AliasingPlan::PassBarriers{ .pass = res.first_pass });
+				}
+				it->has_memory_barrier |= is_aliased;
+
+				if (res.image != VK_NULL_HANDLE) {
+					it->images.push_back(VkImageMemoryBarrier{
+						.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+						.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+						.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+						.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+						.newLayout = image_layout_to_vk(res.layout),
+						.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+						.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+						.image = res.image,
+						.subresourceRange = res.range.to_vk(),
+					});
+				}
+				else {
+					it->buffers.push_back(VkBufferMemoryBarrier{
+						.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+						.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+						.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+						.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+						.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+						.buffer = res.buffer,
+						.offset = 0,
+						.size = VK_WHOLE_SIZE,
+					});
+				}
+			}
+		}
+
+		return plan;
+	}
+}
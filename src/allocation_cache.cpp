@@ -0,0 +1,195 @@
+#include <allocation_cache.hpp>
+
+#include <bit>
+#include <ranges>
+
+namespace gx {
+	namespace {
+		using Slot = ThreadCachedAllocator::Slot;
+
+		constexpr usize kListCount = VK_MAX_MEMORY_TYPES * ThreadCachedAllocator::kClassCount;
+
+		[[nodiscard]]
+		constexpr u32 get_size_class(usize size) noexcept {
+			usize width = std::bit_width(std::max(size, ThreadCachedAllocator::kMinCachedSize) - 1);
+			return static_cast<u32>(width - std::countr_zero(ThreadCachedAllocator::kMinCachedSize));
+		}
+		static_assert(get_size_class(1) == 0);
+		static_assert(get_size_class(256) == 0);
+		static_assert(get_size_class(257) == 1);
+		static_assert(get_size_class(ThreadCachedAllocator::kMaxCachedSize) == ThreadCachedAllocator::kClassCount - 1);
+
+		[[nodiscard]]
+		constexpr u32 get_list_index(u32 memory_type, u32 size_class) noexcept {
+			return memory_type * ThreadCachedAllocator::kClassCount + size_class;
+		}
+	}
+
+	struct ThreadCachedAllocator::ThreadCache {
+		std::array<std::vector<Slot>, kListCount> lists;
+
+		void drain(ThreadCachedAllocator& owner) noexcept {
+			for (u32 index : std::views::iota(0u, static_cast<u32>(kListCount))) {
+				if (!lists[index].empty()) {
+					owner.push_shared_(index, lists[index]);
+					lists[index].clear();
+				}
+			}
+		}
+	};
+
+	thread_local details::ThreadCacheMap<ThreadCachedAllocator, ThreadCachedAllocator::ThreadCache> ThreadCachedAllocator::t_caches_;
+
+	ThreadCachedAllocator::ThreadCachedAllocator(Allocator& allocator) noexcept
+		: allocator_{ &allocator }
+		, id_{ details::register_thread_cache_owner(this) }
+		, granularity_{ PhysDeviceInfo::get(allocator.get_phys_device()).limits.buffer_image_granularity }
+	{}
+
+	ThreadCachedAllocator::~ThreadCachedAllocator() noexcept {
+		// Thread caches still holding slots of the slabs drop them once the cache is gone
+		details::unregister_thread_cache_owner(id_);
+	}
+
+	void ThreadCachedAllocator::push_shared_(u32 index, std::span<const Slot> slots) noexcept {
+		auto& shared = shared_[index];
+		std::lock_guard lock{ shared.mutex };
+		shared.slots.insert(shared.slots.end(), slots.begin(), slots.end());
+	}
+
+	auto ThreadCachedAllocator::refill_(MemoryUsage usage, u32 memory_type, u32 size_class, std::vector<Slot>& local) noexcept -> std::expected<void, ErrorCode> {
+		{
+			auto& shared = shared_[get_list_index(memory_type, size_class)];
+			std::lock_guard lock{ shared.mutex };
+
+			if (!shared.slots.empty()) {
+				usize count = std::min<usize>(kBatchSize, shared.slots.size());
+				local.insert(local.end(), shared.slots.end() - count, shared.slots.end());
+				shared.slots.resize(shared.slots.size() - count);
+
+				refill_count_.fetch_add(1, std::memory_order_relaxed);
+				return {};
+			}
+		}
+
+		usize stride = get_slot_stride_(size_class);
+		AllocationDesc desc{
+			.size = stride * kSlabSlots,
+			.alignment = stride,
+			.memory_type_bits = 1u << memory_type,
+			.usage = usage,
+		};
+
+		auto slab = allocator_->allocate(desc);
+		if (!slab.has_value()) {
+			return std::unexpected(slab.error());
+		}
+
+		VkDeviceMemory memory = slab->get_handle();
+		usize base = slab->get_offset();
+		auto* mapped = static_cast<u8*>(slab->get_mapped_ptr());
+
+		// Lowest offsets are handed out first
+		for (u32 i : std::views::iota(0u, kSlabSlots) | std::views::reverse) {
+			local.push_back(Slot{
+				.memory = memory,
+				.offset = base + i * stride,
+				.mapped = mapped != nullptr ? mapped + i * stride : nullptr,
+			});
+		}
+
+		{
+			std::lock_guard lock{ slabs_mutex_ };
+			slabs_.push_back(std::move(*slab).to_owned<MoveOnlyTag, ViewableTag>());
+		}
+		slab_count_.fetch_add(1, std::memory_order_relaxed);
+		slab_bytes_.fetch_add(desc.size, std::memory_order_relaxed);
+
+		return {};
+	}
+
+	auto ThreadCachedAllocator::allocate(const AllocationDesc& desc) noexcept -> std::expected<CachedAllocation, ErrorCode> {
+		assert(is_cacheable(desc) && "ThreadCachedAllocator::allocate(): request can't be cached");
+
+		auto memory_type = allocator_->find_memory_type(desc.memory_type_bits, desc.usage);
+		if (!memory_type.has_value()) {
+			return std::unexpected(ErrorCode::eMemoryTypeNotPresent);
+		}
+		u32 size_class = get_size_class(std::max(desc.size, desc.alignment));
+
+		auto& local = t_caches_.get(id_).lists[get_list_index(*memory_type, size_class)];
+		if (local.empty()) {
+			auto res = refill_(desc.usage, *memory_type, size_class, local);
+			if (!res.has_value()) {
+				return std::unexpected(res.error());
+			}
+		}
+
+		Slot slot = local.back();
+		local.pop_back();
+
+		CachedAllocationValue value{};
+		value.handle = slot.memory;
+		value.parent = this;
+		value.offset = slot.offset;
+		value.size = desc.size;
+		value.mapped = slot.mapped;
+		value.memory_type = *memory_type;
+		value.size_class = size_class;
+		return CachedAllocation{ value };
+	}
+
+	auto ThreadCachedAllocator::allocate_for_buffer(VkBuffer buffer, MemoryUsage usage) noexcept -> std::expected<CachedAllocation, ErrorCode> {
+		VkMemoryRequirements reqs{};
+		vkGetBufferMemoryRequirements(allocator_->get_device(), buffer, &reqs);
+
+		auto allocation = allocate(AllocationDesc::from_vk(reqs, usage));
+		if (!allocation.has_value()) {
+			return allocation;
+		}
+
+		VkResult res = vkBindBufferMemory(allocator_->get_device(), buffer, allocation->get_handle(), allocation->get_offset());
+		if (res != VK_SUCCESS) {
+			std::move(*allocation).destroy();
+			return std::unexpected(convert_vk_result(res));
+		}
+		return allocation;
+	}
+
+	void ThreadCachedAllocator::free_(const CachedAllocationValue& allocation) noexcept {
+		Slot slot{
+			.memory = allocation.handle,
+			.offset = allocation.offset,
+			.mapped = allocation.mapped,
+		};
+		u32 index = get_list_index(allocation.memory_type, allocation.size_class);
+
+		if (auto* cache = t_caches_.find(id_); cache != nullptr) {
+			auto& local = cache->lists[index];
+			local.push_back(slot);
+			if (local.size() <= kSlabSlots + kBatchSize) {
+				return;
+			}
+
+			// The coldest slots go back, the most recently freed ones stay for the next allocations
+			auto& shared = shared_[index];
+			std::lock_guard lock{ shared.mutex };
+			shared.slots.insert(shared.slots.end(), local.begin(), local.begin() + kBatchSize);
+			local.erase(local.begin(), local.begin() + kBatchSize);
+
+			drain_count_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		push_shared_(index, std::span{ &slot, 1 });
+	}
+
+	ThreadCacheStats ThreadCachedAllocator::get_stats() const noexcept {
+		return ThreadCacheStats{
+			.slab_count = slab_count_.load(std::memory_order_relaxed),
+			.slab_bytes = slab_bytes_.load(std::memory_order_relaxed),
+			.refill_count = refill_count_.load(std::memory_order_relaxed),
+			.drain_count = drain_count_.load(std::memory_order_relaxed),
+		};
+	}
+}
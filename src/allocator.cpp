@@ -0,0 +1,780 @@
+#include <allocator.hpp>
+
+#include <bit>
+#include <algorithm>
+
+namespace gx {
+	namespace details {
+		TlsfPool::TlsfPool() noexcept {
+			for (auto& sl_heads : heads_) {
+				sl_heads.fill(kNil);
+			}
+		}
+
+		std::pair<u32, u32> TlsfPool::mapping_(usize size) noexcept {
+			if (size < kSlCount) {
+				return { 0u, static_cast<u32>(size) };
+			}
+			u32 fl = static_cast<u32>(std::bit_width(size)) - 1;
+			u32 sl = static_cast<u32>(size >> (fl - kSlLog2)) ^ kSlCount;
+			return { fl - kSlLog2 + 1, sl };
+		}
+
+		usize TlsfPool::round_up_for_search_(usize size) noexcept {
+			if (size < kSlCount) {
+				return size;
+			}
+			u32 fl = static_cast<u32>(std::bit_width(size)) - 1;
+			return size + (usize{ 1 } << (fl - kSlLog2)) - 1;
+		}
+
+		u32 TlsfPool::find_free_(usize size) const noexcept {
+			auto [fl, sl] = mapping_(round_up_for_search_(size));
+			if (fl >= kFlCount) {
+				return kNil;
+			}
+
+			u32 sl_map = sl_bitmaps_[fl] & (~0u << sl);
+			if (sl_map == 0) {
+				u64 fl_map = fl_bitmap_ & (~u64{ 0 } << (fl + 1));
+				if (fl_map == 0) {
+					return kNil;
+				}
+				fl = static_cast<u32>(std::countr_zero(fl_map));
+				sl_map = sl_bitmaps_[fl];
+			}
+			sl = static_cast<u32>(std::countr_zero(sl_map));
+
+			return heads_[fl][sl];
+		}
+
+		void TlsfPool::insert_free_(u32 node) noexcept {
+			auto [fl, sl] = mapping_(nodes_[node].size);
+			u32 head = heads_[fl][sl];
+
+			nodes_[node].is_free = true;
+			nodes_[node].prev_free = kNil;
+			nodes_[node].next_free = head;
+			if (head != kNil) {
+				nodes_[head].prev_free = node;
+			}
+			heads_[fl][sl] = node;
+
+			fl_bitmap_ |= u64{ 1 } << fl;
+			sl_bitmaps_[fl] |= 1u << sl;
+		}
+
+		void TlsfPool::remove_free_(u32 node) noexcept {
+			auto [fl, sl] = mapping_(nodes_[node].size);
+			Node& n = nodes_[node];
+
+			if (n.prev_free != kNil) {
+				nodes_[n.prev_free].next_free = n.next_free;
+			}
+			if (n.next_free != kNil) {
+				nodes_[n.next_free].prev_free = n.prev_free;
+			}
+
+			if (heads_[fl][sl] == node) {
+				heads_[fl][sl] = n.next_free;
+				if (n.next_free == kNil) {
+					sl_bitmaps_[fl] &= ~(1u << sl);
+					if (sl_bitmaps_[fl] == 0) {
+						fl_bitmap_ &= ~(u64{ 1 } << fl);
+					}
+				}
+			}
+
+			n.is_free = false;
+			n.prev_free = kNil;
+			n.next_free = kNil;
+		}
+
+		u32 TlsfPool::acquire_node_() noexcept {
+			if (!free_nodes_.empty()) {
+				u32 node = free_nodes_.back();
+				free_nodes_.pop_back();
+				return node;
+			}
+			nodes_.emplace_back();
+			return static_cast<u32>(nodes_.size() - 1);
+		}
+
+		void TlsfPool::release_node_(u32 node) noexcept {
+			nodes_[node] = Node{};
+			free_nodes_.push_back(node);
+		}
+
+		u32 TlsfPool::split_(u32 node, usize size) noexcept {
+			u32 rest = acquire_node_();
+			Node& n = nodes_[node];
+
+			nodes_[rest] = Node{
+				.offset = n.offset + size,
+				.size = n.size - size,
+				.block = n.block,
+				.prev_phys = node,
+				.next_phys = n.next_phys,
+			};
+			if (n.next_phys != kNil) {
+				nodes_[n.next_phys].prev_phys = rest;
+			}
+			n.next_phys = rest;
+			n.size = size;
+
+			return rest;
+		}
+
+		std::optional<TlsfPool::Region> TlsfPool::allocate(usize size, usize alignment) noexcept {
+			size = align_up(std::max(size, usize{ 1 }), kMinAlignment);
+			alignment = std::max(alignment, kMinAlignment);
+
+			// Offsets are always multiples of kMinAlignment, so padding never exceeds alignment - kMinAlignment
+			usize search_size = size + alignment - kMinAlignment;
+			u32 node = find_free_(search_size);
+			if (node == kNil) {
+				return std::nullopt;
+			}
+			remove_free_(node);
+
+			usize padding = align_up(nodes_[node].offset, alignment) - nodes_[node].offset;
+			if (padding != 0) {
+				u32 body = split_(node, padding);
+				insert_free_(node);
+				node = body;
+			}
+
+			if (nodes_[node].size > size) {
+				insert_free_(split_(node, size));
+			}
+			blocks_[nodes_[node].block].used += nodes_[node].size;
+
+			return Region{
+				.block = nodes_[node].block,
+				.node = node,
+				.offset = nodes_[node].offset,
+			};
+		}
+
+		std::optional<u32> TlsfPool::free(u32 node) noexcept {
+			assert(!nodes_[node].is_free && "TlsfPool::free(): double free");
+			blocks_[nodes_[node].block].used -= nodes_[node].size;
+
+			u32 prev = nodes_[node].prev_phys;
+			if (prev != kNil && nodes_[prev].is_free) {
+				remove_free_(prev);
+				nodes_[prev].size += nodes_[node].size;
+				nodes_[prev].next_phys = nodes_[node].next_phys;
+				if (nodes_[node].next_phys != kNil) {
+					nodes_[nodes_[node].next_phys].prev_phys = prev;
+				}
+				release_node_(node);
+				node = prev;
+			}
+
+			u32 next = nodes_[node].next_phys;
+			if (next != kNil && nodes_[next].is_free) {
+				remove_free_(next);
+				nodes_[node].size += nodes_[next].size;
+				nodes_[node].next_phys = nodes_[next].next_phys;
+				if (nodes_[next].next_phys != kNil) {
+					nodes_[nodes_[next].next_phys].prev_phys = node;
+				}
+				release_node_(next);
+			}
+
+			insert_free_(node);
+
+			if (nodes_[node].prev_phys == kNil && nodes_[node].next_phys == kNil) {
+				return node;
+			}
+			return std::nullopt;
+		}
+
+		u32 TlsfPool::add_block(VkDeviceMemory memory, usize size, u8* mapped) noexcept {
+			u32 block = 0;
+			if (!free_blocks_.empty()) {
+				block = free_blocks_.back();
+				free_blocks_.pop_back();
+			}
+			else {
+				blocks_.emplace_back();
+				block = static_cast<u32>(blocks_.size() - 1);
+			}
+			blocks_[block] = Block{ memory, size, mapped, 0 };
+			++block_count_;
+
+			u32 node = acquire_node_();
+			nodes_[node] = Node{
+				.offset = 0,
+				.size = size,
+				.block = block,
+			};
+			insert_free_(node);
+
+			return block;
+		}
+
+		TlsfPool::Block TlsfPool::remove_block(u32 node) noexcept {
+			assert(nodes_[node].prev_phys == kNil && nodes_[node].next_phys == kNil && "TlsfPool::remove_block(): block is in use");
+
+			u32 block = nodes_[node].block;
+			remove_free_(node);
+			release_node_(node);
+
+			Block ret = blocks_[block];
+			blocks_[block] = Block{};
+			free_blocks_.push_back(block);
+			--block_count_;
+
+			return ret;
+		}
+	}
+
+	Allocator::Allocator(PhysDevice phys_device, VkDevice device, AllocatorConfig config) noexcept
+		: device_{ device }
+		, phys_device_{ phys_device.get_handle() }
+		, config_{ config }
+	{
+		const auto& info = phys_device.get_info();
+		granularity_ = std::max(info.limits.buffer_image_granularity, details::TlsfPool::kMinAlignment);
+		non_coherent_atom_size_ = info.limits.non_coherent_atom_size;
+
+		pools_.reserve(info.memory_infos.size());
+		for (const auto& mem_info : info.memory_infos) {
+			auto pool = std::make_unique<MemoryPool>();
+
+			// Small heaps (e.g. 256 MiB BAR) would be exhausted by a few default-sized blocks
+			pool->block_size = mem_info.budget <= gb_to_bytes(1) ?
+				std::min(config_.block_size, mem_info.budget / 8) :
+				config_.block_size;
+			pool->heap_index = mem_info.heap_index;
+			pool->is_host_visible = test_bit(mem_info.memory_properties, MemoryProperties::eHostVisible);
+			pool->is_host_coherent = test_bit(mem_info.memory_properties, MemoryProperties::eHostCoherent);
+			pools_.push_back(std::move(pool));
+		}
+		memory_type_lists_ = info.memory_type_lists;
+
+		has_memory_budget_ = is_memory_budget_enabled(device);
+		update_budget();
+	}
+
+	Allocator::~Allocator() noexcept {
+		for (auto&& [memory_type, pool] : std::views::zip(std::views::iota(0u), pools_)) {
+			for (const auto& block : pool->tlsf.get_blocks()) {
+				if (block.memory != VK_NULL_HANDLE) {
+					free_device_memory_(block.memory, block.size, memory_type);
+				}
+			}
+		}
+	}
+
+	VkMappedMemoryRange Allocator::get_mapped_range_(AllocationView allocation, usize offset, usize size) const noexcept {
+		if (size == VK_WHOLE_SIZE) {
+			size = allocation.get_size() - offset;
+		}
+		// VUID-VkMappedMemoryRange-offset-00687
+		usize begin = allocation.get_offset() + offset;
+		usize aligned_begin = begin / non_coherent_atom_size_ * non_coherent_atom_size_;
+		usize aligned_end = align_up(begin + size, non_coherent_atom_size_);
+
+		// VUID-VkMappedMemoryRange-size-01390, the atom may reach past the end of the memory object
+		usize memory_size = allocation.is_dedicated() ? allocation.get_size() : pools_[allocation.get_memory_type()]->block_size;
+		return VkMappedMemoryRange{
+			.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+			.memory = allocation.get_handle(),
+			.offset = aligned_begin,
+			.size = aligned_end >= memory_size ? VK_WHOLE_SIZE : aligned_end - aligned_begin,
+		};
+	}
+
+	auto Allocator::flush(AllocationView allocation, usize offset, usize size) const noexcept -> std::expected<void, ErrorCode> {
+		if (pools_[allocation.get_memory_type()]->is_host_coherent) {
+			return {};
+		}
+
+		auto range = get_mapped_range_(allocation, offset, size);
+		VkResult res = vkFlushMappedMemoryRanges(device_, 1, &range);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+		return {};
+	}
+
+	auto Allocator::invalidate(AllocationView allocation, usize offset, usize size) const noexcept -> std::expected<void, ErrorCode> {
+		if (pools_[allocation.get_memory_type()]->is_host_coherent) {
+			return {};
+		}
+
+		auto range = get_mapped_range_(allocation, offset, size);
+		VkResult res = vkInvalidateMappedMemoryRanges(device_, 1, &range);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+		return {};
+	}
+
+	HeapStats Allocator::get_heap_stats(u32 heap_index) const noexcept {
+		const auto& counters = heap_counters_[heap_index];
+		return HeapStats {
+			.block_count = counters.block_count.load(std::memory_order_relaxed),
+			.block_bytes = counters.block_bytes.load(std::memory_order_relaxed),
+			.allocation_count = counters.allocation_count.load(std::memory_order_relaxed),
+			.allocation_bytes = counters.allocation_bytes.load(std::memory_order_relaxed),
+			.dedicated_count = counters.dedicated_count.load(std::memory_order_relaxed),
+			.dedicated_bytes = counters.dedicated_bytes.load(std::memory_order_relaxed),
+		};
+	}
+
+	HeapStats Allocator::get_total_stats() const noexcept {
+		HeapStats ret{};
+		for (u32 heap : std::views::iota(0u, static_cast<u32>(PhysDeviceInfo::get(phys_device_).memory_heap_sizes.size()))) {
+			auto stats = get_heap_stats(heap);
+			ret.block_count += stats.block_count;
+			ret.block_bytes += stats.block_bytes;
+			ret.allocation_count += stats.allocation_count;
+			ret.allocation_bytes += stats.allocation_bytes;
+			ret.dedicated_count += stats.dedicated_count;
+			ret.dedicated_bytes += stats.dedicated_bytes;
+		}
+		return ret;
+	}
+
+	HeapBudget Allocator::get_heap_budget(u32 heap_index) const noexcept {
+		const auto& counters = heap_counters_[heap_index];
+		usize heap_size = PhysDeviceInfo::get(phys_device_).memory_heap_sizes[heap_index];
+
+		HeapBudget ret{ .stats = get_heap_stats(heap_index) };
+		if (has_memory_budget_) {
+			usize fetched_usage = counters.fetched_usage.load(std::memory_order_relaxed);
+			usize fetched_block_bytes = counters.fetched_block_bytes.load(std::memory_order_relaxed);
+
+			if (ret.stats.block_bytes >= fetched_block_bytes) {
+				ret.usage = fetched_usage + (ret.stats.block_bytes - fetched_block_bytes);
+			}
+			else {
+				usize freed = fetched_block_bytes - ret.stats.block_bytes;
+				ret.usage = fetched_usage > freed ? fetched_usage - freed : 0;
+			}
+			ret.budget = std::min(counters.fetched_budget.load(std::memory_order_relaxed), heap_size);
+		}
+		else {
+			// Same heuristic as VMA: other processes and the driver itself usually take ~20% of a heap
+			ret.usage = ret.stats.block_bytes;
+			ret.budget = heap_size / 10 * 8;
+		}
+		return ret;
+	}
+
+	void Allocator::update_budget() noexcept {
+		if (!has_memory_budget_) {
+			return;
+		}
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_props = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+		};
+		VkPhysicalDeviceMemoryProperties2 props = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+			.pNext = &budget_props,
+		};
+
+		std::lock_guard lock{ budget_mutex_ };
+		vkGetPhysicalDeviceMemoryProperties2(phys_device_, &props);
+
+		for (u32 heap : std::views::iota(0u, props.memoryProperties.memoryHeapCount)) {
+			auto& counters = heap_counters_[heap];
+			counters.fetched_block_bytes.store(counters.block_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			counters.fetched_usage.store(budget_props.heapUsage[heap], std::memory_order_relaxed);
+
+			// Some drivers report 0 for heaps they don't track
+			usize budget = budget_props.heapBudget[heap] != 0 ? budget_props.heapBudget[heap] : props.memoryProperties.memoryHeaps[heap].size / 10 * 8;
+			counters.fetched_budget.store(budget, std::memory_order_relaxed);
+		}
+	}
+
+	auto Allocator::allocate_device_memory_(usize size, u32 memory_type, const void* next, bool map) noexcept -> std::expected<std::pair<VkDeviceMemory, u8*>, ErrorCode> {
+		const auto& limits = PhysDeviceInfo::get(phys_device_).limits;
+		if (device_allocation_count_.load(std::memory_order_relaxed) >= limits.max_memory_allocation_count) {
+			return std::unexpected(ErrorCode::eTooManyObjects);
+		}
+
+		if (config_.respect_budget && !get_heap_budget(get_heap_index_(memory_type)).can_fit(size)) {
+			return std::unexpected(ErrorCode::eOutOfDeviceMemory);
+		}
+
+		VkMemoryAllocateFlagsInfo flags_info = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+			.pNext = next,
+			.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+		};
+
+		VkMemoryAllocateInfo ai = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+			.pNext = config_.use_buffer_device_address ? &flags_info : next,
+			.allocationSize = size,
+			.memoryTypeIndex = memory_type,
+		};
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkResult res = vkAllocateMemory(device_, &ai, get_allocation_callbacks(device_), &memory);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+
+		u8* mapped = nullptr;
+		if (map && pools_[memory_type]->is_host_visible) {
+			void* ptr = nullptr;
+			res = vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, &ptr);
+			if (res != VK_SUCCESS) {
+				vkFreeMemory(device_, memory, get_allocation_callbacks(device_));
+				return std::unexpected(convert_vk_result(res));
+			}
+			mapped = static_cast<u8*>(ptr);
+		}
+
+		auto& counters = heap_counters_[get_heap_index_(memory_type)];
+		counters.block_count.fetch_add(1, std::memory_order_relaxed);
+		counters.block_bytes.fetch_add(size, std::memory_order_relaxed);
+		device_allocation_count_.fetch_add(1, std::memory_order_relaxed);
+
+		return std::make_pair(memory, mapped);
+	}
+
+	void Allocator::free_device_memory_(VkDeviceMemory memory, usize size, u32 memory_type) noexcept {
+		vkFreeMemory(device_, memory, get_allocation_callbacks(device_));
+
+		auto& counters = heap_counters_[get_heap_index_(memory_type)];
+		counters.block_count.fetch_sub(1, std::memory_order_relaxed);
+		counters.block_bytes.fetch_sub(size, std::memory_order_relaxed);
+		device_allocation_count_.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	auto Allocator::allocate_dedicated_(const AllocationDesc& desc, u32 memory_type) noexcept -> std::expected<AllocationValue, ErrorCode> {
+		VkMemoryDedicatedAllocateInfo dedicated_info = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+			.image = desc.dedicated_image,
+			.buffer = desc.dedicated_buffer,
+		};
+		bool has_resource = desc.dedicated_image != VK_NULL_HANDLE || desc.dedicated_buffer != VK_NULL_HANDLE;
+
+		VkExportMemoryAllocateInfo export_info = {
+			.sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+			.pNext = has_resource ? &dedicated_info : nullptr,
+			.handleTypes = external_memory_handle_types_to_vk(desc.export_handle_types),
+		};
+
+		const void* next = has_resource ? &dedicated_info : nullptr;
+		if (desc.export_handle_types != 0) {
+			next = &export_info;
+		}
+
+		return allocate_device_memory_(desc.size, memory_type, next)
+			.transform(
+				[this, &desc, memory_type](std::pair<VkDeviceMemory, u8*> memory) noexcept {
+					AllocationValue value{};
+					value.handle = memory.first;
+					value.parent = this;
+					value.size = desc.size;
+					value.memory_type = memory_type;
+					value.mapped = memory.second;
+					return value;
+				}
+			);
+	}
+
+	auto Allocator::allocate_value_(const AllocationDesc& desc) noexcept -> std::expected<AllocationValue, ErrorCode> {
+		ErrorCode error = ErrorCode::eMemoryTypeNotPresent;
+
+		for (u32 memory_type : memory_type_lists_[std::to_underlying(desc.usage)].get()) {
+			if ((desc.memory_type_bits & (1u << memory_type)) == 0) {
+				continue;
+			}
+
+			auto value = allocate_from_type_(desc, memory_type);
+			if (value.has_value() || (value.error() != ErrorCode::eOutOfDeviceMemory && value.error() != ErrorCode::eTooManyObjects)) {
+				return value;
+			}
+			error = value.error();
+		}
+		return std::unexpected(error);
+	}
+
+	auto Allocator::allocate_from_type_(const AllocationDesc& desc, u32 memory_type) noexcept -> std::expected<AllocationValue, ErrorCode> {
+		u32 heap_index = get_heap_index_(memory_type);
+		auto& pool = *pools_[memory_type];
+		auto& counters = heap_counters_[heap_index];
+
+		bool is_dedicated = desc.requires_dedicated || desc.export_handle_types != 0 ||
+			(desc.prefers_dedicated && config_.use_dedicated_preference) ||
+			desc.size > std::min(config_.dedicated_threshold, pool.block_size / 2);
+
+		AllocationValue value{};
+		if (is_dedicated) {
+			auto res = allocate_dedicated_(desc, memory_type);
+			if (!res.has_value()) {
+				return res;
+			}
+			value = *res;
+
+			counters.dedicated_count.fetch_add(1, std::memory_order_relaxed);
+			counters.dedicated_bytes.fetch_add(desc.size, std::memory_order_relaxed);
+		}
+		else {
+			usize alignment = std::max(desc.alignment, granularity_);
+
+			std::lock_guard lock{ pool.mutex };
+			auto region = pool.tlsf.allocate(desc.size, alignment);
+
+			if (!region.has_value()) {
+				if (counters.pool_block_count.load(std::memory_order_relaxed) >= config_.max_blocks_per_heap) {
+					return std::unexpected(ErrorCode::eTooManyObjects);
+				}
+
+				auto memory = allocate_device_memory_(pool.block_size, memory_type);
+				if (!memory.has_value()) {
+					return std::unexpected(memory.error());
+				}
+				[[maybe_unused]] u32 block = pool.tlsf.add_block(memory->first, pool.block_size, memory->second);
+				counters.pool_block_count.fetch_add(1, std::memory_order_relaxed);
+
+				region = pool.tlsf.allocate(desc.size, alignment);
+				assert(region.has_value() && "Allocator::allocate(): fresh block must fit the allocation");
+			}
+
+			const auto& block = pool.tlsf.get_block(region->block);
+			value.handle = block.memory;
+			value.parent = this;
+			value.offset = region->offset;
+			value.size = desc.size;
+			value.memory_type = memory_type;
+			value.node = region->node;
+			value.mapped = block.mapped != nullptr ? block.mapped + region->offset : nullptr;
+		}
+
+		counters.allocation_count.fetch_add(1, std::memory_order_relaxed);
+		counters.allocation_bytes.fetch_add(desc.size, std::memory_order_relaxed);
+
+		return value;
+	}
+
+	auto Allocator::allocate(const AllocationDesc& desc) noexcept -> std::expected<Allocation, ErrorCode> {
+		return allocate_value_(desc)
+			.transform(
+				[](AllocationValue value) noexcept {
+					return Allocation{ value };
+				}
+			);
+	}
+
+	auto Allocator::allocate_for_image(VkImage image, MemoryUsage usage, ExternalMemoryHandleTypeFlags export_handle_types) noexcept -> std::expected<Allocation, ErrorCode> {
+		VkMemoryDedicatedRequirements dedicated_reqs = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+		};
+		VkMemoryRequirements2 reqs = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+			.pNext = &dedicated_reqs,
+		};
+		VkImageMemoryRequirementsInfo2 info = {
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2,
+			.image = image,
+		};
+		vkGetImageMemoryRequirements2(device_, &info, &reqs);
+
+		auto desc = AllocationDesc::from_vk(reqs, dedicated_reqs, usage);
+		desc.dedicated_image = image;
+		desc.export_handle_types = export_handle_types;
+
+		auto value = allocate_value_(desc);
+		if (!value.has_value()) {
+			return std::unexpected(value.error());
+		}
+
+		VkResult res = vkBindImageMemory(device_, image, value->handle, value->offset);
+		if (res != VK_SUCCESS) {
+			free_(*value);
+			return std::unexpected(convert_vk_result(res));
+		}
+		return Allocation{ *value };
+	}
+
+	auto Allocator::allocate_for_buffer(VkBuffer buffer, MemoryUsage usage, ExternalMemoryHandleTypeFlags export_handle_types) noexcept -> std::expected<Allocation, ErrorCode> {
+		VkMemoryDedicatedRequirements dedicated_reqs = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+		};
+		VkMemoryRequirements2 reqs = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+			.pNext = &dedicated_reqs,
+		};
+		VkBufferMemoryRequirementsInfo2 info = {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2,
+			.buffer = buffer,
+		};
+		vkGetBufferMemoryRequirements2(device_, &info, &reqs);
+
+		auto desc = AllocationDesc::from_vk(reqs, dedicated_reqs, usage);
+		desc.dedicated_buffer = buffer;
+		desc.export_handle_types = export_handle_types;
+
+		auto value = allocate_value_(desc);
+		if (!value.has_value()) {
+			return std::unexpected(value.error());
+		}
+
+		VkResult res = vkBindBufferMemory(device_, buffer, value->handle, value->offset);
+		if (res != VK_SUCCESS) {
+			free_(*value);
+			return std::unexpected(convert_vk_result(res));
+		}
+		return Allocation{ *value };
+	}
+
+	auto Allocator::import_host_memory(void* ptr, usize size, u32 memory_type_bits) noexcept -> std::expected<Allocation, ErrorCode> {
+		[[maybe_unused]] usize alignment = PhysDeviceInfo::get(phys_device_).limits.min_imported_host_pointer_alignment;
+		// VUID-VkImportMemoryHostPointerInfoEXT-pHostPointer-01749
+		assert(alignment != 0 && reinterpret_cast<usize>(ptr) % alignment == 0 &&
+			"ptr must be aligned to minImportedHostPointerAlignment");
+		// VUID-VkMemoryAllocateInfo-allocationSize-01745
+		assert(size % alignment == 0 &&
+			"size must be a multiple of minImportedHostPointerAlignment");
+
+		// Imported pages are owned by the user, prefer types the staging path would use for the same data
+		auto memory_type = find_memory_type(memory_type_bits, MemoryUsage::eCpuOnly);
+		if (!memory_type.has_value() && memory_type_bits != 0) {
+			memory_type = static_cast<u32>(std::countr_zero(memory_type_bits));
+		}
+		if (!memory_type.has_value()) {
+			return std::unexpected(ErrorCode::eInvalidExternalHandle);
+		}
+
+		VkImportMemoryHostPointerInfoEXT import_info = {
+			.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT,
+			.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+			.pHostPointer = ptr,
+		};
+
+		return import_dedicated_(size, *memory_type, &import_info, ptr);
+	}
+
+	auto Allocator::import_memory_fd(int fd, usize size, u32 memory_type, VkImage image, VkBuffer buffer) noexcept -> std::expected<Allocation, ErrorCode> {
+		// VUID-VkImportMemoryFdInfoKHR-handleType-00670
+		assert(fd >= 0 && "Allocator::import_memory_fd(): fd must be a valid file descriptor");
+		// VUID-VkMemoryDedicatedAllocateInfo-image-01432
+		assert((image == VK_NULL_HANDLE || buffer == VK_NULL_HANDLE) && "At most one of image and buffer can be set");
+		if (memory_type >= pools_.size()) {
+			return std::unexpected(ErrorCode::eMemoryTypeNotPresent);
+		}
+
+		VkMemoryDedicatedAllocateInfo dedicated_info = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+			.image = image,
+			.buffer = buffer,
+		};
+
+		VkImportMemoryFdInfoKHR import_info = {
+			.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,
+			.pNext = image != VK_NULL_HANDLE || buffer != VK_NULL_HANDLE ? &dedicated_info : nullptr,
+			.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,
+			.fd = fd,
+		};
+
+		return import_dedicated_(size, memory_type, &import_info, nullptr);
+	}
+
+	auto Allocator::import_dedicated_(usize size, u32 memory_type, const void* import_info, void* mapped) noexcept -> std::expected<Allocation, ErrorCode> {
+		auto memory = allocate_device_memory_(size, memory_type, import_info, false);
+		if (!memory.has_value()) {
+			return std::unexpected(memory.error());
+		}
+
+		AllocationValue value{};
+		value.handle = memory->first;
+		value.parent = this;
+		value.size = size;
+		value.memory_type = memory_type;
+		value.mapped = mapped;
+
+		auto& counters = heap_counters_[get_heap_index_(memory_type)];
+		counters.allocation_count.fetch_add(1, std::memory_order_relaxed);
+		counters.allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+		counters.dedicated_count.fetch_add(1, std::memory_order_relaxed);
+		counters.dedicated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+		return Allocation{ value };
+	}
+
+	void Allocator::free_(const AllocationValue& allocation) noexcept {
+		auto& counters = heap_counters_[get_heap_index_(allocation.memory_type)];
+		counters.allocation_count.fetch_sub(1, std::memory_order_relaxed);
+		counters.allocation_bytes.fetch_sub(allocation.size, std::memory_order_relaxed);
+
+		if (allocation.node == details::TlsfPool::kNil) {
+			counters.dedicated_count.fetch_sub(1, std::memory_order_relaxed);
+			counters.dedicated_bytes.fetch_sub(allocation.size, std::memory_order_relaxed);
+			free_device_memory_(allocation.handle, allocation.size, allocation.memory_type);
+			return;
+		}
+
+		auto& pool = *pools_[allocation.memory_type];
+		std::lock_guard lock{ pool.mutex };
+
+		auto empty_block = pool.tlsf.free(allocation.node);
+		// Keep the last block alive so an alloc/free pair at the edge doesn't hit vkAllocateMemory every time
+		if (empty_block.has_value() && pool.tlsf.get_block_count() > 1) {
+			auto block = pool.tlsf.remove_block(*empty_block);
+			free_device_memory_(block.memory, block.size, allocation.memory_type);
+			heap_counters_[pool.heap_index].pool_block_count.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+
+	std::optional<AllocationValue> Allocator::allocate_for_move_(const AllocationValue& src, usize alignment) noexcept {
+		if (src.node == details::TlsfPool::kNil) {
+			return std::nullopt;
+		}
+
+		auto& pool = *pools_[src.memory_type];
+		std::unique_lock lock{ pool.mutex };
+
+		u32 src_block = pool.tlsf.get_node_block(src.node);
+		usize src_used = pool.tlsf.get_block(src_block).used;
+
+		auto region = pool.tlsf.allocate(src.size, std::max(alignment, granularity_));
+		if (!region.has_value()) {
+			return std::nullopt;
+		}
+
+		const auto& dst_block = pool.tlsf.get_block(region->block);
+		bool is_better = region->block != src_block ?
+			dst_block.used - align_up(src.size, details::TlsfPool::kMinAlignment) >= src_used :
+			region->offset < src.offset;
+
+		if (!is_better) {
+			// An emptied block is kept as is, it's released by the regular free path later
+			[[maybe_unused]] auto empty_block = pool.tlsf.free(region->node);
+			return std::nullopt;
+		}
+
+		AllocationValue value = src;
+		value.handle = dst_block.memory;
+		value.offset = region->offset;
+		value.node = region->node;
+		value.mapped = dst_block.mapped != nullptr ? dst_block.mapped + region->offset : nullptr;
+		lock.unlock();
+
+		auto& counters = heap_counters_[get_heap_index_(src.memory_type)];
+		counters.allocation_count.fetch_add(1, std::memory_order_relaxed);
+		counters.allocation_bytes.fetch_add(src.size, std::memory_order_relaxed);
+
+		return value;
+	}
+
+	usize Allocator::get_block_usage_(const AllocationValue& allocation) noexcept {
+		if (allocation.node == details::TlsfPool::kNil) {
+			return allocation.size;
+		}
+
+		auto& pool = *pools_[allocation.memory_type];
+		std::lock_guard lock{ pool.mutex };
+		return pool.tlsf.get_block(pool.tlsf.get_node_block(allocation.node)).used;
+	}
+}
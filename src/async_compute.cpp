@@ -0,0 +1,185 @@
+#include <async_compute.hpp>
+
+namespace gx {
+	AsyncCompute::AsyncCompute(TimelineScheduler& scheduler, CommandAllocator& allocator, AsyncComputeConfig config) noexcept
+		: scheduler_{ &scheduler }
+		, allocator_{ &allocator }
+		, config_{ config }
+	{
+		assert(config_.graphics_queue < scheduler.get_queue_count() && config_.compute_queue < scheduler.get_queue_count() &&
+			"AsyncCompute: queue index out of range");
+		assert((is_overlapping() || !transfers_ownership_()) && "AsyncCompute: one queue can't belong to two families");
+	}
+
+	auto AsyncCompute::record_handoffs_(
+		u32 family,
+		u32 src_family,
+		u32 dst_family,
+		bool is_release,
+		std::span<const BufferHandoff> buffers,
+		std::span<const ImageHandoff> images
+	) noexcept -> std::expected<VkCommandBuffer, ErrorCode> {
+		bool is_transfer = src_family != dst_family;
+		u32 src_index = is_transfer ? src_family : VK_QUEUE_FAMILY_IGNORED;
+		u32 dst_index = is_transfer ? dst_family : VK_QUEUE_FAMILY_IGNORED;
+
+		// The release half only makes the writes available, the acquire half makes them visible. The acquire waits
+		// for the semaphore wait in front of it, which covers all commands
+		auto get_src = [is_transfer, is_release](const auto& el) noexcept -> std::pair<VkPipelineStageFlags2, VkAccessFlags2> {
+			if (is_transfer && !is_release) {
+				return { VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE };
+			}
+			return { el.src_stages, el.src_access };
+		};
+		auto get_dst = [is_transfer, is_release](const auto& el) noexcept -> std::pair<VkPipelineStageFlags2, VkAccessFlags2> {
+			if (is_transfer && is_release) {
+				return { VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE };
+			}
+			return { el.dst_stages, el.dst_access };
+		};
+
+		buffer_barriers_.clear();
+		for (const auto& el : buffers) {
+			auto [src_stages, src_access] = get_src(el);
+			auto [dst_stages, dst_access] = get_dst(el);
+			buffer_barriers_.push_back(VkBufferMemoryBarrier2{
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+				.srcStageMask = src_stages,
+				.srcAccessMask = src_access,
+				.dstStageMask = dst_stages,
+				.dstAccessMask = dst_access,
+				.srcQueueFamilyIndex = src_index,
+				.dstQueueFamilyIndex = dst_index,
+				.buffer = el.buffer,
+				.offset = el.offset,
+				.size = el.size,
+			});
+		}
+
+		image_barriers_.clear();
+		for (const auto& el : images) {
+			auto [src_stages, src_access] = get_src(el);
+			auto [dst_stages, dst_access] = get_dst(el);
+			// Both halves carry the same layout transition, it runs once
+			image_barriers_.push_back(VkImageMemoryBarrier2{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+				.srcStageMask = src_stages,
+				.srcAccessMask = src_access,
+				.dstStageMask = dst_stages,
+				.dstAccessMask = dst_access,
+				.oldLayout = image_layout_to_vk(el.old_layout),
+				.newLayout = image_layout_to_vk(el.new_layout),
+				.srcQueueFamilyIndex = src_index,
+				.dstQueueFamilyIndex = dst_index,
+				.image = el.image,
+				.subresourceRange = el.range.to_vk(),
+			});
+		}
+
+		auto cmd = allocator_->begin(family);
+		if (!cmd.has_value()) {
+			return cmd;
+		}
+
+		VkDependencyInfo di = {
+			.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+			.bufferMemoryBarrierCount = static_cast<u32>(buffer_barriers_.size()),
+			.pBufferMemoryBarriers = buffer_barriers_.data(),
+			.imageMemoryBarrierCount = static_cast<u32>(image_barriers_.size()),
+			.pImageMemoryBarriers = image_barriers_.data(),
+		};
+		vkCmdPipelineBarrier2(*cmd, &di);
+
+		VkResult res = vkEndCommandBuffer(*cmd);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+
+		return cmd;
+	}
+
+	auto AsyncCompute::enqueue_compute(const AsyncComputeSubmitInfo& info) noexcept -> std::expected<TimelinePoint, ErrorCode> {
+		command_buffers_.clear();
+		waits_.assign(info.waits.begin(), info.waits.end());
+
+		// Everything is recorded first, a failure must not leave a release enqueued without its acquire
+		bool has_acquires = !info.acquire_buffers.empty() || !info.acquire_images.empty();
+		VkCommandBuffer graphics_release = VK_NULL_HANDLE;
+		if (has_acquires) {
+			if (transfers_ownership_()) {
+				auto release = record_handoffs_(config_.graphics_family, config_.graphics_family, config_.compute_family, true, info.acquire_buffers, info.acquire_images);
+				if (!release.has_value()) {
+					return std::unexpected(release.error());
+				}
+				graphics_release = *release;
+			}
+
+			auto acquire = record_handoffs_(config_.compute_family, config_.graphics_family, config_.compute_family, false, info.acquire_buffers, info.acquire_images);
+			if (!acquire.has_value()) {
+				return std::unexpected(acquire.error());
+			}
+			command_buffers_.push_back(*acquire);
+		}
+
+		command_buffers_.insert(command_buffers_.end(), info.command_buffers.begin(), info.command_buffers.end());
+
+		bool has_releases = !info.release_buffers.empty() || !info.release_images.empty();
+		if (has_releases && transfers_ownership_()) {
+			auto release = record_handoffs_(config_.compute_family, config_.compute_family, config_.graphics_family, true, info.release_buffers, info.release_images);
+			if (!release.has_value()) {
+				return std::unexpected(release.error());
+			}
+			command_buffers_.push_back(*release);
+		}
+
+		if (graphics_release != VK_NULL_HANDLE) {
+			waits_.push_back(scheduler_->enqueue(config_.graphics_queue, TimelineSubmitInfo{ .command_buffers = std::span{ &graphics_release, 1 } }));
+		}
+		else if (has_acquires && is_overlapping()) {
+			// Same family on two queues, the semaphore orders the work and the acquire barrier transitions images
+			waits_.push_back(scheduler_->get_last_enqueued(config_.graphics_queue));
+		}
+
+		TimelinePoint point = scheduler_->enqueue(config_.compute_queue, TimelineSubmitInfo{
+			.command_buffers = command_buffers_,
+			.waits = waits_,
+		});
+		++stats_.compute_submission_count;
+
+		// A transfer takes a release and an acquire, it's counted once its acquire is enqueued
+		if (has_acquires && transfers_ownership_()) {
+			stats_.ownership_transfer_count += info.acquire_buffers.size() + info.acquire_images.size();
+		}
+
+		if (has_releases) {
+			graphics_acquire_.buffers.insert(graphics_acquire_.buffers.end(), info.release_buffers.begin(), info.release_buffers.end());
+			graphics_acquire_.images.insert(graphics_acquire_.images.end(), info.release_images.begin(), info.release_images.end());
+			graphics_acquire_.point = point;
+		}
+		return point;
+	}
+
+	auto AsyncCompute::enqueue_graphics(const TimelineSubmitInfo& info, bool acquire_released) noexcept -> std::expected<TimelinePoint, ErrorCode> {
+		if (acquire_released && (!graphics_acquire_.buffers.empty() || !graphics_acquire_.images.empty())) {
+			auto acquire = record_handoffs_(config_.graphics_family, config_.compute_family, config_.graphics_family, false, graphics_acquire_.buffers, graphics_acquire_.images);
+			if (!acquire.has_value()) {
+				return std::unexpected(acquire.error());
+			}
+
+			// A submission of its own, the barrier still orders everything enqueued after it on the queue
+			TimelinePoint wait = graphics_acquire_.point;
+			[[maybe_unused]] auto acquired = scheduler_->enqueue(config_.graphics_queue, TimelineSubmitInfo{
+				.command_buffers = std::span{ &*acquire, 1 },
+				.waits = is_overlapping() ? std::span{ &wait, 1 } : std::span<const TimelinePoint>{},
+			});
+			if (transfers_ownership_()) {
+				stats_.ownership_transfer_count += graphics_acquire_.buffers.size() + graphics_acquire_.images.size();
+			}
+
+			graphics_acquire_.buffers.clear();
+			graphics_acquire_.images.clear();
+		}
+
+		return scheduler_->enqueue(config_.graphics_queue, info);
+	}
+}
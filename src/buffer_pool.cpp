@@ -0,0 +1,125 @@
+#include <buffer_pool.hpp>
+
+#include <algorithm>
+
+namespace gx {
+	BufferPool::BufferPool(Allocator& allocator, BufferPoolConfig config) noexcept
+		: allocator_{ &allocator }
+		, config_{ config }
+	{
+		const auto& limits = PhysDeviceInfo::get(allocator.get_phys_device()).limits;
+		if (test_bit(config_.usage, BufferUsage::eUniform)) {
+			alignment_ = std::max(alignment_, limits.min_uniform_buffer_offset_alignment);
+		}
+		if (test_bit(config_.usage, BufferUsage::eStorage)) {
+			alignment_ = std::max(alignment_, limits.min_storage_buffer_offset_alignment);
+		}
+	}
+
+	auto BufferPool::allocate(usize size, usize alignment) noexcept -> std::expected<BufferRange, ErrorCode> {
+		assert(size != 0 && "BufferPool::allocate(): size must not be 0");
+		alignment = std::max(alignment, alignment_);
+
+		std::lock_guard lock{ mutex_ };
+		if (size > config_.buffer_size / 2) {
+			return allocate_dedicated_(size);
+		}
+
+		auto region = tlsf_.allocate(size, alignment);
+		if (!region.has_value()) {
+			auto buffer = create_buffer_(config_.buffer_size);
+			if (!buffer.has_value()) {
+				return std::unexpected(buffer.error());
+			}
+
+			u32 block = tlsf_.add_block(VK_NULL_HANDLE, config_.buffer_size, static_cast<u8*>(buffer->allocation.get_view().get_mapped_ptr()));
+			if (block >= buffers_.size()) {
+				buffers_.resize(block + 1);
+			}
+			buffers_[block] = std::move(*buffer);
+
+			region = tlsf_.allocate(size, alignment);
+			assert(region.has_value() && "BufferPool::allocate(): fresh buffer must fit the range");
+		}
+
+		const auto& block = tlsf_.get_block(region->block);
+		used_bytes_.fetch_add(size, std::memory_order_relaxed);
+
+		BufferRangeValue value{};
+		value.handle = buffers_[region->block].handle;
+		value.parent = this;
+		value.offset = region->offset;
+		value.size = size;
+		value.node = region->node;
+		value.mapped = block.mapped != nullptr ? block.mapped + region->offset : nullptr;
+
+		return BufferRange{ value };
+	}
+
+	auto BufferPool::allocate_dedicated_(usize size) noexcept -> std::expected<BufferRange, ErrorCode> {
+		auto buffer = create_buffer_(size);
+		if (!buffer.has_value()) {
+			return std::unexpected(buffer.error());
+		}
+		used_bytes_.fetch_add(size, std::memory_order_relaxed);
+
+		BufferRangeValue value{};
+		value.handle = buffer->handle;
+		value.parent = this;
+		value.size = size;
+		value.mapped = static_cast<u8*>(buffer->allocation.get_view().get_mapped_ptr());
+
+		dedicated_.push_back(std::move(*buffer));
+		return BufferRange{ value };
+	}
+
+	auto BufferPool::create_buffer_(usize size) noexcept -> std::expected<PoolBuffer, ErrorCode> {
+		auto buffer = BufferBuilder{ allocator_->get_device() }
+			.with_size(size)
+			.with_usage(config_.usage)
+			.build();
+
+		if (!buffer.has_value()) {
+			return std::unexpected(buffer.error());
+		}
+
+		auto allocation = allocator_->allocate_for_buffer(buffer->get_handle(), config_.memory_usage);
+		if (!allocation.has_value()) {
+			std::move(*buffer).destroy();
+			return std::unexpected(allocation.error());
+		}
+
+		VkBuffer handle = buffer->get_handle();
+		capacity_.fetch_add(size, std::memory_order_relaxed);
+
+		return PoolBuffer{
+			.allocation = std::move(*allocation).to_owned<MoveOnlyTag, ViewableTag>(),
+			.buffer = std::move(*buffer).to_owned<MoveOnlyTag, ViewableTag>(),
+			.handle = handle,
+		};
+	}
+
+	void BufferPool::free_(const BufferRangeValue& range) noexcept {
+		std::lock_guard lock{ mutex_ };
+		used_bytes_.fetch_sub(range.size, std::memory_order_relaxed);
+
+		if (range.node == details::TlsfPool::kNil) {
+			auto it = std::ranges::find(dedicated_, range.handle, &PoolBuffer::handle);
+			assert(it != dedicated_.end() && "BufferPool::free_(): range doesn't belong to the pool");
+
+			capacity_.fetch_sub(range.size, std::memory_order_relaxed);
+			dedicated_.erase(it);
+			return;
+		}
+
+		auto empty_block = tlsf_.free(range.node);
+		// Keep the last buffer alive so an alloc/free pair at the edge doesn't recreate it every time
+		if (empty_block.has_value() && tlsf_.get_block_count() > 1) {
+			u32 block = tlsf_.get_node_block(*empty_block);
+			auto removed = tlsf_.remove_block(*empty_block);
+			capacity_.fetch_sub(removed.size, std::memory_order_relaxed);
+
+			[[maybe_unused]] auto released = std::move(buffers_[block]);
+		}
+	}
+}
@@ -0,0 +1,160 @@
+#include <cmd_exec.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace gx {
+	namespace {
+		struct CommandThreadCache {
+			u64 owner = 0;
+			void* pools = nullptr;
+		};
+
+		thread_local CommandThreadCache t_command_cache;
+		std::atomic<u64> g_next_command_allocator_id = 1;
+	}
+
+	CommandAllocator::CommandAllocator(VkDevice device, CommandAllocatorConfig config) noexcept
+		: device_{ device }
+		, id_{ g_next_command_allocator_id.fetch_add(1, std::memory_order_relaxed) }
+		, config_{ std::move(config) }
+	{
+		assert(config_.frames_in_flight != 0 && "CommandAllocator: frames_in_flight must be greater than 0");
+		assert(!config_.queue_families.empty() && "CommandAllocator: at least one queue family is required");
+		assert(config_.batch_size != 0 && "CommandAllocator: batch_size must be greater than 0");
+	}
+
+	CommandAllocator::~CommandAllocator() noexcept {
+		// Destroying a pool frees its command buffers
+		for (const auto& thread : threads_) {
+			for (const auto& pool : thread->pools) {
+				if (pool.handle != VK_NULL_HANDLE) {
+					vkDestroyCommandPool(device_, pool.handle, get_allocation_callbacks(device_));
+				}
+			}
+		}
+	}
+
+	u32 CommandAllocator::get_family_slot_(u32 queue_family) const noexcept {
+		auto it = std::ranges::find(config_.queue_families, queue_family);
+		assert(it != config_.queue_families.end() && "CommandAllocator: queue family is not in CommandAllocatorConfig::queue_families");
+		return static_cast<u32>(it - config_.queue_families.begin());
+	}
+
+	auto CommandAllocator::get_thread_pools_() noexcept -> ThreadPools& {
+		if (t_command_cache.owner == id_) {
+			return *static_cast<ThreadPools*>(t_command_cache.pools);
+		}
+
+		// Only the first allocation of a thread, or one after it used another allocator, takes the lock
+		std::lock_guard lock{ threads_mutex_ };
+
+		auto this_thread = std::this_thread::get_id();
+		auto it = std::ranges::find(threads_, this_thread, [](const auto& el) noexcept { return el->thread; });
+		if (it == threads_.end()) {
+			auto thread = std::make_unique<ThreadPools>();
+			thread->thread = this_thread;
+			thread->pools.resize(config_.frames_in_flight * config_.queue_families.size());
+			threads_.push_back(std::move(thread));
+			it = threads_.end() - 1;
+		}
+
+		t_command_cache = CommandThreadCache{ .owner = id_, .pools = it->get() };
+		return **it;
+	}
+
+	auto CommandAllocator::allocate(u32 queue_family, CommandBufferLevel level) noexcept -> std::expected<VkCommandBuffer, ErrorCode> {
+		u32 family_slot = get_family_slot_(queue_family);
+		u64 frame = frame_.load(std::memory_order_acquire);
+		auto& thread = get_thread_pools_();
+		auto& pool = thread.pools[(frame % config_.frames_in_flight) * config_.queue_families.size() + family_slot];
+
+		if (pool.handle == VK_NULL_HANDLE) {
+			VkCommandPoolCreateInfo ci = {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+				.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+				.queueFamilyIndex = queue_family,
+			};
+			VkResult res = vkCreateCommandPool(device_, &ci, get_allocation_callbacks(device_), &pool.handle);
+			if (res != VK_SUCCESS) {
+				return std::unexpected(convert_vk_result(res));
+			}
+			pool.frame = frame;
+			pool_count_.fetch_add(1, std::memory_order_relaxed);
+		}
+		else if (pool.frame != frame) {
+			// Keeps the memory of the command buffers, they are recorded to again this frame
+			VkResult res = vkResetCommandPool(device_, pool.handle, 0);
+			if (res != VK_SUCCESS) {
+				return std::unexpected(convert_vk_result(res));
+			}
+			pool.frame = frame;
+			pool.used_counts = {};
+			reset_count_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		auto level_index = std::to_underlying(level);
+		auto& command_buffers = pool.command_buffers[level_index];
+		auto& used_count = pool.used_counts[level_index];
+
+		if (used_count == command_buffers.size()) {
+			command_buffers.resize(command_buffers.size() + config_.batch_size);
+
+			VkCommandBufferAllocateInfo ai = {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				.commandPool = pool.handle,
+				.level = command_buffer_level_to_vk(level),
+				.commandBufferCount = config_.batch_size,
+			};
+			VkResult res = vkAllocateCommandBuffers(device_, &ai, command_buffers.data() + used_count);
+			if (res != VK_SUCCESS) {
+				command_buffers.resize(used_count);
+				return std::unexpected(convert_vk_result(res));
+			}
+			command_buffer_count_.fetch_add(config_.batch_size, std::memory_order_relaxed);
+		}
+
+		return command_buffers[used_count++];
+	}
+
+	auto CommandAllocator::begin(
+		u32 queue_family,
+		CommandBufferLevel level,
+		const VkCommandBufferInheritanceInfo* inheritance,
+		VkCommandBufferUsageFlags flags
+	) noexcept -> std::expected<VkCommandBuffer, ErrorCode> {
+		// VUID-vkBeginCommandBuffer-commandBuffer-00051
+		assert((level == CommandBufferLevel::ePrimary || inheritance != nullptr) && "Secondary command buffers require inheritance info");
+
+		auto cmd = allocate(queue_family, level);
+		if (!cmd.has_value()) {
+			return cmd;
+		}
+
+		VkCommandBufferBeginInfo bi = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | flags,
+			.pInheritanceInfo = inheritance,
+		};
+		VkResult res = vkBeginCommandBuffer(*cmd, &bi);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+		return cmd;
+	}
+
+	CommandAllocatorStats CommandAllocator::get_stats() noexcept {
+		usize thread_count = 0;
+		{
+			std::lock_guard lock{ threads_mutex_ };
+			thread_count = threads_.size();
+		}
+
+		return CommandAllocatorStats{
+			.thread_count = thread_count,
+			.pool_count = pool_count_.load(std::memory_order_relaxed),
+			.command_buffer_count = command_buffer_count_.load(std::memory_order_relaxed),
+			.reset_count = reset_count_.load(std::memory_order_relaxed),
+		};
+	}
+}
@@ -0,0 +1,117 @@
+#include <defragmenter.hpp>
+
+#include <algorithm>
+
+namespace gx {
+	u32 Defragmenter::record_pass(VkCommandBuffer cmd, std::span<const DefragCandidate> candidates) noexcept {
+		assert(pending_.empty() && "Defragmenter::record_pass(): previous pass must be finished with end_pass() or cancel_pass()");
+
+		auto start = std::chrono::steady_clock::now();
+		VkDevice device = allocator_->get_device();
+
+		// Emptiest blocks go first, they are the cheapest to release
+		std::vector<std::pair<usize, usize>> order;
+		order.reserve(candidates.size());
+		for (auto&& [i, candidate] : std::views::zip(std::views::iota(usize{ 0 }), candidates)) {
+			if (!candidate.allocation.is_dedicated()) {
+				order.emplace_back(allocator_->get_block_usage_(candidate.allocation.get_value()), i);
+			}
+		}
+		std::ranges::sort(order);
+
+		usize bytes = 0;
+		for (usize i : order | std::views::values) {
+			if (pending_.size() >= config_.max_moves_per_pass ||
+				bytes >= config_.max_bytes_per_pass ||
+				std::chrono::steady_clock::now() - start >= config_.max_pass_time)
+			{
+				break;
+			}
+
+			const auto& candidate = candidates[i];
+			const auto& src = candidate.allocation.get_value();
+
+			auto buffer = BufferBuilder{ device }
+				.with_size(candidate.size)
+				.with_usage(candidate.usage | BufferUsage::eTransferDst)
+				.build();
+
+			if (!buffer.has_value()) {
+				continue;
+			}
+
+			VkMemoryRequirements reqs{};
+			vkGetBufferMemoryRequirements(device, buffer->get_handle(), &reqs);
+
+			// The destination takes src's size and memory type, the new buffer has to fit both
+			if (reqs.size > src.size || (reqs.memoryTypeBits & (1u << src.memory_type)) == 0) {
+				std::move(*buffer).destroy();
+				continue;
+			}
+
+			auto dst = allocator_->allocate_for_move_(src, reqs.alignment);
+			if (!dst.has_value()) {
+				std::move(*buffer).destroy();
+				continue;
+			}
+
+			if (vkBindBufferMemory(device, buffer->get_handle(), dst->handle, dst->offset) != VK_SUCCESS) {
+				allocator_->free_(*dst);
+				std::move(*buffer).destroy();
+				continue;
+			}
+
+			if (pending_.empty()) {
+				VkMemoryBarrier barrier = {
+					.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+					.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+					.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+				};
+				vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+			}
+
+			VkBufferCopy region = {
+				.srcOffset = 0,
+				.dstOffset = 0,
+				.size = candidate.size,
+			};
+			vkCmdCopyBuffer(cmd, candidate.buffer.get_handle(), buffer->get_handle(), 1, &region);
+
+			pending_.push_back(DefragMove{
+				.user_data = candidate.user_data,
+				.src = src,
+				.dst = *dst,
+				.dst_buffer = BufferValue{ std::move(*buffer).to_owned<MoveOnlyTag>().unwrap_native_handle(), device },
+			});
+			bytes += candidate.size;
+		}
+
+		if (!pending_.empty()) {
+			VkMemoryBarrier barrier = {
+				.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+			};
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+
+		++stats_.passes;
+		return static_cast<u32>(pending_.size());
+	}
+
+	std::vector<DefragMove> Defragmenter::end_pass() noexcept {
+		for (const auto& move : pending_) {
+			++stats_.moves;
+			stats_.bytes_moved += move.src.size;
+		}
+		return std::exchange(pending_, {});
+	}
+
+	void Defragmenter::cancel_pass() noexcept {
+		for (auto& move : pending_) {
+			move.dst_buffer.destroy();
+			allocator_->free_(move.dst);
+		}
+		pending_.clear();
+	}
+}
@@ -1,6 +1,32 @@
 #include <device.hpp>
 
+#include <bit>
+#include <mutex>
+#include <shared_mutex>
+
 namespace gx {
+	namespace {
+		std::shared_mutex g_memory_budget_mutex;
+		std::vector<VkDevice> g_memory_budget_devices;
+	}
+
+	bool is_memory_budget_enabled(VkDevice device) noexcept {
+		std::shared_lock lock{ g_memory_budget_mutex };
+		return std::ranges::find(g_memory_budget_devices, device) != g_memory_budget_devices.end();
+	}
+
+	namespace details {
+		void register_memory_budget(VkDevice device) noexcept {
+			std::lock_guard lock{ g_memory_budget_mutex };
+			g_memory_budget_devices.push_back(device);
+		}
+
+		void unregister_memory_budget(VkDevice device) noexcept {
+			std::lock_guard lock{ g_memory_budget_mutex };
+			std::erase(g_memory_budget_devices, device);
+		}
+	}
+
 	std::vector<std::pair<VkPhysicalDevice, PhysDeviceInfo>> PhysDeviceInfo::phys_device_infos_{};
 
 	std::optional<u32> PhysDeviceInfo::get_queue_index(QueueType type) const noexcept {
@@ -14,6 +40,58 @@ namespace gx {
 		}
 	}
 
+	std::optional<QueueType> PhysDeviceInfo::get_sparse_binding_queue_type() const noexcept {
+		std::optional<QueueType> ret;
+		for (const auto& el : queue_infos | std::views::filter(&QueueInfo::supports_sparse_binding)) {
+			if (el.is_dedicated && el.type != QueueType::eGraphics) {
+				return el.type;
+			}
+			if (!ret.has_value()) {
+				ret = el.type;
+			}
+		}
+		return ret;
+	}
+
+	bool PhysDeviceInfo::supports_extension(std::string_view name) const noexcept {
+		return std::ranges::any_of(supported_extensions,
+			[name](const VkExtensionProperties& props) noexcept {
+				return name == props.extensionName;
+			}
+		);
+	}
+
+	MemoryTypeList PhysDeviceInfo::resolve_memory_usage_(const PhysDeviceInfo& info, MemoryUsage usage) noexcept {
+		const auto& traits = get_memory_usage_traits(usage);
+
+		std::vector<std::pair<i32, u8>> candidates;
+		for (auto&& [i, mem_info] : std::views::zip(std::views::iota(0u), info.memory_infos)) {
+			if ((mem_info.memory_properties & traits.required) != traits.required) {
+				continue;
+			}
+
+			i32 score = std::popcount(static_cast<u32>(mem_info.memory_properties & traits.preferred)) -
+				std::popcount(static_cast<u32>(mem_info.memory_properties & traits.avoided));
+			candidates.emplace_back(score, static_cast<u8>(i));
+		}
+		// Drivers already order memory types by performance, so equal scores keep their index order
+		std::ranges::stable_sort(candidates, std::greater{}, &std::pair<i32, u8>::first);
+
+		MemoryTypeList ret;
+		for (u8 type : candidates | std::views::values) {
+			ret.types[ret.count++] = type;
+		}
+
+		if (traits.fallback != MemoryUsage::eCount) {
+			for (u8 type : info.get_memory_types(traits.fallback).get()) {
+				if (std::ranges::find(ret.get(), type) == ret.get().end()) {
+					ret.types[ret.count++] = type;
+				}
+			}
+		}
+		return ret;
+	}
+
 	PhysDeviceInfo PhysDeviceInfo::fill_info_(VkPhysicalDevice phys_device) noexcept {
 		VkPhysicalDeviceProperties props{};
 		VkPhysicalDeviceMemoryProperties mem_props{};
@@ -35,8 +113,108 @@ namespace gx {
 			if (test_bit(mem_type.propertyFlags, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
 				info.memory_infos[i].memory_properties |= static_cast<u8>(MemoryProperties::eHostCoherent);
 			}
+			if (test_bit(mem_type.propertyFlags, VK_MEMORY_PROPERTY_HOST_CACHED_BIT)) {
+				info.memory_infos[i].memory_properties |= static_cast<u8>(MemoryProperties::eHostCached);
+			}
+			if (test_bit(mem_type.propertyFlags, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+				info.memory_infos[i].memory_properties |= static_cast<u8>(MemoryProperties::eLazilyAllocated);
+			}
 
 			info.memory_infos[i].budget = mem_props.memoryHeaps[mem_type.heapIndex].size;
+			info.memory_infos[i].heap_index = mem_type.heapIndex;
+		}
+		info.memory_heap_sizes.resize(mem_props.memoryHeapCount);
+		for (usize i : std::ranges::views::iota(0u, mem_props.memoryHeapCount)) {
+			info.memory_heap_sizes[i] = mem_props.memoryHeaps[i].size;
+		}
+
+		for (usize i : std::views::iota(usize{ 0 }, kMemoryUsageCount)) {
+			info.memory_type_lists[i] = resolve_memory_usage_(info, static_cast<MemoryUsage>(i));
+		}
+
+		info.limits.buffer_image_granularity = props.limits.bufferImageGranularity;
+		info.limits.non_coherent_atom_size = props.limits.nonCoherentAtomSize;
+		info.limits.min_uniform_buffer_offset_alignment = props.limits.minUniformBufferOffsetAlignment;
+		info.limits.min_storage_buffer_offset_alignment = props.limits.minStorageBufferOffsetAlignment;
+		info.limits.max_memory_allocation_count = props.limits.maxMemoryAllocationCount;
+
+		u32 ext_count = 0;
+		vkEnumerateDeviceExtensionProperties(phys_device, nullptr, &ext_count, nullptr);
+		info.supported_extensions.resize(ext_count);
+		vkEnumerateDeviceExtensionProperties(phys_device, nullptr, &ext_count, info.supported_extensions.data());
+
+		VkPhysicalDeviceIDProperties id_props = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+		};
+		VkPhysicalDeviceProperties2 id_props2 = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+			.pNext = &id_props,
+		};
+		vkGetPhysicalDeviceProperties2(phys_device, &id_props2);
+		std::ranges::copy(id_props.deviceUUID, info.device_uuid.begin());
+		std::ranges::copy(id_props.driverUUID, info.driver_uuid.begin());
+
+		VkPhysicalDeviceVulkan12Features features12 = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+		};
+		VkPhysicalDeviceVulkan13Features features13 = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+			.pNext = &features12,
+		};
+		VkPhysicalDeviceSynchronization2Features sync2_features = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
+			.pNext = &features12,
+		};
+
+		// The 1.3 structure is only known to 1.3 devices, older ones may still have VK_KHR_synchronization2
+		info.api_version = props.apiVersion;
+		bool is_vulkan13 = props.apiVersion >= VK_API_VERSION_1_3;
+		bool has_sync2_ext = !is_vulkan13 && info.supports_extension(ext::DeviceExtensionList::kKhrSynchronization2);
+		void* features_chain = &features12;
+		if (is_vulkan13) {
+			features_chain = &features13;
+		}
+		else if (has_sync2_ext) {
+			features_chain = &sync2_features;
+		}
+
+		VkPhysicalDeviceFeatures2 features2 = {
+			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+			.pNext = features_chain,
+		};
+		vkGetPhysicalDeviceFeatures2(phys_device, &features2);
+		if (features12.bufferDeviceAddress == VK_TRUE) {
+			info.supported_features |= DeviceFeature::eBufferDeviceAddress;
+		}
+		if (features12.timelineSemaphore == VK_TRUE) {
+			info.supported_features |= DeviceFeature::eTimelineSemaphore;
+		}
+		if (features13.synchronization2 == VK_TRUE || sync2_features.synchronization2 == VK_TRUE) {
+			info.supported_features |= DeviceFeature::eSynchronization2;
+		}
+		if (features2.features.sparseBinding == VK_TRUE) {
+			info.supported_features |= DeviceFeature::eSparseBinding;
+		}
+		if (features2.features.sparseResidencyBuffer == VK_TRUE) {
+			info.supported_features |= DeviceFeature::eSparseResidencyBuffer;
+		}
+		if (features2.features.sparseResidencyImage2D == VK_TRUE) {
+			info.supported_features |= DeviceFeature::eSparseResidencyImage2D;
+		}
+		if (features2.features.sparseResidencyImage3D == VK_TRUE) {
+			info.supported_features |= DeviceFeature::eSparseResidencyImage3D;
+		}
+
+		if (info.supports_extension<ext::ExternalMemoryHostExt>()) {
+			VkPhysicalDeviceExternalMemoryHostPropertiesEXT host_props = {
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT,
+			};
+			VkPhysicalDeviceProperties2 props2 = {
+				.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+				.pNext = &host_props,
+			};
+			vkGetPhysicalDeviceProperties2(phys_device, &props2);
+			info.limits.min_imported_host_pointer_alignment = host_props.minImportedHostPointerAlignment;
 		}
 
 		info.device_name = props.deviceName;
@@ -56,36 +234,46 @@ namespace gx {
 		std::vector<VkQueueFamilyProperties> q_props(q_prop_count);
 		vkGetPhysicalDeviceQueueFamilyProperties(phys_device, &q_prop_count, q_props.data());
 
+		auto find_family = [&q_props](VkQueueFlags required, VkQueueFlags excluded) noexcept -> std::optional<u32> {
+			for (auto [i, el] : std::views::zip(std::views::iota(0u), q_props)) {
+				if (el.queueCount != 0 && (el.queueFlags & required) == required && (el.queueFlags & excluded) == 0) {
+					return i;
+				}
+			}
+			return std::nullopt;
+		};
+
+		// Graphics and compute families support transfers too, so every type falls back to the graphics family.
+		// Transfers prefer a transfer-only family, then the async compute one
+		auto graphics_family = find_family(VK_QUEUE_GRAPHICS_BIT, 0);
+		auto compute_family = find_family(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+		auto transfer_family = find_family(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)
+			.or_else([&compute_family] { return compute_family; });
+
+		std::array<std::optional<u32>, kQueueTypeCount> families{};
+		families[std::to_underlying(QueueType::eGraphics)] = graphics_family;
+		families[std::to_underlying(QueueType::eCompute)] = compute_family.or_else([&graphics_family] { return graphics_family; });
+		families[std::to_underlying(QueueType::eTransfer)] = transfer_family.or_else([&graphics_family] { return graphics_family; });
+
 		info.queue_infos.clear();
 
-		for (auto [i, el] : std::views::zip(std::views::iota(0u), q_props)) {
-			if (test_bit(el.queueFlags, VK_QUEUE_GRAPHICS_BIT)) {
-				info.queue_infos.push_back(
-					QueueInfo {
-						.type = QueueType::eGraphics,
-						.index = i,
-						.count = el.queueCount
-					}
-				);
-			}
-			else if (test_bit(el.queueFlags, VK_QUEUE_COMPUTE_BIT) && test_bit(el.queueFlags, VK_QUEUE_TRANSFER_BIT)) {
-				info.queue_infos.push_back(
-					QueueInfo {
-						.type = QueueType::eCompute,
-						.index = i,
-						.count = el.queueCount
-					}
-				);
-			}
-			else if (test_bit(el.queueFlags, VK_QUEUE_TRANSFER_BIT)) {
-				info.queue_infos.push_back(
-					QueueInfo {
-						.type = QueueType::eTransfer,
-						.index = i,
-						.count = el.queueCount
-					}
-				);
+		static constexpr auto kQTypes = std::array{ QueueType::eGraphics, QueueType::eCompute, QueueType::eTransfer };
+		for (auto type : kQTypes) {
+			auto family = families[std::to_underlying(type)];
+			if (!family.has_value()) {
+				continue;
 			}
+
+			const auto& el = q_props[*family];
+			info.queue_infos.push_back(
+				QueueInfo {
+					.type = type,
+					.index = *family,
+					.count = el.queueCount,
+					.supports_sparse_binding = test_bit(el.queueFlags, VK_QUEUE_SPARSE_BINDING_BIT),
+					.is_dedicated = std::ranges::count(families, family) == 1
+				}
+			);
 		}
 
 		if (props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
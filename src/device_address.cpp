@@ -0,0 +1,90 @@
+#include <device_address.hpp>
+
+#include <bit>
+
+namespace gx {
+	auto DeviceAddressArena::add_chunk_(usize size) noexcept -> std::expected<void, ErrorCode> {
+		auto buffer = BufferBuilder{ allocator_->get_device() }
+			.with_size(size)
+			.with_usage(config_.usage)
+			.build();
+
+		if (!buffer.has_value()) {
+			return std::unexpected(buffer.error());
+		}
+
+		auto allocation = allocator_->allocate_for_buffer(buffer->get_handle(), config_.memory_usage);
+		if (!allocation.has_value()) {
+			std::move(*buffer).destroy();
+			return std::unexpected(allocation.error());
+		}
+
+		auto& chunk = chunks_.emplace_back();
+		chunk.handle = buffer->get_handle();
+		chunk.address = buffer->get_device_address();
+		chunk.mapped = static_cast<u8*>(allocation->get_mapped_ptr());
+		chunk.size = size;
+		chunk.buffer = std::move(*buffer).to_owned<MoveOnlyTag, ViewableTag>();
+		chunk.allocation = std::move(*allocation).to_owned<MoveOnlyTag, ViewableTag>();
+		return {};
+	}
+
+	auto DeviceAddressArena::allocate(usize size, usize alignment) noexcept -> std::expected<DeviceAddressRange, ErrorCode> {
+		assert(std::has_single_bit(alignment) && "DeviceAddressArena::allocate(): alignment must be a power of two");
+
+		for (;;) {
+			bool fresh = current_ == chunks_.size();
+			if (fresh) {
+				// The chunk address may be less aligned than requested, leave room to align the range inside it
+				auto res = add_chunk_(std::max(config_.chunk_size, align_up(size + alignment - 1, kb_to_bytes(64))));
+				if (!res.has_value()) {
+					return std::unexpected(res.error());
+				}
+			}
+
+			const auto& chunk = chunks_[current_];
+			// Chunk addresses are only aligned to the buffer's memory requirements, so align the address itself
+			usize offset = static_cast<usize>(align_up(chunk.address + head_, alignment) - chunk.address);
+			if (offset + size <= chunk.size) {
+				head_ = offset + size;
+				return DeviceAddressRange{
+					.buffer = chunk.handle,
+					.offset = offset,
+					.size = size,
+					.address = chunk.address + offset,
+					.mapped = chunk.mapped != nullptr ? chunk.mapped + offset : nullptr,
+				};
+			}
+
+			if (fresh) {
+				return std::unexpected(ErrorCode::eOutOfDeviceMemory);
+			}
+
+			++current_;
+			head_ = 0;
+		}
+	}
+
+	auto DeviceAddressArena::flush() noexcept -> std::expected<void, ErrorCode> {
+		for (usize i = 0; i < chunks_.size() && i <= current_; ++i) {
+			usize used = i == current_ ? head_ : chunks_[i].size;
+			if (used == 0) {
+				continue;
+			}
+
+			auto res = allocator_->flush(chunks_[i].allocation.get_view(), 0, used);
+			if (!res.has_value()) {
+				return res;
+			}
+		}
+		return {};
+	}
+
+	usize DeviceAddressArena::get_capacity() const noexcept {
+		usize ret = 0;
+		for (const auto& chunk : chunks_) {
+			ret += chunk.size;
+		}
+		return ret;
+	}
+}
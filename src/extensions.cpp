@@ -177,7 +177,7 @@ namespace gx::ext {
 		};
 
 		VkSurfaceKHR surface = VK_NULL_HANDLE;
-		VkResult res = vkCreateWin32SurfaceKHR(self.instance_, &create_info, nullptr, &surface);
+		VkResult res = vkCreateWin32SurfaceKHR(self.instance_, &create_info, get_allocation_callbacks(self.instance_), &surface);
 
 		if (res == VK_SUCCESS) {
 			return Surface{ SurfaceValue{ self.instance_, surface } };
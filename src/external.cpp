@@ -0,0 +1,76 @@
+#include <external.hpp>
+
+#include <extensions.hpp>
+
+namespace gx {
+	FdInterop::FdInterop(VkDevice device) noexcept
+		: device_{ device }
+	{
+		get_memory_fd_ = ext::FuncLoader::load<PFN_vkGetMemoryFdKHR>(device, "vkGetMemoryFdKHR").value_or(nullptr);
+		get_semaphore_fd_ = ext::FuncLoader::load<PFN_vkGetSemaphoreFdKHR>(device, "vkGetSemaphoreFdKHR").value_or(nullptr);
+		import_semaphore_fd_ = ext::FuncLoader::load<PFN_vkImportSemaphoreFdKHR>(device, "vkImportSemaphoreFdKHR").value_or(nullptr);
+	}
+
+	auto FdInterop::export_memory(AllocationView allocation) const noexcept -> std::expected<ExternalMemoryDesc, ErrorCode> {
+		assert(get_memory_fd_ != nullptr && "FdInterop::export_memory(): VK_KHR_external_memory_fd is not enabled");
+		// Only dedicated allocations carry the export info, a sub-allocation would share the whole block
+		assert(allocation.is_dedicated() && "FdInterop::export_memory(): allocation must be dedicated");
+
+		VkMemoryGetFdInfoKHR info = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+			.memory = allocation.get_handle(),
+			.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,
+		};
+
+		int fd = -1;
+		VkResult res = get_memory_fd_(device_, &info, &fd);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+
+		return ExternalMemoryDesc{
+			.fd = fd,
+			.size = allocation.get_size(),
+			.memory_type = allocation.get_memory_type(),
+		};
+	}
+
+	auto FdInterop::export_semaphore(SemaphoreView semaphore, ExternalSemaphoreHandleType type) const noexcept -> std::expected<int, ErrorCode> {
+		assert(get_semaphore_fd_ != nullptr && "FdInterop::export_semaphore(): VK_KHR_external_semaphore_fd is not enabled");
+		// VUID-VkSemaphoreGetFdInfoKHR-handleType-01136
+		assert(type != ExternalSemaphoreHandleType::eOpaqueWin32 && "type must be a POSIX fd handle type");
+
+		VkSemaphoreGetFdInfoKHR info = {
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR,
+			.semaphore = semaphore.get_handle(),
+			.handleType = static_cast<VkExternalSemaphoreHandleTypeFlagBits>(external_semaphore_handle_types_to_vk(std::to_underlying(type))),
+		};
+
+		int fd = -1;
+		VkResult res = get_semaphore_fd_(device_, &info, &fd);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+		return fd;
+	}
+
+	auto FdInterop::import_semaphore(SemaphoreView semaphore, int fd, ExternalSemaphoreHandleType type, bool temporary) const noexcept -> std::expected<void, ErrorCode> {
+		assert(import_semaphore_fd_ != nullptr && "FdInterop::import_semaphore(): VK_KHR_external_semaphore_fd is not enabled");
+		// VUID-VkImportSemaphoreFdInfoKHR-handleType-07307
+		assert((temporary || type != ExternalSemaphoreHandleType::eSyncFd) && "Sync fds can only be imported temporarily");
+
+		VkImportSemaphoreFdInfoKHR info = {
+			.sType = VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_FD_INFO_KHR,
+			.semaphore = semaphore.get_handle(),
+			.flags = temporary ? static_cast<VkSemaphoreImportFlags>(VK_SEMAPHORE_IMPORT_TEMPORARY_BIT) : 0u,
+			.handleType = static_cast<VkExternalSemaphoreHandleTypeFlagBits>(external_semaphore_handle_types_to_vk(std::to_underlying(type))),
+			.fd = fd,
+		};
+
+		VkResult res = import_semaphore_fd_(device_, &info);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+		return {};
+	}
+}
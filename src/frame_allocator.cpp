@@ -0,0 +1,41 @@
+#include <frame_allocator.hpp>
+
+#include <algorithm>
+
+namespace gx {
+	auto FrameAllocator::create(Allocator& allocator, FrameAllocatorConfig config) noexcept -> std::expected<FrameAllocator, ErrorCode> {
+		assert(config.frames_in_flight != 0 && "FrameAllocator::create(): frames_in_flight must not be 0");
+
+		const auto& limits = PhysDeviceInfo::get(allocator.get_phys_device()).limits;
+		usize min_alignment = std::max(limits.min_uniform_buffer_offset_alignment, limits.min_storage_buffer_offset_alignment);
+		usize frame_size = align_up(config.frame_size, min_alignment);
+
+		auto buffer = BufferBuilder{ allocator.get_device() }
+			.with_size(frame_size * config.frames_in_flight)
+			.with_usage(config.usage)
+			.build();
+
+		if (!buffer.has_value()) {
+			return std::unexpected(buffer.error());
+		}
+
+		auto allocation = allocator.allocate_for_buffer(buffer->get_handle(), MemoryUsage::eCpuToGpu);
+
+		if (!allocation.has_value()) {
+			std::move(*buffer).destroy();
+			return std::unexpected(allocation.error());
+		}
+
+		FrameAllocator ret{};
+		ret.buffer_handle_ = buffer->get_handle();
+		ret.base_ = static_cast<u8*>(allocation->get_mapped_ptr());
+		ret.frame_size_ = frame_size;
+		ret.frames_in_flight_ = config.frames_in_flight;
+		ret.min_alignment_ = min_alignment;
+		ret.buffer_ = std::move(*buffer).to_owned<MoveOnlyTag, ViewableTag>();
+		ret.allocation_ = std::move(*allocation).to_owned<MoveOnlyTag, ViewableTag>();
+		ret.begin_frame(0);
+
+		return ret;
+	}
+}
@@ -0,0 +1,467 @@
+#include <host_allocator.hpp>
+
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <ranges>
+#include <shared_mutex>
+
+namespace gx {
+	namespace {
+		template<typename H>
+		struct CallbacksRegistry {
+			std::shared_mutex mutex;
+			std::vector<std::pair<H, const VkAllocationCallbacks*>> entries;
+			// Lets lookups skip the lock while nothing is installed, which is the common case
+			std::atomic<usize> count = 0;
+
+			const VkAllocationCallbacks* get(H handle) noexcept {
+				if (count.load(std::memory_order_acquire) == 0) {
+					return nullptr;
+				}
+
+				std::shared_lock lock{ mutex };
+				auto it = std::ranges::find(entries, handle, &std::pair<H, const VkAllocationCallbacks*>::first);
+				return it != entries.end() ? it->second : nullptr;
+			}
+
+			void add(H handle, const VkAllocationCallbacks* callbacks) noexcept {
+				if (callbacks == nullptr) {
+					return;
+				}
+
+				std::lock_guard lock{ mutex };
+				entries.emplace_back(handle, callbacks);
+				count.store(entries.size(), std::memory_order_release);
+			}
+
+			void remove(H handle) noexcept {
+				if (count.load(std::memory_order_acquire) == 0) {
+					return;
+				}
+
+				std::lock_guard lock{ mutex };
+				std::erase_if(entries, [handle](const auto& entry) { return entry.first == handle; });
+				count.store(entries.size(), std::memory_order_release);
+			}
+		};
+
+		CallbacksRegistry<VkInstance> g_instance_callbacks;
+		CallbacksRegistry<VkDevice> g_device_callbacks;
+
+		/*
+		* pfnReallocation in terms of pfnAllocation and pfnFree, following the rules of VkAllocationCallbacks:
+		* a null original allocates, a zero size frees, a failure leaves the original untouched.
+		*/
+		void* host_reallocate(void* user_data, void* original, usize size, usize alignment, VkSystemAllocationScope scope, PFN_vkAllocationFunction allocate, PFN_vkFreeFunction free) noexcept {
+			if (original == nullptr) {
+				return allocate(user_data, size, alignment, scope);
+			}
+			if (size == 0) {
+				free(user_data, original);
+				return nullptr;
+			}
+
+			void* ptr = allocate(user_data, size, alignment, scope);
+			if (ptr != nullptr) {
+				std::memcpy(ptr, original, std::min(size, details::get_host_block_header(original).size));
+				free(user_data, original);
+			}
+			return ptr;
+		}
+
+		void update_peak(std::atomic<usize>& peak, usize value) noexcept {
+			usize current = peak.load(std::memory_order_relaxed);
+			while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+		}
+
+		[[nodiscard]]
+		constexpr u32 get_size_class(usize size) noexcept {
+			usize width = std::bit_width(std::max(size, PoolHostAllocator::kMinPooledSize) - 1);
+			return static_cast<u32>(width - std::countr_zero(PoolHostAllocator::kMinPooledSize));
+		}
+		static_assert(get_size_class(1) == 0);
+		static_assert(get_size_class(16) == 0);
+		static_assert(get_size_class(17) == 1);
+		static_assert(get_size_class(PoolHostAllocator::kMaxPooledSize) == PoolHostAllocator::kClassCount - 1);
+
+		[[nodiscard]]
+		constexpr usize get_block_stride(u32 size_class) noexcept {
+			return sizeof(details::HostBlockHeader) + (PoolHostAllocator::kMinPooledSize << size_class);
+		}
+	}
+
+	const VkAllocationCallbacks* get_allocation_callbacks(VkInstance instance) noexcept {
+		return g_instance_callbacks.get(instance);
+	}
+
+	const VkAllocationCallbacks* get_allocation_callbacks(VkDevice device) noexcept {
+		return g_device_callbacks.get(device);
+	}
+
+	namespace details {
+		void register_allocation_callbacks(VkInstance instance, const VkAllocationCallbacks* callbacks) noexcept {
+			g_instance_callbacks.add(instance, callbacks);
+		}
+
+		void register_allocation_callbacks(VkDevice device, const VkAllocationCallbacks* callbacks) noexcept {
+			g_device_callbacks.add(device, callbacks);
+		}
+
+		void unregister_allocation_callbacks(VkInstance instance) noexcept {
+			g_instance_callbacks.remove(instance);
+		}
+
+		void unregister_allocation_callbacks(VkDevice device) noexcept {
+			g_device_callbacks.remove(device);
+		}
+
+		void* host_allocate(const VkAllocationCallbacks* upstream, usize size, usize alignment, VkSystemAllocationScope scope, u32 tag) noexcept {
+			alignment = std::max(alignment, alignof(HostBlockHeader));
+			usize total = size + sizeof(HostBlockHeader) + alignment - 1;
+
+			void* raw = upstream != nullptr ?
+				upstream->pfnAllocation(upstream->pUserData, total, alignof(HostBlockHeader), scope) :
+				std::malloc(total);
+
+			if (raw == nullptr) {
+				return nullptr;
+			}
+
+			usize address = align_up(reinterpret_cast<usize>(raw) + sizeof(HostBlockHeader), alignment);
+			void* ptr = reinterpret_cast<void*>(address);
+			get_host_block_header(ptr) = HostBlockHeader{ .raw = raw, .size = size, .tag = tag };
+			return ptr;
+		}
+
+		void host_free(const VkAllocationCallbacks* upstream, void* ptr) noexcept {
+			if (ptr == nullptr) {
+				return;
+			}
+
+			void* raw = get_host_block_header(ptr).raw;
+			if (upstream != nullptr) {
+				upstream->pfnFree(upstream->pUserData, raw);
+			}
+			else {
+				std::free(raw);
+			}
+		}
+	}
+
+	TrackingHostAllocator::TrackingHostAllocator(const VkAllocationCallbacks* upstream) noexcept
+		: upstream_{ upstream }
+	{
+		callbacks_ = VkAllocationCallbacks{
+			.pUserData = this,
+			.pfnAllocation = &allocate_,
+			.pfnReallocation = &reallocate_,
+			.pfnFree = &free_,
+			.pfnInternalAllocation = &internal_allocation_,
+			.pfnInternalFree = &internal_free_,
+		};
+	}
+
+	HostAllocationStats TrackingHostAllocator::get_stats(HostAllocationScope scope) const noexcept {
+		const auto& counters = counters_[std::to_underlying(scope)];
+		return HostAllocationStats{
+			.allocation_count = counters.allocation_count.load(std::memory_order_relaxed),
+			.reallocation_count = counters.reallocation_count.load(std::memory_order_relaxed),
+			.free_count = counters.free_count.load(std::memory_order_relaxed),
+			.live_bytes = counters.live_bytes.load(std::memory_order_relaxed),
+			.peak_bytes = counters.peak_bytes.load(std::memory_order_relaxed),
+			.internal_bytes = counters.internal_bytes.load(std::memory_order_relaxed),
+		};
+	}
+
+	HostAllocationStats TrackingHostAllocator::get_total_stats() const noexcept {
+		HostAllocationStats ret{};
+		for (usize i : std::views::iota(usize{ 0 }, counters_.size())) {
+			auto stats = get_stats(static_cast<HostAllocationScope>(i));
+			ret.allocation_count += stats.allocation_count;
+			ret.reallocation_count += stats.reallocation_count;
+			ret.free_count += stats.free_count;
+			ret.live_bytes += stats.live_bytes;
+			// Per-scope peaks may happen at different times, so this is an upper bound
+			ret.peak_bytes += stats.peak_bytes;
+			ret.internal_bytes += stats.internal_bytes;
+		}
+		return ret;
+	}
+
+	void TrackingHostAllocator::reset_stats() noexcept {
+		for (auto& counters : counters_) {
+			counters.allocation_count.store(0, std::memory_order_relaxed);
+			counters.reallocation_count.store(0, std::memory_order_relaxed);
+			counters.free_count.store(0, std::memory_order_relaxed);
+			counters.peak_bytes.store(counters.live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+
+	void TrackingHostAllocator::on_allocate_(HostAllocationScope scope, usize size) noexcept {
+		auto& counters = counters_[std::to_underlying(scope)];
+		usize live = counters.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+		update_peak(counters.peak_bytes, live);
+	}
+
+	void* VKAPI_PTR TrackingHostAllocator::allocate_(void* user_data, usize size, usize alignment, VkSystemAllocationScope scope) {
+		auto& self = *static_cast<TrackingHostAllocator*>(user_data);
+
+		void* ptr = details::host_allocate(self.upstream_, size, alignment, scope, static_cast<u32>(scope));
+		if (ptr != nullptr) {
+			self.counters_[std::to_underlying(host_allocation_scope_from_vk(scope))].allocation_count.fetch_add(1, std::memory_order_relaxed);
+			self.on_allocate_(host_allocation_scope_from_vk(scope), size);
+		}
+		return ptr;
+	}
+
+	void* VKAPI_PTR TrackingHostAllocator::reallocate_(void* user_data, void* original, usize size, usize alignment, VkSystemAllocationScope scope) {
+		auto& self = *static_cast<TrackingHostAllocator*>(user_data);
+
+		if (original == nullptr || size == 0) {
+			return host_reallocate(user_data, original, size, alignment, scope, &allocate_, &free_);
+		}
+
+		const auto& header = details::get_host_block_header(original);
+		auto old_scope = static_cast<HostAllocationScope>(header.tag);
+		usize old_size = header.size;
+
+		void* ptr = details::host_allocate(self.upstream_, size, alignment, scope, static_cast<u32>(scope));
+		if (ptr == nullptr) {
+			return nullptr;
+		}
+		std::memcpy(ptr, original, std::min(size, old_size));
+		details::host_free(self.upstream_, original);
+
+		self.counters_[std::to_underlying(old_scope)].live_bytes.fetch_sub(old_size, std::memory_order_relaxed);
+		self.counters_[std::to_underlying(host_allocation_scope_from_vk(scope))].reallocation_count.fetch_add(1, std::memory_order_relaxed);
+		self.on_allocate_(host_allocation_scope_from_vk(scope), size);
+		return ptr;
+	}
+
+	void VKAPI_PTR TrackingHostAllocator::free_(void* user_data, void* ptr) {
+		if (ptr == nullptr) {
+			return;
+		}
+		auto& self = *static_cast<TrackingHostAllocator*>(user_data);
+
+		const auto& header = details::get_host_block_header(ptr);
+		auto& counters = self.counters_[header.tag];
+		counters.free_count.fetch_add(1, std::memory_order_relaxed);
+		counters.live_bytes.fetch_sub(header.size, std::memory_order_relaxed);
+
+		details::host_free(self.upstream_, ptr);
+	}
+
+	void VKAPI_PTR TrackingHostAllocator::internal_allocation_(void* user_data, usize size, VkInternalAllocationType, VkSystemAllocationScope scope) {
+		auto& self = *static_cast<TrackingHostAllocator*>(user_data);
+		self.counters_[std::to_underlying(host_allocation_scope_from_vk(scope))].internal_bytes.fetch_add(size, std::memory_order_relaxed);
+	}
+
+	void VKAPI_PTR TrackingHostAllocator::internal_free_(void* user_data, usize size, VkInternalAllocationType, VkSystemAllocationScope scope) {
+		auto& self = *static_cast<TrackingHostAllocator*>(user_data);
+		self.counters_[std::to_underlying(host_allocation_scope_from_vk(scope))].internal_bytes.fetch_sub(size, std::memory_order_relaxed);
+	}
+
+	ArenaHostAllocator::ArenaHostAllocator(usize capacity, const VkAllocationCallbacks* upstream) noexcept
+		: upstream_{ upstream }
+	{
+		callbacks_ = VkAllocationCallbacks{
+			.pUserData = this,
+			.pfnAllocation = &allocate_,
+			.pfnReallocation = &reallocate_,
+			.pfnFree = &free_,
+		};
+
+		memory_ = static_cast<u8*>(details::host_allocate(upstream_, capacity, alignof(details::HostBlockHeader), VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE, 0));
+		capacity_ = memory_ != nullptr ? capacity : 0;
+	}
+
+	ArenaHostAllocator::~ArenaHostAllocator() noexcept {
+		details::host_free(upstream_, memory_);
+	}
+
+	void* VKAPI_PTR ArenaHostAllocator::allocate_(void* user_data, usize size, usize alignment, VkSystemAllocationScope scope) {
+		auto& self = *static_cast<ArenaHostAllocator*>(user_data);
+
+		if (scope != VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+			return details::host_allocate(self.upstream_, size, alignment, scope, 0);
+		}
+
+		alignment = std::max(alignment, alignof(details::HostBlockHeader));
+		usize reserved = size + sizeof(details::HostBlockHeader) + alignment - 1;
+		usize begin = self.head_.fetch_add(reserved, std::memory_order_relaxed);
+
+		if (begin + reserved > self.capacity_) {
+			self.fallback_count_.fetch_add(1, std::memory_order_relaxed);
+			return details::host_allocate(self.upstream_, size, alignment, scope, 0);
+		}
+
+		usize address = align_up(reinterpret_cast<usize>(self.memory_ + begin) + sizeof(details::HostBlockHeader), alignment);
+		void* ptr = reinterpret_cast<void*>(address);
+		details::get_host_block_header(ptr) = details::HostBlockHeader{ .size = size };
+		return ptr;
+	}
+
+	void* VKAPI_PTR ArenaHostAllocator::reallocate_(void* user_data, void* original, usize size, usize alignment, VkSystemAllocationScope scope) {
+		return host_reallocate(user_data, original, size, alignment, scope, &allocate_, &free_);
+	}
+
+	void VKAPI_PTR ArenaHostAllocator::free_(void* user_data, void* ptr) {
+		auto& self = *static_cast<ArenaHostAllocator*>(user_data);
+		if (ptr != nullptr && !self.owns_(ptr)) {
+			details::host_free(self.upstream_, ptr);
+		}
+	}
+
+	struct PoolHostAllocator::ThreadCache {
+		std::array<FreeBlock*, kClassCount> heads{};
+
+		void drain(PoolHostAllocator& owner) noexcept {
+			for (u32 size_class : std::views::iota(0u, static_cast<u32>(kClassCount))) {
+				FreeBlock* head = heads[size_class];
+				if (head == nullptr) {
+					continue;
+				}
+
+				FreeBlock* tail = head;
+				while (tail->next != nullptr) {
+					tail = tail->next;
+				}
+				owner.push_shared_(size_class, head, tail);
+			}
+			heads = {};
+		}
+	};
+
+	thread_local details::ThreadCacheMap<PoolHostAllocator, PoolHostAllocator::ThreadCache> PoolHostAllocator::t_caches_;
+
+	PoolHostAllocator::PoolHostAllocator(const VkAllocationCallbacks* upstream) noexcept
+		: upstream_{ upstream }
+		, id_{ details::register_thread_cache_owner(this) }
+	{
+		callbacks_ = VkAllocationCallbacks{
+			.pUserData = this,
+			.pfnAllocation = &allocate_,
+			.pfnReallocation = &reallocate_,
+			.pfnFree = &free_,
+		};
+	}
+
+	PoolHostAllocator::~PoolHostAllocator() noexcept {
+		// Thread caches still pointing into the chunks drop their blocks once the pool is gone
+		details::unregister_thread_cache_owner(id_);
+
+		for (void* chunk : chunks_) {
+			details::host_free(upstream_, chunk);
+		}
+	}
+
+	auto PoolHostAllocator::refill_(u32 size_class) noexcept -> FreeBlock* {
+		{
+			auto& shared = shared_[size_class];
+			std::lock_guard lock{ shared.mutex };
+			if (shared.head != nullptr) {
+				return std::exchange(shared.head, nullptr);
+			}
+		}
+
+		void* chunk = details::host_allocate(upstream_, kChunkSize, alignof(details::HostBlockHeader), VK_SYSTEM_ALLOCATION_SCOPE_OBJECT, 0);
+		if (chunk == nullptr) {
+			return nullptr;
+		}
+
+		{
+			std::lock_guard lock{ chunks_mutex_ };
+			chunks_.push_back(chunk);
+		}
+
+		usize stride = get_block_stride(size_class);
+		usize count = kChunkSize / stride;
+		u8* base = static_cast<u8*>(chunk);
+
+		FreeBlock* head = nullptr;
+		for (usize i : std::views::iota(usize{ 0 }, count) | std::views::reverse) {
+			auto* block = reinterpret_cast<FreeBlock*>(base + i * stride);
+			block->next = head;
+			head = block;
+		}
+		return head;
+	}
+
+	void PoolHostAllocator::push_shared_(u32 size_class, FreeBlock* head, FreeBlock* tail) noexcept {
+		auto& shared = shared_[size_class];
+		std::lock_guard lock{ shared.mutex };
+		tail->next = shared.head;
+		shared.head = head;
+	}
+
+	void* PoolHostAllocator::allocate_pooled_(u32 size_class) noexcept {
+		auto& cache = t_caches_.get(id_);
+
+		FreeBlock* head = cache.heads[size_class];
+		if (head == nullptr) {
+			head = refill_(size_class);
+			if (head == nullptr) {
+				return nullptr;
+			}
+		}
+		cache.heads[size_class] = head->next;
+
+		return reinterpret_cast<u8*>(head) + sizeof(details::HostBlockHeader);
+	}
+
+	void PoolHostAllocator::free_pooled_(void* ptr, u32 size_class) noexcept {
+		auto* block = reinterpret_cast<FreeBlock*>(static_cast<u8*>(ptr) - sizeof(details::HostBlockHeader));
+
+		if (auto* cache = t_caches_.find(id_); cache != nullptr) {
+			block->next = cache->heads[size_class];
+			cache->heads[size_class] = block;
+			return;
+		}
+
+		push_shared_(size_class, block, block);
+	}
+
+	void* VKAPI_PTR PoolHostAllocator::allocate_(void* user_data, usize size, usize alignment, VkSystemAllocationScope scope) {
+		auto& self = *static_cast<PoolHostAllocator*>(user_data);
+
+		if (size > kMaxPooledSize || alignment > kMaxPooledAlignment) {
+			return details::host_allocate(self.upstream_, size, alignment, scope, 0);
+		}
+
+		u32 size_class = get_size_class(size);
+		void* ptr = self.allocate_pooled_(size_class);
+		if (ptr != nullptr) {
+			details::get_host_block_header(ptr) = details::HostBlockHeader{ .size = size, .tag = size_class + 1 };
+		}
+		return ptr;
+	}
+
+	void* VKAPI_PTR PoolHostAllocator::reallocate_(void* user_data, void* original, usize size, usize alignment, VkSystemAllocationScope scope) {
+		if (original != nullptr && size != 0 && alignment <= kMaxPooledAlignment) {
+			// Shrinking or growing within the same size class keeps the block
+			auto& header = details::get_host_block_header(original);
+			if (header.tag != 0 && size <= kMaxPooledSize && get_size_class(size) == header.tag - 1) {
+				header.size = size;
+				return original;
+			}
+		}
+		return host_reallocate(user_data, original, size, alignment, scope, &allocate_, &free_);
+	}
+
+	void VKAPI_PTR PoolHostAllocator::free_(void* user_data, void* ptr) {
+		if (ptr == nullptr) {
+			return;
+		}
+		auto& self = *static_cast<PoolHostAllocator*>(user_data);
+
+		u32 tag = details::get_host_block_header(ptr).tag;
+		if (tag != 0) {
+			self.free_pooled_(ptr, tag - 1);
+		}
+		else {
+			details::host_free(self.upstream_, ptr);
+		}
+	}
+}
@@ -0,0 +1,129 @@
+#include <host_upload.hpp>
+
+namespace gx {
+	HostUploader::HostUploader(Allocator& allocator, StagingRing& staging, HostUploaderConfig config) noexcept
+		: allocator_{ &allocator }
+		, staging_{ &staging }
+		, config_{ config }
+	{
+		if (!config_.import_host_memory) {
+			return;
+		}
+
+		// Without VK_EXT_external_memory_host import_alignment_ stays 0 and every upload goes through staging
+		const auto& info = PhysDeviceInfo::get(allocator.get_phys_device());
+		if (!info.supports_host_memory_import()) {
+			return;
+		}
+
+		get_host_pointer_properties_ = ext::FuncLoader::load<PFN_vkGetMemoryHostPointerPropertiesEXT>(allocator.get_device(), "vkGetMemoryHostPointerPropertiesEXT")
+			.value_or(nullptr);
+		if (get_host_pointer_properties_ != nullptr) {
+			import_alignment_ = info.limits.min_imported_host_pointer_alignment;
+		}
+	}
+
+	auto HostUploader::import_(std::span<const std::byte> data) noexcept -> std::expected<std::pair<Import, usize>, ErrorCode> {
+		VkDevice device = allocator_->get_device();
+
+		// Whole pages around the data are imported, the source offset skips to the data itself
+		usize address = reinterpret_cast<usize>(data.data());
+		usize base = address / import_alignment_ * import_alignment_;
+		usize size = align_up(address + data.size(), import_alignment_) - base;
+		void* ptr = reinterpret_cast<void*>(base);
+
+		VkMemoryHostPointerPropertiesEXT props = {
+			.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT,
+		};
+		VkResult res = get_host_pointer_properties_(device, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, ptr, &props);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+
+		auto buffer = BufferBuilder{ device }
+			.with_size(size)
+			.with_usage(std::to_underlying(BufferUsage::eTransferSrc))
+			.with_external_handle_types(std::to_underlying(ExternalMemoryHandleType::eHostAllocation))
+			.build();
+
+		if (!buffer.has_value()) {
+			return std::unexpected(buffer.error());
+		}
+
+		VkMemoryRequirements reqs{};
+		vkGetBufferMemoryRequirements(device, buffer->get_handle(), &reqs);
+
+		auto allocation = allocator_->import_host_memory(ptr, size, reqs.memoryTypeBits & props.memoryTypeBits);
+		if (!allocation.has_value()) {
+			std::move(*buffer).destroy();
+			return std::unexpected(allocation.error());
+		}
+
+		res = vkBindBufferMemory(device, buffer->get_handle(), allocation->get_handle(), 0);
+		if (res != VK_SUCCESS) {
+			std::move(*buffer).destroy();
+			std::move(*allocation).destroy();
+			return std::unexpected(convert_vk_result(res));
+		}
+
+		Import ret{
+			.allocation = std::move(*allocation).to_owned<MoveOnlyTag, ViewableTag>(),
+			.buffer = std::move(*buffer).to_owned<MoveOnlyTag, ViewableTag>(),
+		};
+		return std::make_pair(std::move(ret), address - base);
+	}
+
+	auto HostUploader::record_upload(VkCommandBuffer cmd, std::span<const std::byte> data, BufferView dst, usize dst_offset) noexcept -> std::expected<UploadPath, ErrorCode> {
+		if (can_import(data)) {
+			auto imported = import_(data);
+
+			if (imported.has_value()) {
+				auto& [value, src_offset] = *imported;
+
+				VkBufferCopy copy = {
+					.srcOffset = src_offset,
+					.dstOffset = dst_offset,
+					.size = data.size(),
+				};
+				vkCmdCopyBuffer(cmd, value.buffer.get_view().get_handle(), dst.get_handle(), 1, &copy);
+
+				std::lock_guard lock{ mutex_ };
+				recorded_.push_back(std::move(value));
+				return UploadPath::eImported;
+			}
+		}
+
+		auto region = staging_->write(data);
+		if (!region.has_value()) {
+			return std::unexpected(ErrorCode::eOutOfPoolMemory);
+		}
+
+		StagingRing::record_copy(cmd, *region, dst, dst_offset);
+
+		std::lock_guard lock{ mutex_ };
+		staged_.push_back(region->ticket);
+		return UploadPath::eStaged;
+	}
+
+	void HostUploader::submit(u64 retire_value) noexcept {
+		std::lock_guard lock{ mutex_ };
+		for (auto& value : recorded_) {
+			value.retire_value = retire_value;
+			in_flight_.push_back(std::move(value));
+		}
+		recorded_.clear();
+
+		staging_->submit(retire_value, staged_);
+		staged_.clear();
+	}
+
+	void HostUploader::retire(u64 completed_value) noexcept {
+		{
+			std::lock_guard lock{ mutex_ };
+			while (!in_flight_.empty() && in_flight_.front().retire_value <= completed_value) {
+				in_flight_.pop_front();
+			}
+		}
+		staging_->retire(completed_value);
+	}
+}
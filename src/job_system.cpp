@@ -0,0 +1,135 @@
+#include <job_system.hpp>
+
+namespace gx {
+	namespace {
+		// Unsuccessful scans a worker spins for before it goes to sleep
+		constexpr u32 kSpinCount = 64;
+
+		thread_local const JobSystem* t_job_system = nullptr;
+		thread_local u32 t_thread_index = 0;
+		// System an external thread holds deque 0 of, jobs it runs while waiting may submit again
+		thread_local const JobSystem* t_external_owner = nullptr;
+	}
+
+	JobSystem::JobSystem(u32 worker_count) noexcept {
+		deques_.reserve(worker_count + 1);
+		for (u32 i = 0; i < worker_count + 1; ++i) {
+			deques_.push_back(std::make_unique<details::WorkStealingDeque>());
+		}
+
+		workers_.reserve(worker_count);
+		for (u32 i = 1; i <= worker_count; ++i) {
+			workers_.emplace_back(
+				[this, i] {
+					worker_loop_(i);
+				}
+			);
+		}
+	}
+
+	JobSystem::~JobSystem() noexcept {
+		is_stopping_.store(true, std::memory_order_seq_cst);
+		epoch_.fetch_add(1, std::memory_order_seq_cst);
+		epoch_.notify_all();
+		workers_.clear();
+	}
+
+	u32 JobSystem::get_thread_index() const noexcept {
+		return t_job_system == this ? t_thread_index : 0;
+	}
+
+	void JobSystem::execute_(details::Job* job, u32 thread_index) noexcept {
+		job->fn(job->data, job->index, thread_index);
+		job->remaining->fetch_sub(1, std::memory_order_release);
+	}
+
+	details::Job* JobSystem::find_job_(u32 thread_index) noexcept {
+		if (auto* job = deques_[thread_index]->pop(); job != nullptr) {
+			return job;
+		}
+
+		u32 count = get_thread_count();
+		for (u32 i = 1; i < count; ++i) {
+			if (auto* job = deques_[(thread_index + i) % count]->steal(); job != nullptr) {
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	void JobSystem::wake_workers_() noexcept {
+		// Pairs with the fence in worker_loop_(), either the worker sees the new jobs or this sees the sleeper
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleeping_count_.load(std::memory_order_relaxed) != 0) {
+			epoch_.fetch_add(1, std::memory_order_relaxed);
+			epoch_.notify_all();
+		}
+	}
+
+	void JobSystem::run_(std::vector<details::Job>& jobs, std::atomic<u32>& remaining) noexcept {
+		u32 thread_index = get_thread_index();
+
+		// External threads share deque 0, workers submitting nested work own theirs
+		std::unique_lock<std::mutex> lock;
+		const JobSystem* prev_owner = t_external_owner;
+		if (thread_index == 0 && prev_owner != this) {
+			lock = std::unique_lock{ external_mutex_ };
+			t_external_owner = this;
+		}
+
+		auto& deque = *deques_[thread_index];
+		for (auto& job : jobs) {
+			if (!deque.push(&job)) {
+				execute_(&job, thread_index);
+			}
+		}
+		wake_workers_();
+
+		while (remaining.load(std::memory_order_acquire) != 0) {
+			if (auto* job = find_job_(thread_index); job != nullptr) {
+				execute_(job, thread_index);
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		t_external_owner = prev_owner;
+	}
+
+	void JobSystem::worker_loop_(u32 thread_index) noexcept {
+		t_job_system = this;
+		t_thread_index = thread_index;
+
+		u32 idle_scans = 0;
+		while (!is_stopping_.load(std::memory_order_relaxed)) {
+			if (auto* job = find_job_(thread_index); job != nullptr) {
+				execute_(job, thread_index);
+				idle_scans = 0;
+				continue;
+			}
+
+			if (++idle_scans < kSpinCount) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			u32 epoch = epoch_.load(std::memory_order_relaxed);
+			sleeping_count_.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			// Jobs pushed before the submitter could see this thread as sleeping
+			if (auto* job = find_job_(thread_index); job != nullptr) {
+				sleeping_count_.fetch_sub(1, std::memory_order_relaxed);
+				execute_(job, thread_index);
+				idle_scans = 0;
+				continue;
+			}
+
+			if (!is_stopping_.load(std::memory_order_relaxed)) {
+				epoch_.wait(epoch, std::memory_order_relaxed);
+			}
+			sleeping_count_.fetch_sub(1, std::memory_order_relaxed);
+			idle_scans = 0;
+		}
+	}
+}
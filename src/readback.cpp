@@ -0,0 +1,251 @@
+#include <readback.hpp>
+
+#include <bit>
+#include <algorithm>
+
+namespace gx {
+	ReadbackRing::ReadbackRing(ReadbackRing&& rhs) noexcept
+		: allocator_{ std::exchange(rhs.allocator_, nullptr) }
+		, allocation_{ std::move(rhs.allocation_) }
+		, buffer_{ std::move(rhs.buffer_) }
+		, buffer_handle_{ std::exchange(rhs.buffer_handle_, VK_NULL_HANDLE) }
+		, base_{ std::exchange(rhs.base_, nullptr) }
+		, capacity_{ std::exchange(rhs.capacity_, 0) }
+		, alignment_{ rhs.alignment_ }
+		, head_{ rhs.head_ }
+		, tail_{ rhs.tail_ }
+		, requests_{ std::move(rhs.requests_) }
+		, last_retire_value_{ rhs.last_retire_value_ }
+	{}
+
+	auto ReadbackRing::create(Allocator& allocator, ReadbackRingConfig config) noexcept -> std::expected<ReadbackRing, ErrorCode> {
+		usize capacity = align_up(config.size, kb_to_bytes(64));
+
+		auto buffer = BufferBuilder{ allocator.get_device() }
+			.with_size(capacity)
+			.with_usage(std::to_underlying(BufferUsage::eTransferDst))
+			.build();
+
+		if (!buffer.has_value()) {
+			return std::unexpected(buffer.error());
+		}
+
+		auto allocation = allocator.allocate_for_buffer(buffer->get_handle(), MemoryUsage::eReadbackCached);
+		if (!allocation.has_value()) {
+			std::move(*buffer).destroy();
+			return std::unexpected(allocation.error());
+		}
+		assert(allocation->get_mapped_ptr() != nullptr && "ReadbackRing::create(): readback memory must be host visible");
+
+		ReadbackRing ret{};
+		ret.allocator_ = &allocator;
+		ret.buffer_handle_ = buffer->get_handle();
+		ret.base_ = static_cast<const u8*>(allocation->get_mapped_ptr());
+		ret.capacity_ = capacity;
+		ret.alignment_ = config.alignment;
+		ret.buffer_ = std::move(*buffer).to_owned<MoveOnlyTag, ViewableTag>();
+		ret.allocation_ = std::move(*allocation).to_owned<MoveOnlyTag, ViewableTag>();
+
+		return ret;
+	}
+
+	std::optional<usize> ReadbackRing::push_request_(VkCommandBuffer cmd, usize size, usize alignment, ReadbackResult result, ReadbackCallback&& callback) noexcept {
+		// VUID-VkBufferCopy-size-01988
+		assert(size != 0 && "ReadbackRing: size must not be 0");
+		if (size > capacity_) {
+			return std::nullopt;
+		}
+		alignment = std::max(alignment, alignment_);
+
+		std::lock_guard lock{ mutex_ };
+		u64 begin = align_up(head_, alignment);
+
+		// A region never wraps around the end of the buffer, the tail is skipped instead
+		usize phys = static_cast<usize>(begin % capacity_);
+		if (phys + size > capacity_) {
+			begin += capacity_ - phys;
+		}
+		u64 end = begin + size;
+
+		if (end - tail_ > capacity_) {
+			return std::nullopt;
+		}
+		head_ = end;
+
+		usize offset = static_cast<usize>(begin % capacity_);
+		result.data = std::span{ reinterpret_cast<const std::byte*>(base_ + offset), size };
+		requests_.push_back(Request{
+			.begin = begin,
+			.end = end,
+			.cmd = cmd,
+			.offset = offset,
+			.result = result,
+			.callback = std::move(callback),
+		});
+		return offset;
+	}
+
+	auto ReadbackRing::record_copy(VkCommandBuffer cmd, BufferView src, usize src_offset, usize size, ReadbackCallback callback) noexcept -> std::expected<void, ErrorCode> {
+		auto offset = push_request_(cmd, size, 0, ReadbackResult{ .row_pitch = static_cast<u32>(size) }, std::move(callback));
+		if (!offset.has_value()) {
+			return std::unexpected(ErrorCode::eOutOfPoolMemory);
+		}
+
+		VkBufferCopy copy = {
+			.srcOffset = src_offset,
+			.dstOffset = *offset,
+			.size = size,
+		};
+		vkCmdCopyBuffer(cmd, src.get_handle(), buffer_handle_, 1, &copy);
+		record_host_barrier_(cmd, *offset, size);
+		return {};
+	}
+
+	auto ReadbackRing::record_copy(VkCommandBuffer cmd, ImageView src, ImageLayout layout, Format format, Extent2D extent, ImageSubresourceRange range, ReadbackCallback callback) noexcept -> std::expected<void, ErrorCode> {
+		// VUID-VkBufferImageCopy-aspectMask-00212
+		assert(std::has_single_bit(range.aspect_mask) && "range.aspect_mask must contain a single aspect");
+		assert(test_bit(get_format_aspects(format), static_cast<ImageAspect>(range.aspect_mask)) && "range.aspect_mask must be an aspect of the format");
+		// VUID-vkCmdCopyImageToBuffer-srcImageLayout-01397
+		assert((layout == ImageLayout::eTransferSrc || layout == ImageLayout::eGeneral) && "layout must be eTransferSrc or eGeneral");
+
+		u32 texel_size = get_format_copy_size(format, static_cast<ImageAspect>(range.aspect_mask));
+		assert(texel_size != 0 && "ReadbackRing::record_copy(): format has no known texel size");
+
+		u32 row_pitch = extent.width * texel_size;
+		usize size = static_cast<usize>(row_pitch) * extent.height * range.layer_count;
+
+		ReadbackResult result{
+			.format = format,
+			.extent = extent,
+			.row_pitch = row_pitch,
+			.layer_count = range.layer_count,
+		};
+
+		// VUID-vkCmdCopyImageToBuffer-dstBuffer-00194, bufferOffset is a multiple of 4 and of the texel size
+		auto offset = push_request_(cmd, size, std::max<usize>(4, texel_size), result, std::move(callback));
+		if (!offset.has_value()) {
+			return std::unexpected(ErrorCode::eOutOfPoolMemory);
+		}
+
+		VkBufferImageCopy copy = {
+			.bufferOffset = *offset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = VkImageSubresourceLayers{
+				.aspectMask = image_aspect_flags_to_vk(range.aspect_mask),
+				.mipLevel = range.base_mip_level,
+				.baseArrayLayer = range.base_array_layer,
+				.layerCount = range.layer_count,
+			},
+			.imageOffset = VkOffset3D{ 0, 0, 0 },
+			.imageExtent = VkExtent3D{ extent.width, extent.height, 1 },
+		};
+		vkCmdCopyImageToBuffer(cmd, src.get_handle(), image_layout_to_vk(layout), buffer_handle_, 1, &copy);
+		record_host_barrier_(cmd, *offset, size);
+		return {};
+	}
+
+	void ReadbackRing::record_host_barrier_(VkCommandBuffer cmd, usize offset, usize size) const noexcept {
+		// The timeline signal alone doesn't make the copied bytes visible to host reads
+		VkBufferMemoryBarrier2 barrier = {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+			.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+			.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+			.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = buffer_handle_,
+			.offset = offset,
+			.size = size,
+		};
+		VkDependencyInfo di = {
+			.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+			.bufferMemoryBarrierCount = 1,
+			.pBufferMemoryBarriers = &barrier,
+		};
+		vkCmdPipelineBarrier2(cmd, &di);
+	}
+
+	ReadbackCallback ReadbackRing::make_future_callback_(std::promise<std::vector<std::byte>> promise) noexcept {
+		return [promise = std::move(promise)](const ReadbackResult& result) mutable {
+			promise.set_value(std::vector<std::byte>(result.data.begin(), result.data.end()));
+		};
+	}
+
+	auto ReadbackRing::record_copy_future(VkCommandBuffer cmd, BufferView src, usize src_offset, usize size) noexcept -> std::expected<std::future<std::vector<std::byte>>, ErrorCode> {
+		std::promise<std::vector<std::byte>> promise;
+		auto future = promise.get_future();
+
+		return record_copy(cmd, src, src_offset, size, make_future_callback_(std::move(promise)))
+			.transform(
+				[&future]() noexcept {
+					return std::move(future);
+				}
+			);
+	}
+
+	auto ReadbackRing::record_copy_future(VkCommandBuffer cmd, ImageView src, ImageLayout layout, Format format, Extent2D extent, ImageSubresourceRange range) noexcept -> std::expected<std::future<std::vector<std::byte>>, ErrorCode> {
+		std::promise<std::vector<std::byte>> promise;
+		auto future = promise.get_future();
+
+		return record_copy(cmd, src, layout, format, extent, range, make_future_callback_(std::move(promise)))
+			.transform(
+				[&future]() noexcept {
+					return std::move(future);
+				}
+			);
+	}
+
+	void ReadbackRing::submit(VkCommandBuffer cmd, u64 retire_value) noexcept {
+		std::lock_guard lock{ mutex_ };
+		assert(last_retire_value_ <= retire_value && "ReadbackRing::submit(): retire_value must increase monotonically");
+		last_retire_value_ = retire_value;
+
+		// Command buffers are reused across frames, so only requests that are still waiting for a submission match
+		for (auto& request : requests_) {
+			if (request.cmd == cmd && !request.is_submitted) {
+				request.is_submitted = true;
+				request.retire_value = retire_value;
+			}
+		}
+	}
+
+	usize ReadbackRing::poll(u64 completed_value) noexcept {
+		std::vector<Request> completed;
+		{
+			std::lock_guard lock{ mutex_ };
+			while (!requests_.empty() && requests_.front().is_submitted && requests_.front().retire_value <= completed_value) {
+				completed.push_back(std::move(requests_.front()));
+				requests_.pop_front();
+			}
+		}
+
+		if (completed.empty()) {
+			return 0;
+		}
+
+		// Callbacks run without the lock, the space is reclaimed only after all of them returned
+		for (auto& request : completed) {
+			[[maybe_unused]] auto res = allocator_->invalidate(allocation_.get_view(), request.offset, request.result.data.size());
+			assert(res.has_value() && "ReadbackRing::poll(): failed to invalidate readback memory");
+
+			if (request.callback) {
+				request.callback(request.result);
+			}
+		}
+
+		std::lock_guard lock{ mutex_ };
+		tail_ = completed.back().end;
+		return completed.size();
+	}
+
+	usize ReadbackRing::poll(SemaphoreView timeline) noexcept {
+		u64 value = 0;
+		VkResult res = vkGetSemaphoreCounterValue(allocator_->get_device(), timeline.get_handle(), &value);
+		if (res != VK_SUCCESS) {
+			return 0;
+		}
+		return poll(value);
+	}
+}
@@ -0,0 +1,193 @@
+#include <residency.hpp>
+
+#include <algorithm>
+
+namespace gx {
+	ResidentId ResidencyManager::add(Allocation&& allocation, ResidencyPriority priority, EvictionCallback on_evict) noexcept {
+		usize size = allocation.get_size();
+		u32 heap_index = PhysDeviceInfo::get(allocator_->get_phys_device()).memory_infos[allocation.get_memory_type()].heap_index;
+
+		std::lock_guard lock{ mutex_ };
+
+		u32 index = 0;
+		if (!free_indices_.empty()) {
+			index = free_indices_.back();
+			free_indices_.pop_back();
+		}
+		else {
+			index = static_cast<u32>(entries_.size());
+			entries_.emplace_back();
+		}
+
+		auto& entry = entries_[index];
+		entry.allocation = std::move(allocation).to_owned<MoveOnlyTag, ViewableTag>();
+		entry.on_evict = std::move(on_evict);
+		entry.last_used_frame = frame_;
+		entry.size = size;
+		entry.heap_index = heap_index;
+		entry.priority = priority;
+		entry.is_resident = true;
+
+		++stats_.resident_count;
+		stats_.resident_bytes += size;
+
+		return ResidentId{ index, entry.generation };
+	}
+
+	auto ResidencyManager::release_(u32 index) noexcept -> Victim {
+		auto& entry = entries_[index];
+
+		Victim victim;
+		victim.allocation = std::move(entry.allocation);
+		victim.on_evict = std::move(entry.on_evict);
+		victim.id = ResidentId{ index, entry.generation };
+
+		// Outstanding ids of this slot become stale
+		entry.is_resident = false;
+		++entry.generation;
+		free_indices_.push_back(index);
+
+		--stats_.resident_count;
+		stats_.resident_bytes -= entry.size;
+		return victim;
+	}
+
+	void ResidencyManager::remove(ResidentId id) noexcept {
+		Victim victim;
+		{
+			std::lock_guard lock{ mutex_ };
+			if (find_(id) == nullptr) {
+				return;
+			}
+			victim = release_(id.index);
+		}
+		// The memory is freed here, after the lock is released
+	}
+
+	void ResidencyManager::touch(ResidentId id) noexcept {
+		std::lock_guard lock{ mutex_ };
+		if (auto* entry = find_(id); entry != nullptr) {
+			entry->last_used_frame = frame_;
+		}
+	}
+
+	void ResidencyManager::set_priority(ResidentId id, ResidencyPriority priority) noexcept {
+		std::lock_guard lock{ mutex_ };
+		if (auto* entry = find_(id); entry != nullptr) {
+			entry->priority = priority;
+		}
+	}
+
+	bool ResidencyManager::is_resident(ResidentId id) noexcept {
+		std::lock_guard lock{ mutex_ };
+		return find_(id) != nullptr;
+	}
+
+	AllocationView ResidencyManager::get_allocation(ResidentId id) noexcept {
+		std::lock_guard lock{ mutex_ };
+		auto* entry = find_(id);
+		assert(entry != nullptr && "ResidencyManager::get_allocation(): resource is not resident");
+		return entry->allocation.get_view();
+	}
+
+	usize ResidencyManager::evict(usize bytes, std::optional<u32> heap_index) noexcept {
+		std::vector<Victim> victims;
+		usize freed = 0;
+		{
+			std::lock_guard lock{ mutex_ };
+
+			std::vector<u32> candidates;
+			for (u32 i = 0; i < entries_.size(); ++i) {
+				const auto& entry = entries_[i];
+				if (!entry.is_resident || entry.last_used_frame + config_.protected_frames > frame_) {
+					continue;
+				}
+				if (heap_index.has_value() && entry.heap_index != *heap_index) {
+					continue;
+				}
+				candidates.push_back(i);
+			}
+
+			std::ranges::sort(candidates, [this](u32 lhs, u32 rhs) noexcept {
+				const auto& l = entries_[lhs];
+				const auto& r = entries_[rhs];
+				if (l.priority != r.priority) {
+					return l.priority < r.priority;
+				}
+				return l.last_used_frame < r.last_used_frame;
+			});
+
+			for (u32 index : candidates) {
+				if (freed >= bytes) {
+					break;
+				}
+				freed += entries_[index].size;
+				victims.push_back(release_(index));
+			}
+
+			stats_.eviction_count += victims.size();
+			stats_.evicted_bytes += freed;
+		}
+
+		// Owners drop the resources bound to the memory before it is freed
+		for (auto& victim : victims) {
+			if (victim.on_evict) {
+				victim.on_evict(victim.id);
+			}
+			[[maybe_unused]] auto released = std::move(victim.allocation);
+		}
+		return freed;
+	}
+
+	std::optional<u32> ResidencyManager::find_heap_index_(u32 memory_type_bits, MemoryUsage usage) const noexcept {
+		auto memory_type = allocator_->find_memory_type(memory_type_bits, usage);
+		if (!memory_type.has_value()) {
+			return std::nullopt;
+		}
+		return PhysDeviceInfo::get(allocator_->get_phys_device()).memory_infos[*memory_type].heap_index;
+	}
+
+	auto ResidencyManager::allocate_for_image(VkImage image, MemoryUsage usage, ResidencyPriority priority, EvictionCallback on_evict) noexcept -> std::expected<ResidentId, ErrorCode> {
+		VkMemoryRequirements reqs{};
+		vkGetImageMemoryRequirements(allocator_->get_device(), image, &reqs);
+
+		auto heap_index = find_heap_index_(reqs.memoryTypeBits, usage);
+		if (!heap_index.has_value()) {
+			return std::unexpected(ErrorCode::eMemoryTypeNotPresent);
+		}
+
+		auto allocation = retry_on_oom(
+			[this, image, usage]() noexcept {
+				return allocator_->allocate_for_image(image, usage);
+			},
+			*heap_index,
+			reqs.size
+		);
+		if (!allocation.has_value()) {
+			return std::unexpected(allocation.error());
+		}
+		return add(std::move(*allocation), priority, std::move(on_evict));
+	}
+
+	auto ResidencyManager::allocate_for_buffer(VkBuffer buffer, MemoryUsage usage, ResidencyPriority priority, EvictionCallback on_evict) noexcept -> std::expected<ResidentId, ErrorCode> {
+		VkMemoryRequirements reqs{};
+		vkGetBufferMemoryRequirements(allocator_->get_device(), buffer, &reqs);
+
+		auto heap_index = find_heap_index_(reqs.memoryTypeBits, usage);
+		if (!heap_index.has_value()) {
+			return std::unexpected(ErrorCode::eMemoryTypeNotPresent);
+		}
+
+		auto allocation = retry_on_oom(
+			[this, buffer, usage]() noexcept {
+				return allocator_->allocate_for_buffer(buffer, usage);
+			},
+			*heap_index,
+			reqs.size
+		);
+		if (!allocation.has_value()) {
+			return std::unexpected(allocation.error());
+		}
+		return add(std::move(*allocation), priority, std::move(on_evict));
+	}
+}
@@ -0,0 +1,433 @@
+#include <scheduler.hpp>
+
+#include <algorithm>
+
+namespace gx {
+	TimelineScheduler::~TimelineScheduler() noexcept {
+		if (timelines_.empty()) {
+			return;
+		}
+
+		// The semaphores must not be destroyed while submissions still signal them, wait_idle() flushes what's left
+		[[maybe_unused]] auto res = wait_idle();
+		for (auto& timeline : timelines_) {
+			for (auto& el : timeline->retirements) {
+				el.callback();
+			}
+		}
+	}
+
+	auto TimelineScheduler::create(VkDevice device, std::span<const VkQueue> queues) noexcept -> std::expected<TimelineScheduler, ErrorCode> {
+		assert(!queues.empty() && "TimelineScheduler::create(): at least one queue is required");
+		assert(queues.size() <= 64 && "TimelineScheduler::create(): at most 64 queues are supported");
+
+		TimelineScheduler ret{};
+		ret.device_ = device;
+		ret.timelines_.reserve(queues.size());
+
+		for (VkQueue queue : queues) {
+			auto semaphore = SemaphoreBuilder{ device }
+				.with_timeline(0)
+				.build();
+
+			if (!semaphore.has_value()) {
+				return std::unexpected(semaphore.error());
+			}
+			ret.timelines_.push_back(std::make_unique<QueueTimeline>(queue, std::move(*semaphore)));
+		}
+
+		return ret;
+	}
+
+	TimelinePoint TimelineScheduler::enqueue(u32 queue, const TimelineSubmitInfo& info) noexcept {
+		assert(queue < timelines_.size() && "TimelineScheduler::enqueue(): queue index out of range");
+
+		auto& timeline = *timelines_[queue];
+		std::lock_guard lock{ timeline.enqueue_mutex };
+
+		// Values are handed out under the lock, so they grow in the order the submissions are recorded in
+		u64 value = timeline.enqueued_value.fetch_add(1, std::memory_order_acq_rel) + 1;
+		record_(timeline, value, info);
+
+		return TimelinePoint{ queue, value };
+	}
+
+	void TimelineScheduler::enqueue_reserved(TimelinePoint point, const TimelineSubmitInfo& info) noexcept {
+		assert(point.queue < timelines_.size() && "TimelineScheduler::enqueue_reserved(): queue index out of range");
+
+		auto& timeline = *timelines_[point.queue];
+		std::lock_guard lock{ timeline.enqueue_mutex };
+		record_(timeline, point.value, info);
+	}
+
+	void TimelineScheduler::record_(QueueTimeline& timeline, u64 value, const TimelineSubmitInfo& info) noexcept {
+		// VUID-VkSemaphoreSubmitInfo-stageMask-parameter
+		assert(info.binary_wait_stages.size() == info.binary_waits.size() && "TimelineScheduler: every binary wait needs its stage mask");
+		// Signal values of a timeline must grow in submission order
+		assert(value == timeline.recorded_value + 1 && "TimelineScheduler: submissions must be recorded in value order, don't mix enqueue() and reserve() on a queue");
+
+		timeline.submission_count.fetch_add(1, std::memory_order_relaxed);
+		auto& batch = timeline.pending;
+
+		PendingSubmit submit{
+			.first_command_buffer = static_cast<u32>(batch.command_buffers.size()),
+			.command_buffer_count = static_cast<u32>(info.command_buffers.size()),
+			.first_wait = static_cast<u32>(batch.waits.size()),
+			.first_signal = static_cast<u32>(batch.signals.size()),
+		};
+
+		for (VkCommandBuffer cmd : info.command_buffers) {
+			batch.command_buffers.push_back(VkCommandBufferSubmitInfo{
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+				.commandBuffer = cmd,
+			});
+		}
+
+		for (const auto& wait : info.waits) {
+			assert(wait.queue < timelines_.size() && "TimelineScheduler: wait queue index out of range");
+			assert(wait.value <= timelines_[wait.queue]->enqueued_value.load(std::memory_order_acquire) &&
+				"TimelineScheduler: waits on points that aren't enqueued yet could deadlock the queue");
+
+			// Already completed waits only cost the device a semaphore check, but they are free to skip here
+			if (wait.value <= timelines_[wait.queue]->completed_value.load(std::memory_order_acquire)) {
+				continue;
+			}
+			batch.waits.push_back(VkSemaphoreSubmitInfo{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+				.semaphore = timelines_[wait.queue]->semaphore_handle,
+				.value = wait.value,
+				.stageMask = info.wait_stages,
+			});
+		}
+		for (usize i = 0; i < info.binary_waits.size(); ++i) {
+			batch.waits.push_back(VkSemaphoreSubmitInfo{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+				.semaphore = info.binary_waits[i],
+				.stageMask = info.binary_wait_stages[i],
+			});
+		}
+		batch.binary_waits.insert(batch.binary_waits.end(), info.binary_waits.begin(), info.binary_waits.end());
+		submit.wait_count = static_cast<u32>(batch.waits.size()) - submit.first_wait;
+
+		batch.signals.push_back(VkSemaphoreSubmitInfo{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+			.semaphore = timeline.semaphore_handle,
+			.value = value,
+			.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		});
+		for (VkSemaphore semaphore : info.binary_signals) {
+			batch.signals.push_back(VkSemaphoreSubmitInfo{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+				.semaphore = semaphore,
+				.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			});
+		}
+		batch.binary_signals.insert(batch.binary_signals.end(), info.binary_signals.begin(), info.binary_signals.end());
+		submit.signal_count = static_cast<u32>(batch.signals.size()) - submit.first_signal;
+
+		batch.submits.push_back(submit);
+		batch.last_value = value;
+		timeline.recorded_value = value;
+	}
+
+	auto TimelineScheduler::flush(u32 queue) noexcept -> std::expected<void, ErrorCode> {
+		assert(queue < timelines_.size() && "TimelineScheduler::flush(): queue index out of range");
+		return flush_(queue, 0);
+	}
+
+	auto TimelineScheduler::flush_(u32 queue, u64 visited) noexcept -> std::expected<void, ErrorCode> {
+		visited |= u64{ 1 } << queue;
+		auto& timeline = *timelines_[queue];
+
+		// VUID-vkQueueSubmit2-semaphore-03873, the signals of binary waits must reach their queues first. The signaling
+		// queues are flushed without holding a lock of this one, so two queues flushing each other can't deadlock
+		std::vector<VkSemaphore> binary_waits;
+		{
+			std::lock_guard lock{ timeline.enqueue_mutex };
+			binary_waits = timeline.pending.binary_waits;
+		}
+		if (!binary_waits.empty()) {
+			auto res = flush_signalers_(binary_waits, visited);
+			if (!res.has_value()) {
+				return res;
+			}
+		}
+
+		std::lock_guard lock{ timeline.flush_mutex };
+		return flush_locked_(timeline);
+	}
+
+	auto TimelineScheduler::flush_signalers_(std::span<const VkSemaphore> binary_waits, u64 visited) noexcept -> std::expected<void, ErrorCode> {
+		for (u32 i = 0; i < timelines_.size(); ++i) {
+			if ((visited & (u64{ 1 } << i)) != 0) {
+				continue;
+			}
+
+			bool is_signaler = false;
+			{
+				auto& timeline = *timelines_[i];
+				std::lock_guard lock{ timeline.enqueue_mutex };
+				is_signaler = std::ranges::any_of(timeline.pending.binary_signals, [binary_waits](VkSemaphore el) noexcept {
+					return std::ranges::find(binary_waits, el) != binary_waits.end();
+				});
+			}
+
+			if (is_signaler) {
+				auto res = flush_(i, visited);
+				if (!res.has_value()) {
+					return res;
+				}
+			}
+		}
+		return {};
+	}
+
+	auto TimelineScheduler::flush_locked_(QueueTimeline& timeline) noexcept -> std::expected<void, ErrorCode> {
+		{
+			// Producers only wait for the swap, not for the driver
+			std::lock_guard lock{ timeline.enqueue_mutex };
+			if (timeline.pending.submits.empty()) {
+				return {};
+			}
+			std::swap(timeline.pending, timeline.flushing);
+		}
+
+		auto& batch = timeline.flushing;
+		for (const auto& el : batch.submits) {
+			batch.infos.push_back(VkSubmitInfo2{
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+				.waitSemaphoreInfoCount = el.wait_count,
+				.pWaitSemaphoreInfos = batch.waits.data() + el.first_wait,
+				.commandBufferInfoCount = el.command_buffer_count,
+				.pCommandBufferInfos = batch.command_buffers.data() + el.first_command_buffer,
+				.signalSemaphoreInfoCount = el.signal_count,
+				.pSignalSemaphoreInfos = batch.signals.data() + el.first_signal,
+			});
+		}
+
+		VkResult res = vkQueueSubmit2(timeline.queue, static_cast<u32>(batch.infos.size()), batch.infos.data(), VK_NULL_HANDLE);
+		timeline.queue_submit_count.fetch_add(1, std::memory_order_relaxed);
+		u64 last_value = batch.last_value;
+		batch.clear();
+
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+		timeline.submitted_value.store(last_value, std::memory_order_release);
+		return {};
+	}
+
+	auto TimelineScheduler::flush() noexcept -> std::expected<void, ErrorCode> {
+		for (u32 i = 0; i < timelines_.size(); ++i) {
+			auto res = flush(i);
+			if (!res.has_value()) {
+				return res;
+			}
+		}
+		return {};
+	}
+
+	auto TimelineScheduler::submit(u32 queue, const TimelineSubmitInfo& info) noexcept -> std::expected<TimelinePoint, ErrorCode> {
+		TimelinePoint point = enqueue(queue, info);
+
+		auto res = flush(queue);
+		if (!res.has_value()) {
+			return std::unexpected(res.error());
+		}
+		return point;
+	}
+
+	auto TimelineScheduler::present(u32 queue, const VkPresentInfoKHR& info) noexcept -> std::expected<VkResult, ErrorCode> {
+		assert(queue < timelines_.size() && "TimelineScheduler::present(): queue index out of range");
+
+		// The present semaphores may also be signaled by submissions enqueued on other queues
+		auto res = flush_signalers_(std::span{ info.pWaitSemaphores, info.waitSemaphoreCount }, u64{ 1 } << queue);
+		if (!res.has_value()) {
+			return std::unexpected(res.error());
+		}
+		res = flush_(queue, 0);
+		if (!res.has_value()) {
+			return std::unexpected(res.error());
+		}
+
+		auto& timeline = *timelines_[queue];
+		std::lock_guard lock{ timeline.flush_mutex };
+
+		// The present semaphores are usually signaled by the submissions still in the batch
+		res = flush_locked_(timeline);
+		if (!res.has_value()) {
+			return std::unexpected(res.error());
+		}
+		return vkQueuePresentKHR(timeline.queue, &info);
+	}
+
+	auto TimelineScheduler::refresh_completed_(QueueTimeline& timeline) noexcept -> std::expected<u64, ErrorCode> {
+		u64 value = 0;
+		VkResult res = vkGetSemaphoreCounterValue(device_, timeline.semaphore_handle, &value);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+
+		u64 completed = timeline.completed_value.load(std::memory_order_relaxed);
+		while (completed < value && !timeline.completed_value.compare_exchange_weak(completed, value, std::memory_order_release, std::memory_order_relaxed)) {}
+		return std::max(completed, value);
+	}
+
+	auto TimelineScheduler::get_completed_value(u32 queue) noexcept -> std::expected<u64, ErrorCode> {
+		assert(queue < timelines_.size() && "TimelineScheduler::get_completed_value(): queue index out of range");
+		return refresh_completed_(*timelines_[queue]);
+	}
+
+	bool TimelineScheduler::is_complete(TimelinePoint point) noexcept {
+		assert(point.queue < timelines_.size() && "TimelineScheduler::is_complete(): queue index out of range");
+
+		auto& timeline = *timelines_[point.queue];
+		if (point.value <= timeline.completed_value.load(std::memory_order_acquire)) {
+			return true;
+		}
+
+		auto completed = refresh_completed_(timeline);
+		return completed.has_value() && point.value <= *completed;
+	}
+
+	auto TimelineScheduler::wait(std::span<const TimelinePoint> points, u64 timeout_ns, bool wait_all) noexcept -> std::expected<bool, ErrorCode> {
+		std::vector<VkSemaphore> semaphores;
+		std::vector<u64> values;
+		semaphores.reserve(points.size());
+		values.reserve(points.size());
+
+		// Enqueued work would never complete before the next sync point. A point may wait for enqueued points
+		// of any other queue, so all of them go out
+		bool needs_flush = false;
+		for (const auto& point : points) {
+			assert(point.queue < timelines_.size() && "TimelineScheduler::wait(): queue index out of range");
+			assert(point.value <= timelines_[point.queue]->enqueued_value.load(std::memory_order_acquire) &&
+				"TimelineScheduler::wait(): waits on points that aren't enqueued yet could block forever");
+			needs_flush |= point.value > timelines_[point.queue]->submitted_value.load(std::memory_order_acquire);
+		}
+		if (needs_flush) {
+			auto res = flush();
+			if (!res.has_value()) {
+				return std::unexpected(res.error());
+			}
+		}
+
+		for (const auto& point : points) {
+			if (point.value <= timelines_[point.queue]->completed_value.load(std::memory_order_acquire)) {
+				if (!wait_all) {
+					return true;
+				}
+				continue;
+			}
+			semaphores.push_back(timelines_[point.queue]->semaphore_handle);
+			values.push_back(point.value);
+		}
+
+		if (semaphores.empty()) {
+			return true;
+		}
+
+		VkSemaphoreWaitInfo wi = {
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+			.flags = wait_all ? 0u : VK_SEMAPHORE_WAIT_ANY_BIT,
+			.semaphoreCount = static_cast<u32>(semaphores.size()),
+			.pSemaphores = semaphores.data(),
+			.pValues = values.data(),
+		};
+
+		VkResult res = vkWaitSemaphores(device_, &wi, timeout_ns);
+		if (res == VK_TIMEOUT) {
+			return false;
+		}
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+
+		// Spares the next is_complete() calls on these points a device query
+		if (wait_all) {
+			for (const auto& point : points) {
+				auto& completed = timelines_[point.queue]->completed_value;
+				u64 value = completed.load(std::memory_order_relaxed);
+				while (value < point.value && !completed.compare_exchange_weak(value, point.value, std::memory_order_release, std::memory_order_relaxed)) {}
+			}
+		}
+		return true;
+	}
+
+	auto TimelineScheduler::wait_idle() noexcept -> std::expected<void, ErrorCode> {
+		// Reserved values may never be recorded and a failed flush drops its batch, only submitted points are sure
+		// to signal. What did reach the queues is waited for even if the flush fails
+		auto flushed = flush();
+
+		std::vector<TimelinePoint> points;
+		points.reserve(timelines_.size());
+		for (u32 i = 0; i < timelines_.size(); ++i) {
+			points.push_back(get_last_submitted(i));
+		}
+
+		auto res = wait(points);
+		if (!res.has_value()) {
+			return std::unexpected(res.error());
+		}
+		return flushed;
+	}
+
+	void TimelineScheduler::retire(TimelinePoint point, RetireCallback callback) noexcept {
+		assert(point.queue < timelines_.size() && "TimelineScheduler::retire(): queue index out of range");
+
+		auto& timeline = *timelines_[point.queue];
+		std::lock_guard lock{ timeline.retire_mutex };
+
+		// Usually retires the latest point, so this is an append
+		auto it = std::ranges::upper_bound(timeline.retirements, point.value, {}, &Retirement::value);
+		timeline.retirements.insert(it, Retirement{ point.value, std::move(callback) });
+	}
+
+	usize TimelineScheduler::collect() noexcept {
+		usize count = 0;
+		std::vector<RetireCallback> completed;
+
+		for (auto& timeline : timelines_) {
+			{
+				std::lock_guard lock{ timeline->retire_mutex };
+				if (timeline->retirements.empty()) {
+					continue;
+				}
+
+				u64 value = timeline->completed_value.load(std::memory_order_acquire);
+				if (timeline->retirements.front().value > value) {
+					value = refresh_completed_(*timeline).value_or(value);
+				}
+
+				while (!timeline->retirements.empty() && timeline->retirements.front().value <= value) {
+					completed.push_back(std::move(timeline->retirements.front().callback));
+					timeline->retirements.pop_front();
+				}
+			}
+
+			// Outside of the lock, callbacks may retire more work
+			for (auto& callback : completed) {
+				callback();
+			}
+			count += completed.size();
+			completed.clear();
+		}
+		return count;
+	}
+
+	SubmitStats TimelineScheduler::get_stats() const noexcept {
+		SubmitStats ret;
+		for (const auto& timeline : timelines_) {
+			ret.submission_count += timeline->submission_count.load(std::memory_order_relaxed);
+			ret.queue_submit_count += timeline->queue_submit_count.load(std::memory_order_relaxed);
+		}
+		return ret;
+	}
+
+	void TimelineScheduler::reset_stats() noexcept {
+		for (auto& timeline : timelines_) {
+			timeline->submission_count.store(0, std::memory_order_relaxed);
+			timeline->queue_submit_count.store(0, std::memory_order_relaxed);
+		}
+	}
+}
@@ -0,0 +1,583 @@
+#include <sparse.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <ranges>
+
+namespace gx {
+	namespace {
+		[[nodiscard]]
+		constexpr u32 div_up(u32 value, u32 divisor) noexcept {
+			return (value + divisor - 1) / divisor;
+		}
+
+		/*
+		* Extends the last bind pushed since first if bind continues it in the resource and in memory.
+		* Unbinds only need to continue in the resource.
+		*/
+		void push_memory_bind(std::vector<VkSparseMemoryBind>& binds, usize first, const VkSparseMemoryBind& bind) noexcept {
+			if (binds.size() > first) {
+				auto& last = binds.back();
+				bool continues = last.flags == bind.flags &&
+					last.memory == bind.memory &&
+					last.resourceOffset + last.size == bind.resourceOffset &&
+					(bind.memory == VK_NULL_HANDLE || last.memoryOffset + last.size == bind.memoryOffset);
+
+				if (continues) {
+					last.size += bind.size;
+					return;
+				}
+			}
+			binds.push_back(bind);
+		}
+
+		/*
+		* Only unbinds are merged, the memory layout of a bind spanning several tiles is up to the implementation.
+		*/
+		void push_image_bind(std::vector<VkSparseImageMemoryBind>& binds, usize first, const VkSparseImageMemoryBind& bind) noexcept {
+			if (binds.size() > first && bind.memory == VK_NULL_HANDLE) {
+				auto& last = binds.back();
+				bool continues = last.memory == VK_NULL_HANDLE &&
+					last.subresource.aspectMask == bind.subresource.aspectMask &&
+					last.subresource.mipLevel == bind.subresource.mipLevel &&
+					last.subresource.arrayLayer == bind.subresource.arrayLayer &&
+					last.offset.y == bind.offset.y &&
+					last.offset.z == bind.offset.z &&
+					last.extent.height == bind.extent.height &&
+					last.extent.depth == bind.extent.depth &&
+					last.offset.x + static_cast<i32>(last.extent.width) == bind.offset.x;
+
+				if (continues) {
+					last.extent.width += bind.extent.width;
+					return;
+				}
+			}
+			binds.push_back(bind);
+		}
+	}
+
+	auto SparseResidencyManager::find_pool_(u32 memory_type_bits, usize page_size) noexcept -> std::expected<u32, ErrorCode> {
+		auto memory_type = allocator_->find_memory_type(memory_type_bits, MemoryUsage::eGpuOnly);
+		if (!memory_type.has_value()) {
+			return std::unexpected(ErrorCode::eMemoryTypeNotPresent);
+		}
+
+		for (auto [i, pool] : std::views::zip(std::views::iota(0u), pools_)) {
+			if (pool.memory_type == *memory_type && pool.page_size == page_size) {
+				return i;
+			}
+		}
+
+		auto& pool = pools_.emplace_back();
+		pool.memory_type = *memory_type;
+		pool.page_size = page_size;
+		return static_cast<u32>(pools_.size() - 1);
+	}
+
+	auto SparseResidencyManager::alloc_page_(u32 pool_index) noexcept -> std::expected<Page, ErrorCode> {
+		auto& pool = pools_[pool_index];
+
+		if (pool.free_pages.empty()) {
+			AllocationDesc desc{
+				.size = pool.page_size * config_.pages_per_chunk,
+				.alignment = pool.page_size,
+				.memory_type_bits = 1u << pool.memory_type,
+				.usage = MemoryUsage::eGpuOnly,
+			};
+
+			auto chunk = allocator_->allocate(desc);
+			if (!chunk.has_value()) {
+				return std::unexpected(chunk.error());
+			}
+
+			// Lowest offsets are handed out first, so consecutive commits get contiguous memory
+			for (u32 i : std::views::iota(0u, config_.pages_per_chunk) | std::views::reverse) {
+				pool.free_pages.push_back(Page{ chunk->get_handle(), chunk->get_offset() + i * pool.page_size });
+			}
+			pool.chunks.push_back(std::move(*chunk).to_owned<MoveOnlyTag, ViewableTag>());
+			++stats_.chunk_count;
+		}
+
+		Page page = pool.free_pages.back();
+		pool.free_pages.pop_back();
+
+		++stats_.committed_pages;
+		stats_.committed_bytes += pool.page_size;
+		return page;
+	}
+
+	void SparseResidencyManager::free_page_(u32 pool_index, Page& page) noexcept {
+		auto& pool = pools_[pool_index];
+		pool.free_pages.push_back(page);
+		page = Page{};
+
+		--stats_.committed_pages;
+		stats_.committed_bytes -= pool.page_size;
+	}
+
+	auto SparseResidencyManager::commit_page_(Resource& resource, usize index) noexcept -> std::expected<void, ErrorCode> {
+		auto& page = resource.pages[index];
+		if (page.memory != VK_NULL_HANDLE) {
+			return {};
+		}
+
+		auto new_page = alloc_page_(resource.pool_index);
+		if (!new_page.has_value()) {
+			return std::unexpected(new_page.error());
+		}
+		page = *new_page;
+
+		resource.dirty.push_back(index);
+		++stats_.requested_binds;
+		return {};
+	}
+
+	void SparseResidencyManager::decommit_page_(Resource& resource, usize index) noexcept {
+		auto& page = resource.pages[index];
+		if (page.memory == VK_NULL_HANDLE) {
+			return;
+		}
+		free_page_(resource.pool_index, page);
+
+		resource.dirty.push_back(index);
+		++stats_.requested_binds;
+	}
+
+	SparseResourceId SparseResidencyManager::push_resource_(Resource&& resource) noexcept {
+		u32 index = 0;
+		if (!free_indices_.empty()) {
+			index = free_indices_.back();
+			free_indices_.pop_back();
+		}
+		else {
+			index = static_cast<u32>(resources_.size());
+			resources_.emplace_back();
+		}
+
+		resource.generation = resources_[index].generation;
+		resource.is_alive = true;
+		resources_[index] = std::move(resource);
+		return SparseResourceId{ index, resources_[index].generation };
+	}
+
+	VkExtent3D SparseResidencyManager::get_mip_tile_count_(const Resource& resource, u32 mip) const noexcept {
+		return VkExtent3D{
+			div_up(std::max(resource.extent.width >> mip, 1u), resource.tile_extent.width),
+			div_up(std::max(resource.extent.height >> mip, 1u), resource.tile_extent.height),
+			div_up(std::max(resource.extent.depth >> mip, 1u), resource.tile_extent.depth),
+		};
+	}
+
+	usize SparseResidencyManager::get_tile_index_(const Resource& resource, u32 layer, u32 mip, u32 x, u32 y, u32 z) const noexcept {
+		auto count = get_mip_tile_count_(resource, mip);
+		assert(x < count.width && y < count.height && z < count.depth && "SparseResidencyManager: tile is out of range");
+		return layer * resource.layer_stride + resource.mip_offsets[mip] + (static_cast<usize>(z) * count.height + y) * count.width + x;
+	}
+
+	auto SparseResidencyManager::add_image(ImageView image, const ImageBuilder& desc) noexcept -> std::expected<SparseResourceId, ErrorCode> {
+		VkDevice device = allocator_->get_device();
+
+		VkMemoryRequirements reqs{};
+		vkGetImageMemoryRequirements(device, image.get_handle(), &reqs);
+
+		u32 sparse_reqs_count = 0;
+		vkGetImageSparseMemoryRequirements(device, image.get_handle(), &sparse_reqs_count, nullptr);
+		std::vector<VkSparseImageMemoryRequirements> sparse_reqs(sparse_reqs_count);
+		vkGetImageSparseMemoryRequirements(device, image.get_handle(), &sparse_reqs_count, sparse_reqs.data());
+
+		auto is_metadata = [](const VkSparseImageMemoryRequirements& el) noexcept {
+			return test_bit(el.formatProperties.aspectMask, VK_IMAGE_ASPECT_METADATA_BIT);
+		};
+		auto tiled_reqs = sparse_reqs | std::views::filter(std::not_fn(is_metadata));
+		if (tiled_reqs.begin() == tiled_reqs.end()) {
+			return std::unexpected(ErrorCode::eFeatureNotPresent);
+		}
+		// Formats with separately bound depth and stencil aspects aren't supported
+		assert(std::ranges::distance(tiled_reqs) == 1 && "SparseResidencyManager::add_image(): only images with a single tiled aspect are supported");
+		const auto& tiled_req = *tiled_reqs.begin();
+
+		std::lock_guard lock{ mutex_ };
+
+		auto pool_index = find_pool_(reqs.memoryTypeBits, reqs.alignment);
+		if (!pool_index.has_value()) {
+			return std::unexpected(pool_index.error());
+		}
+
+		Resource resource;
+		resource.image = image.get_handle();
+		resource.size = reqs.size;
+		resource.pool_index = *pool_index;
+		resource.aspect = tiled_req.formatProperties.aspectMask;
+		resource.extent = VkExtent3D{ desc.get_extent().width, desc.get_extent().height, desc.get_depth() };
+		resource.tile_extent = tiled_req.formatProperties.imageGranularity;
+		resource.tiled_mip_count = std::min(tiled_req.imageMipTailFirstLod, desc.get_mip_levels());
+		resource.layer_count = desc.get_array_layers();
+
+		resource.mip_offsets.push_back(0);
+		for (u32 mip : std::views::iota(0u, resource.tiled_mip_count)) {
+			auto count = get_mip_tile_count_(resource, mip);
+			resource.mip_offsets.push_back(resource.mip_offsets.back() + static_cast<usize>(count.width) * count.height * count.depth);
+		}
+		resource.layer_stride = resource.mip_offsets.back();
+		resource.pages.resize(resource.layer_stride * resource.layer_count);
+
+		// Mip tails of the tiled aspect and the metadata are bound as opaque ranges and stay resident
+		usize page_size = reqs.alignment;
+		for (const auto& el : sparse_reqs) {
+			if (el.imageMipTailFirstLod >= desc.get_mip_levels() || el.imageMipTailSize == 0) {
+				continue;
+			}
+
+			bool is_single = test_bit(el.formatProperties.flags, VK_SPARSE_IMAGE_FORMAT_SINGLE_MIPTAIL_BIT);
+			u32 tail_count = is_single ? 1 : resource.layer_count;
+			VkSparseMemoryBindFlags flags = is_metadata(el) ? VK_SPARSE_MEMORY_BIND_METADATA_BIT : 0;
+
+			for (u32 tail : std::views::iota(0u, tail_count)) {
+				for (usize offset = 0; offset < el.imageMipTailSize; offset += page_size) {
+					auto page = alloc_page_(resource.pool_index);
+					if (!page.has_value()) {
+						for (auto& tail_page : resource.tail_pages) {
+							free_page_(resource.pool_index, tail_page);
+						}
+						return std::unexpected(page.error());
+					}
+					resource.tail_pages.push_back(*page);
+
+					push_memory_bind(resource.pending_opaque, 0, VkSparseMemoryBind{
+						.resourceOffset = el.imageMipTailOffset + tail * el.imageMipTailStride + offset,
+						.size = std::min<usize>(page_size, el.imageMipTailSize - offset),
+						.memory = page->memory,
+						.memoryOffset = page->offset,
+						.flags = flags,
+					});
+					++stats_.requested_binds;
+				}
+			}
+		}
+
+		return push_resource_(std::move(resource));
+	}
+
+	auto SparseResidencyManager::add_buffer(BufferView buffer) noexcept -> std::expected<SparseResourceId, ErrorCode> {
+		VkMemoryRequirements reqs{};
+		vkGetBufferMemoryRequirements(allocator_->get_device(), buffer.get_handle(), &reqs);
+
+		std::lock_guard lock{ mutex_ };
+
+		auto pool_index = find_pool_(reqs.memoryTypeBits, reqs.alignment);
+		if (!pool_index.has_value()) {
+			return std::unexpected(pool_index.error());
+		}
+
+		Resource resource;
+		resource.buffer = buffer.get_handle();
+		resource.size = reqs.size;
+		resource.pool_index = *pool_index;
+		resource.pages.resize((reqs.size + reqs.alignment - 1) / reqs.alignment);
+
+		return push_resource_(std::move(resource));
+	}
+
+	void SparseResidencyManager::remove(SparseResourceId id) noexcept {
+		std::lock_guard lock{ mutex_ };
+
+		auto* resource = find_(id);
+		if (resource == nullptr) {
+			return;
+		}
+
+		for (auto& page : resource->pages) {
+			if (page.memory != VK_NULL_HANDLE) {
+				free_page_(resource->pool_index, page);
+			}
+		}
+		for (auto& page : resource->tail_pages) {
+			free_page_(resource->pool_index, page);
+		}
+
+		u32 generation = resource->generation;
+		*resource = Resource{};
+		// Outstanding ids of this slot become stale
+		resource->generation = generation + 1;
+		free_indices_.push_back(id.index);
+	}
+
+	auto SparseResidencyManager::commit(SparseResourceId id, SparseTileRegion region) noexcept -> std::expected<void, ErrorCode> {
+		std::lock_guard lock{ mutex_ };
+
+		auto* resource = find_(id);
+		if (resource == nullptr) {
+			return {};
+		}
+		assert(resource->image != VK_NULL_HANDLE && "SparseResidencyManager::commit(): resource is not an image");
+		assert(region.mip_level < resource->tiled_mip_count && region.array_layer < resource->layer_count && "SparseResidencyManager::commit(): region is out of range");
+
+		for (u32 z : std::views::iota(region.z, region.z + region.depth)) {
+			for (u32 y : std::views::iota(region.y, region.y + region.height)) {
+				for (u32 x : std::views::iota(region.x, region.x + region.width)) {
+					auto res = commit_page_(*resource, get_tile_index_(*resource, region.array_layer, region.mip_level, x, y, z));
+					if (!res.has_value()) {
+						return res;
+					}
+				}
+			}
+		}
+		return {};
+	}
+
+	void SparseResidencyManager::decommit(SparseResourceId id, SparseTileRegion region) noexcept {
+		std::lock_guard lock{ mutex_ };
+
+		auto* resource = find_(id);
+		if (resource == nullptr) {
+			return;
+		}
+		assert(resource->image != VK_NULL_HANDLE && "SparseResidencyManager::decommit(): resource is not an image");
+		assert(region.mip_level < resource->tiled_mip_count && region.array_layer < resource->layer_count && "SparseResidencyManager::decommit(): region is out of range");
+
+		for (u32 z : std::views::iota(region.z, region.z + region.depth)) {
+			for (u32 y : std::views::iota(region.y, region.y + region.height)) {
+				for (u32 x : std::views::iota(region.x, region.x + region.width)) {
+					decommit_page_(*resource, get_tile_index_(*resource, region.array_layer, region.mip_level, x, y, z));
+				}
+			}
+		}
+	}
+
+	auto SparseResidencyManager::commit_range(SparseResourceId id, usize offset, usize size) noexcept -> std::expected<void, ErrorCode> {
+		std::lock_guard lock{ mutex_ };
+
+		auto* resource = find_(id);
+		if (resource == nullptr) {
+			return {};
+		}
+		assert(resource->buffer != VK_NULL_HANDLE && "SparseResidencyManager::commit_range(): resource is not a buffer");
+		assert(offset + size <= resource->size && "SparseResidencyManager::commit_range(): range is out of range");
+
+		usize page_size = pools_[resource->pool_index].page_size;
+		usize first = offset / page_size;
+		usize last = (offset + size + page_size - 1) / page_size;
+
+		for (usize i : std::views::iota(first, last)) {
+			auto res = commit_page_(*resource, i);
+			if (!res.has_value()) {
+				return res;
+			}
+		}
+		return {};
+	}
+
+	void SparseResidencyManager::decommit_range(SparseResourceId id, usize offset, usize size) noexcept {
+		std::lock_guard lock{ mutex_ };
+
+		auto* resource = find_(id);
+		if (resource == nullptr) {
+			return;
+		}
+		assert(resource->buffer != VK_NULL_HANDLE && "SparseResidencyManager::decommit_range(): resource is not a buffer");
+
+		usize page_size = pools_[resource->pool_index].page_size;
+		usize first = (offset + page_size - 1) / page_size;
+		usize last = std::min((offset + size) / page_size, resource->pages.size());
+
+		for (usize i : std::views::iota(first, std::max(first, last))) {
+			decommit_page_(*resource, i);
+		}
+	}
+
+	bool SparseResidencyManager::is_committed(SparseResourceId id, SparseTileRegion region) noexcept {
+		std::lock_guard lock{ mutex_ };
+
+		auto* resource = find_(id);
+		if (resource == nullptr || region.mip_level >= resource->tiled_mip_count) {
+			return resource != nullptr;
+		}
+
+		for (u32 z : std::views::iota(region.z, region.z + region.depth)) {
+			for (u32 y : std::views::iota(region.y, region.y + region.height)) {
+				for (u32 x : std::views::iota(region.x, region.x + region.width)) {
+					if (resource->pages[get_tile_index_(*resource, region.array_layer, region.mip_level, x, y, z)].memory == VK_NULL_HANDLE) {
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	VkExtent3D SparseResidencyManager::get_tile_extent(SparseResourceId id) noexcept {
+		std::lock_guard lock{ mutex_ };
+
+		auto* resource = find_(id);
+		return resource != nullptr ? resource->tile_extent : VkExtent3D{};
+	}
+
+	VkExtent3D SparseResidencyManager::get_tile_count(SparseResourceId id, u32 mip_level) noexcept {
+		std::lock_guard lock{ mutex_ };
+
+		auto* resource = find_(id);
+		if (resource == nullptr || mip_level >= resource->tiled_mip_count) {
+			return VkExtent3D{};
+		}
+		return get_mip_tile_count_(*resource, mip_level);
+	}
+
+	auto SparseResidencyManager::flush(const SparseFlushInfo& info) noexcept -> std::expected<void, ErrorCode> {
+		assert((info.wait_values.empty() || info.wait_values.size() == info.wait_semaphores.size()) && "SparseResidencyManager::flush(): wait value count must match the semaphore count");
+		assert((info.signal_values.empty() || info.signal_values.size() == info.signal_semaphores.size()) && "SparseResidencyManager::flush(): signal value count must match the semaphore count");
+
+		std::lock_guard lock{ mutex_ };
+
+		// Infos point into the bind arrays only after all binds are pushed, until then pBinds holds the first index
+		std::vector<VkSparseMemoryBind> memory_binds;
+		std::vector<VkSparseImageMemoryBind> image_binds;
+		std::vector<VkSparseBufferMemoryBindInfo> buffer_infos;
+		std::vector<VkSparseImageOpaqueMemoryBindInfo> opaque_infos;
+		std::vector<VkSparseImageMemoryBindInfo> image_infos;
+		std::vector<usize> buffer_firsts;
+		std::vector<usize> opaque_firsts;
+		std::vector<usize> image_firsts;
+
+		for (auto& resource : resources_ | std::views::filter(&Resource::is_alive)) {
+			if (!resource.pending_opaque.empty()) {
+				opaque_firsts.push_back(memory_binds.size());
+				opaque_infos.push_back(VkSparseImageOpaqueMemoryBindInfo{
+					.image = resource.image,
+					.bindCount = static_cast<u32>(resource.pending_opaque.size()),
+				});
+				memory_binds.insert(memory_binds.end(), resource.pending_opaque.begin(), resource.pending_opaque.end());
+			}
+
+			if (resource.dirty.empty()) {
+				continue;
+			}
+			// Sorted page indices give runs of consecutive pages and row-ordered tiles
+			std::ranges::sort(resource.dirty);
+			auto [dup_first, dup_last] = std::ranges::unique(resource.dirty);
+			resource.dirty.erase(dup_first, dup_last);
+
+			usize page_size = pools_[resource.pool_index].page_size;
+
+			if (resource.buffer != VK_NULL_HANDLE) {
+				usize first = memory_binds.size();
+				for (usize index : resource.dirty) {
+					const auto& page = resource.pages[index];
+					usize offset = index * page_size;
+
+					push_memory_bind(memory_binds, first, VkSparseMemoryBind{
+						.resourceOffset = offset,
+						.size = std::min(page_size, resource.size - offset),
+						.memory = page.memory,
+						.memoryOffset = page.offset,
+					});
+				}
+
+				buffer_firsts.push_back(first);
+				buffer_infos.push_back(VkSparseBufferMemoryBindInfo{
+					.buffer = resource.buffer,
+					.bindCount = static_cast<u32>(memory_binds.size() - first),
+				});
+				continue;
+			}
+
+			usize first = image_binds.size();
+			for (usize index : resource.dirty) {
+				const auto& page = resource.pages[index];
+
+				u32 layer = static_cast<u32>(index / resource.layer_stride);
+				usize local = index % resource.layer_stride;
+				u32 mip = static_cast<u32>(std::ranges::upper_bound(resource.mip_offsets, local) - resource.mip_offsets.begin() - 1);
+				local -= resource.mip_offsets[mip];
+
+				auto count = get_mip_tile_count_(resource, mip);
+				u32 x = static_cast<u32>(local % count.width);
+				u32 y = static_cast<u32>(local / count.width % count.height);
+				u32 z = static_cast<u32>(local / (static_cast<usize>(count.width) * count.height));
+
+				// Tiles on the right and bottom edges only cover the rest of the mip level
+				const auto& tile = resource.tile_extent;
+				VkExtent3D mip_extent{
+					std::max(resource.extent.width >> mip, 1u),
+					std::max(resource.extent.height >> mip, 1u),
+					std::max(resource.extent.depth >> mip, 1u),
+				};
+
+				push_image_bind(image_binds, first, VkSparseImageMemoryBind{
+					.subresource = VkImageSubresource{ resource.aspect, mip, layer },
+					.offset = VkOffset3D{
+						static_cast<i32>(x * tile.width),
+						static_cast<i32>(y * tile.height),
+						static_cast<i32>(z * tile.depth),
+					},
+					.extent = VkExtent3D{
+						std::min(tile.width, mip_extent.width - x * tile.width),
+						std::min(tile.height, mip_extent.height - y * tile.height),
+						std::min(tile.depth, mip_extent.depth - z * tile.depth),
+					},
+					.memory = page.memory,
+					.memoryOffset = page.offset,
+				});
+			}
+
+			image_firsts.push_back(first);
+			image_infos.push_back(VkSparseImageMemoryBindInfo{
+				.image = resource.image,
+				.bindCount = static_cast<u32>(image_binds.size() - first),
+			});
+		}
+
+		bool has_sync = !info.wait_semaphores.empty() || !info.signal_semaphores.empty() || info.fence != VK_NULL_HANDLE;
+		if (memory_binds.empty() && image_binds.empty() && !has_sync) {
+			return {};
+		}
+
+		for (auto [bind_info, first] : std::views::zip(buffer_infos, buffer_firsts)) {
+			bind_info.pBinds = memory_binds.data() + first;
+		}
+		for (auto [bind_info, first] : std::views::zip(opaque_infos, opaque_firsts)) {
+			bind_info.pBinds = memory_binds.data() + first;
+		}
+		for (auto [bind_info, first] : std::views::zip(image_infos, image_firsts)) {
+			bind_info.pBinds = image_binds.data() + first;
+		}
+
+		VkTimelineSemaphoreSubmitInfo timeline_info = {
+			.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+			.waitSemaphoreValueCount = static_cast<u32>(info.wait_values.size()),
+			.pWaitSemaphoreValues = info.wait_values.data(),
+			.signalSemaphoreValueCount = static_cast<u32>(info.signal_values.size()),
+			.pSignalSemaphoreValues = info.signal_values.data(),
+		};
+		bool has_timeline = !info.wait_values.empty() || !info.signal_values.empty();
+
+		VkBindSparseInfo bind_info = {
+			.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+			.pNext = has_timeline ? &timeline_info : nullptr,
+			.waitSemaphoreCount = static_cast<u32>(info.wait_semaphores.size()),
+			.pWaitSemaphores = info.wait_semaphores.data(),
+			.bufferBindCount = static_cast<u32>(buffer_infos.size()),
+			.pBufferBinds = buffer_infos.data(),
+			.imageOpaqueBindCount = static_cast<u32>(opaque_infos.size()),
+			.pImageOpaqueBinds = opaque_infos.data(),
+			.imageBindCount = static_cast<u32>(image_infos.size()),
+			.pImageBinds = image_infos.data(),
+			.signalSemaphoreCount = static_cast<u32>(info.signal_semaphores.size()),
+			.pSignalSemaphores = info.signal_semaphores.data(),
+		};
+
+		// Changes stay queued on failure, so the next flush retries them
+		VkResult res = vkQueueBindSparse(queue_, 1, &bind_info, info.fence);
+		if (res != VK_SUCCESS) {
+			return std::unexpected(convert_vk_result(res));
+		}
+
+		for (auto& resource : resources_) {
+			resource.dirty.clear();
+			resource.pending_opaque.clear();
+		}
+		stats_.submitted_binds += memory_binds.size() + image_binds.size();
+		++stats_.bind_calls;
+
+		return {};
+	}
+}
@@ -0,0 +1,147 @@
+#include <staging.hpp>
+
+#include <algorithm>
+
+namespace gx {
+	StagingRing::StagingRing(StagingRing&& rhs) noexcept
+		: allocation_{ std::move(rhs.allocation_) }
+		, buffer_{ std::move(rhs.buffer_) }
+		, buffer_handle_{ std::exchange(rhs.buffer_handle_, VK_NULL_HANDLE) }
+		, base_{ std::exchange(rhs.base_, nullptr) }
+		, capacity_{ std::exchange(rhs.capacity_, 0) }
+		, alignment_{ rhs.alignment_ }
+		, head_{ rhs.head_.load(std::memory_order_relaxed) }
+		, tail_{ rhs.tail_.load(std::memory_order_relaxed) }
+		, submissions_{ std::move(rhs.submissions_) }
+	{}
+
+	auto StagingRing::create(Allocator& allocator, StagingRingConfig config) noexcept -> std::expected<StagingRing, ErrorCode> {
+		usize capacity = align_up(config.size, kb_to_bytes(64));
+
+		auto buffer = BufferBuilder{ allocator.get_device() }
+			.with_size(capacity)
+			.with_usage(std::to_underlying(BufferUsage::eTransferSrc))
+			.build();
+
+		if (!buffer.has_value()) {
+			return std::unexpected(buffer.error());
+		}
+
+		auto allocation = allocator.allocate_for_buffer(buffer->get_handle(), MemoryUsage::eCpuOnly);
+		if (!allocation.has_value()) {
+			std::move(*buffer).destroy();
+			return std::unexpected(allocation.error());
+		}
+
+		StagingRing ret{};
+		ret.buffer_handle_ = buffer->get_handle();
+		ret.base_ = static_cast<u8*>(allocation->get_mapped_ptr());
+		ret.capacity_ = capacity;
+		ret.alignment_ = config.alignment;
+		ret.buffer_ = std::move(*buffer).to_owned<MoveOnlyTag, ViewableTag>();
+		ret.allocation_ = std::move(*allocation).to_owned<MoveOnlyTag, ViewableTag>();
+
+		return ret;
+	}
+
+	std::optional<StagingRegion> StagingRing::allocate(usize size, usize alignment) noexcept {
+		if (size > capacity_) {
+			return std::nullopt;
+		}
+		alignment = std::max(alignment, alignment_);
+
+		u64 head = head_.load(std::memory_order_relaxed);
+		for (;;) {
+			u64 begin = align_up(head, alignment);
+
+			// A region never wraps around the end of the buffer, the tail is skipped instead
+			usize phys = static_cast<usize>(begin % capacity_);
+			if (phys + size > capacity_) {
+				begin += capacity_ - phys;
+			}
+			u64 end = begin + size;
+
+			if (end - tail_.load(std::memory_order_acquire) > capacity_) {
+				return std::nullopt;
+			}
+
+			if (head_.compare_exchange_weak(head, end, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+				usize offset = static_cast<usize>(begin % capacity_);
+				return StagingRegion{
+					.buffer = buffer_handle_,
+					.offset = offset,
+					.size = size,
+					.mapped = base_ + offset,
+					.ticket = StagingTicket{ head, end },
+				};
+			}
+		}
+	}
+
+	void StagingRing::record_copy(VkCommandBuffer cmd, const StagingRegion& region, BufferView dst, usize dst_offset) noexcept {
+		VkBufferCopy copy = {
+			.srcOffset = region.offset,
+			.dstOffset = dst_offset,
+			.size = region.size,
+		};
+		vkCmdCopyBuffer(cmd, region.buffer, dst.get_handle(), 1, &copy);
+	}
+
+	void StagingRing::record_copy(VkCommandBuffer cmd, const StagingRegion& region, ImageView dst, ImageLayout layout, Extent2D extent, ImageSubresourceRange range) noexcept {
+		VkBufferImageCopy copy = {
+			.bufferOffset = region.offset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = VkImageSubresourceLayers{
+				.aspectMask = image_aspect_flags_to_vk(range.aspect_mask),
+				.mipLevel = range.base_mip_level,
+				.baseArrayLayer = range.base_array_layer,
+				.layerCount = range.layer_count,
+			},
+			.imageOffset = VkOffset3D{ 0, 0, 0 },
+			.imageExtent = VkExtent3D{ extent.width, extent.height, 1 },
+		};
+		vkCmdCopyBufferToImage(cmd, region.buffer, dst.get_handle(), image_layout_to_vk(layout), 1, &copy);
+	}
+
+	void StagingRing::submit(u64 retire_value, std::span<const StagingTicket> tickets) noexcept {
+		std::lock_guard lock{ submissions_mutex_ };
+		for (const auto& ticket : tickets) {
+			assert(ticket.begin >= tail_.load(std::memory_order_relaxed) && ticket.end <= head_.load(std::memory_order_relaxed) &&
+				"StagingRing::submit(): ticket doesn't belong to a live region of the ring");
+			[[maybe_unused]] bool is_inserted = submissions_.try_emplace(ticket.begin, Submission{ ticket.end, retire_value }).second;
+			assert(is_inserted && "StagingRing::submit(): region is submitted twice");
+		}
+	}
+
+	void StagingRing::retire(u64 completed_value) noexcept {
+		std::lock_guard lock{ submissions_mutex_ };
+
+		// Regions tile the ring, the tail moves on only while the region starting at it has completed
+		bool has_retired = false;
+		u64 tail = tail_.load(std::memory_order_relaxed);
+		for (auto it = submissions_.begin(); it != submissions_.end() && it->first == tail && it->second.retire_value <= completed_value;) {
+			tail = it->second.end;
+			it = submissions_.erase(it);
+			has_retired = true;
+		}
+
+		if (has_retired) {
+			tail_.store(tail, std::memory_order_release);
+			tail_.notify_all();
+		}
+	}
+
+	std::optional<u64> StagingRing::get_retire_value(StagingTicket ticket) noexcept {
+		std::lock_guard lock{ submissions_mutex_ };
+		if (is_retired(ticket)) {
+			return std::nullopt;
+		}
+
+		auto it = submissions_.find(ticket.begin);
+		if (it == submissions_.end()) {
+			return std::nullopt;
+		}
+		return it->second.retire_value;
+	}
+}
@@ -0,0 +1,142 @@
+#include <submit_thread.hpp>
+
+#include <algorithm>
+
+namespace gx {
+	QueueSubmitThread::QueueSubmitThread(TimelineScheduler& scheduler, u32 queue) noexcept
+		: scheduler_{ &scheduler }
+		, queue_{ queue }
+		, next_value_{ scheduler.get_last_enqueued(queue).value + 1 }
+		, worker_{ [this] { worker_loop_(); } }
+	{
+		assert(queue < scheduler.get_queue_count() && "QueueSubmitThread: queue index out of range");
+	}
+
+	QueueSubmitThread::~QueueSubmitThread() noexcept {
+		is_stopping_.store(true, std::memory_order_release);
+		epoch_.fetch_add(1, std::memory_order_release);
+		epoch_.notify_one();
+		worker_.join();
+	}
+
+	TimelinePoint QueueSubmitThread::submit(const TimelineSubmitInfo& info) noexcept {
+		auto* packet = new Packet{};
+		packet->type = PacketType::eSubmit;
+		packet->command_buffers.assign(info.command_buffers.begin(), info.command_buffers.end());
+		packet->waits.assign(info.waits.begin(), info.waits.end());
+		packet->wait_stages = info.wait_stages;
+		packet->binary_waits.assign(info.binary_waits.begin(), info.binary_waits.end());
+		packet->binary_wait_stages.assign(info.binary_wait_stages.begin(), info.binary_wait_stages.end());
+		packet->binary_signals.assign(info.binary_signals.begin(), info.binary_signals.end());
+
+		TimelinePoint point = scheduler_->reserve(queue_);
+		packet->value = point.value;
+		push_(packet);
+
+		return point;
+	}
+
+	std::future<std::expected<VkResult, ErrorCode>> QueueSubmitThread::present(VkSwapchainKHR swapchain, u32 image_index, std::span<const VkSemaphore> waits) noexcept {
+		auto* packet = new Packet{};
+		packet->type = PacketType::ePresent;
+		packet->swapchain = swapchain;
+		packet->image_index = image_index;
+		packet->binary_waits.assign(waits.begin(), waits.end());
+
+		// Submits of this thread reserved their values before, so they are ordered before the present
+		packet->value = scheduler_->get_last_enqueued(queue_).value;
+		auto ret = packet->present_result.get_future();
+		push_(packet);
+
+		return ret;
+	}
+
+	void QueueSubmitThread::push_(Packet* packet) noexcept {
+		packets_.push(packet);
+
+		// The worker reads the epoch before looking for packets, so it can't sleep through this
+		epoch_.fetch_add(1, std::memory_order_release);
+		epoch_.notify_one();
+	}
+
+	void QueueSubmitThread::worker_loop_() noexcept {
+		for (;;) {
+			u32 epoch = epoch_.load(std::memory_order_acquire);
+			bool is_stopping = is_stopping_.load(std::memory_order_acquire);
+
+			if (process_()) {
+				continue;
+			}
+			if (is_stopping && submits_.empty() && presents_.empty()) {
+				return;
+			}
+			epoch_.wait(epoch, std::memory_order_acquire);
+		}
+	}
+
+	bool QueueSubmitThread::process_() noexcept {
+		bool did_work = false;
+
+		while (details::MpscNode* node = packets_.pop()) {
+			std::unique_ptr<Packet> packet{ static_cast<Packet*>(node) };
+			if (packet->type == PacketType::ePresent) {
+				// Presents keep the order they were pushed in
+				presents_.push_back(std::move(packet));
+				continue;
+			}
+
+			// Usually in order already, so this is an append
+			auto it = std::ranges::upper_bound(submits_, packet->value, {}, [](const auto& el) noexcept { return el->value; });
+			submits_.insert(it, std::move(packet));
+		}
+
+		// A gap means a producer has reserved a value but not pushed its packet yet
+		bool has_recorded = false;
+		while (!submits_.empty() && submits_.front()->value == next_value_) {
+			const auto& packet = *submits_.front();
+			scheduler_->enqueue_reserved(
+				TimelinePoint{ queue_, packet.value },
+				TimelineSubmitInfo{
+					.command_buffers = packet.command_buffers,
+					.waits = packet.waits,
+					.wait_stages = packet.wait_stages,
+					.binary_waits = packet.binary_waits,
+					.binary_wait_stages = packet.binary_wait_stages,
+					.binary_signals = packet.binary_signals,
+				}
+			);
+			submits_.pop_front();
+			++next_value_;
+			has_recorded = true;
+		}
+
+		if (has_recorded) {
+			auto res = scheduler_->flush(queue_);
+			if (!res.has_value()) {
+				ErrorCode expected = ErrorCode::eSuccess;
+				error_.compare_exchange_strong(expected, res.error(), std::memory_order_acq_rel);
+			}
+			did_work = true;
+		}
+
+		while (!presents_.empty() && presents_.front()->value < next_value_) {
+			auto& packet = *presents_.front();
+
+			VkPresentInfoKHR pi = {
+				.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+				.waitSemaphoreCount = static_cast<u32>(packet.binary_waits.size()),
+				.pWaitSemaphores = packet.binary_waits.data(),
+				.swapchainCount = 1,
+				.pSwapchains = &packet.swapchain,
+				.pImageIndices = &packet.image_index,
+			};
+			auto res = scheduler_->present(queue_, pi);
+			packet.present_result.set_value(res);
+
+			presents_.pop_front();
+			did_work = true;
+		}
+
+		return did_work;
+	}
+}
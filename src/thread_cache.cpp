@@ -0,0 +1,26 @@
+#include <thread_cache.hpp>
+
+namespace gx {
+	namespace details {
+		ThreadCacheOwners& get_thread_cache_owners() noexcept {
+			// Outlives every thread_local cache, the main thread's caches are destroyed before statics
+			static ThreadCacheOwners owners;
+			return owners;
+		}
+
+		u64 register_thread_cache_owner(void* owner) noexcept {
+			auto& owners = get_thread_cache_owners();
+			u64 id = owners.next_id.fetch_add(1, std::memory_order_relaxed);
+
+			std::lock_guard lock{ owners.mutex };
+			owners.owners.emplace_back(id, owner);
+			return id;
+		}
+
+		void unregister_thread_cache_owner(u64 id) noexcept {
+			auto& owners = get_thread_cache_owners();
+			std::lock_guard lock{ owners.mutex };
+			std::erase_if(owners.owners, [id](const std::pair<u64, void*>& entry) { return entry.first == id; });
+		}
+	}
+}